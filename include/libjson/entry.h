@@ -16,15 +16,19 @@
  * @{
  */
 
+/**
+ * An entry of a JSON object.
+ *
+ * Entries of objects with a hash index keep the hash of their key, so that
+ * lookups can reject most other keys without reading their characters, and
+ * reindexing does not hash any key again.
+ */
 struct json_entry {
     /** @private */
-    struct json_entry *_next;
-
-    /** @private */
-    struct json_entry *_prev;
+    struct json_string _key;
 
     /** @private */
-    struct json_string _key;
+    json_uint _hash;
 
     /** @private */
     struct json_value _value;
@@ -21,6 +21,9 @@ enum json_errc {
     JSON_ERRC_MAX_DEPTH,
     JSON_ERRC_NUMBER_OUT_OF_RANGE,
     JSON_ERRC_DUPLICATE_KEY,
+    JSON_ERRC_CANCELLED,
+    JSON_ERRC_NOT_FOUND,
+    JSON_ERRC_IO_ERROR,
 };
 
 const char *json_errc_message(enum json_errc err);
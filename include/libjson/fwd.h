@@ -30,6 +30,20 @@ typedef size_t json_size;
 #define json_true ((json_bool)1)
 #define json_false ((json_bool)0)
 
+struct json_allocator;
+struct json_arena;
+struct json_array;
+struct json_entry;
+struct json_handler;
+struct json_line_handler;
+struct json_object;
+struct json_object_iter;
+struct json_pool;
+struct json_string;
+struct json_tape;
+struct json_value;
+struct json_visitor;
+
 /**
  * @}
  */
@@ -0,0 +1,78 @@
+/**
+ * @file libjson/handler.h
+ *
+ * JSON Event Handler
+ */
+#ifndef LIBJSON_HANDLER_H_
+#define LIBJSON_HANDLER_H_
+
+#include <libjson/errc.h>
+#include <libjson/fwd.h>
+
+/**
+ * @defgroup Handler Handler
+ * JSON Event Handler
+ * @{
+ */
+
+/**
+ * Callbacks invoked by `json_read_events` for each token of a document, in
+ * document order.
+ *
+ * Any callback may be `NULL`, in which case the token is skipped. A callback
+ * returning nonzero stops the read with `JSON_ERRC_CANCELLED`.
+ *
+ * String and key data is only valid for the duration of the callback; it
+ * points either into the input or into a buffer reused for the next string.
+ */
+struct json_handler {
+    int (*on_null)(struct json_handler *self);
+    int (*on_bool)(struct json_handler *self, json_bool value);
+    int (*on_int)(struct json_handler *self, json_int value);
+    int (*on_float)(struct json_handler *self, json_float value);
+    int (*on_string)(
+        struct json_handler *self, const char *data, json_size n);
+    int (*on_key)(struct json_handler *self, const char *data, json_size n);
+    int (*on_start_array)(struct json_handler *self);
+    int (*on_end_array)(struct json_handler *self);
+    int (*on_start_object)(struct json_handler *self);
+    int (*on_end_object)(struct json_handler *self);
+};
+
+/**
+ * Callbacks invoked by `json_read_lines` for each line of its input.
+ *
+ * Lines are numbered from zero, counting blank lines, which are otherwise
+ * skipped. A callback returning nonzero stops the read with
+ * `JSON_ERRC_CANCELLED`.
+ *
+ * Unless the lines are read in order, the callbacks are invoked from several
+ * threads at once, and once one of them stops the read, the other threads
+ * may still deliver the line each was reading.
+ */
+struct json_line_handler {
+    /**
+     * Receive the value read from a line.
+     *
+     * `value` is destructed once the callback returns; a handler that keeps
+     * it must move it elsewhere. Its allocator is that of the worker that
+     * read it.
+     */
+    int (*on_value)(
+        struct json_line_handler *self, json_size line,
+        struct json_value *value);
+
+    /**
+     * Receive the error of a line that could not be read.
+     *
+     * If `NULL`, the first such error stops the read and is returned.
+     */
+    int (*on_error)(
+        struct json_line_handler *self, json_size line, enum json_errc ec);
+};
+
+/**
+ * @}
+ */
+
+#endif
@@ -11,6 +11,7 @@
 #include <libjson/errc.h>
 #include <libjson/fwd.h>
 #include <libjson/memory.h>
+#include <libjson/string.h>
 
 /**
  * @defgroup IO Input/Output
@@ -95,6 +96,39 @@ struct json_read_options {
     json_bool accept_duplicate_keys;
 };
 
+/**
+ * Options for `json_read_lines`.
+ */
+struct json_read_lines_options {
+    /**
+     * Options for reading each line, or `NULL` for the defaults.
+     */
+    const struct json_read_options *read_options;
+
+    /**
+     * Number of workers, including the calling thread.
+     */
+    json_size threads;
+
+    /**
+     * Deliver lines in order.
+     *
+     * If set to `json_true`, the handler is invoked for one line at a time,
+     * in input order. Lines that are read ahead of their turn wait for the
+     * lines before them.
+     *
+     * If set to `json_false`, each line is delivered as soon as it is read,
+     * from the thread that read it.
+     */
+    json_bool ordered;
+
+    /**
+     * One allocator per worker, or `NULL` to use the default allocator for
+     * all of them. Each allocator is only used from a single thread.
+     */
+    struct json_allocator **allocators;
+};
+
 struct json_write_options {
     json_size indent_size;
 };
@@ -134,6 +168,12 @@ struct json_read_result json_read_bool(
     const char *first, const char *last, json_bool *value,
     const struct json_read_options *options);
 
+/**
+ * Read an integer.
+ *
+ * Integers that do not fit in a `json_int` are rejected with
+ * `JSON_ERRC_NUMBER_OUT_OF_RANGE`.
+ */
 struct json_read_result json_read_int(
     const char *first, const char *last, json_int *value,
     const struct json_read_options *options);
@@ -154,10 +194,229 @@ struct json_read_result json_read_object(
     const char *first, const char *last, struct json_object *value,
     const struct json_read_options *options);
 
+/**
+ * Read a value.
+ *
+ * A number with no fraction or exponent is read as an integer if it fits in a
+ * `json_int`, and `-0` as the integer zero. Integers outside that range are
+ * read as floats, rounded to the nearest double, as are all other numbers.
+ * The same holds for the numbers of tapes and events.
+ */
 struct json_read_result json_read_value(
     const char *first, const char *last, struct json_value *value,
     const struct json_read_options *options);
 
+/**
+ * Read a value, splitting a large top level array across threads.
+ *
+ * The elements of the top level array are divided into up to `threads` parts
+ * of at least a megabyte each, which are read concurrently and then joined.
+ * Input that is not such an array, is too small, or is read with comments
+ * enabled is read on the calling thread as by `json_read_value`.
+ *
+ * The allocator of `value` is used from every thread at once, so it must be
+ * thread safe.
+ *
+ * Errors are the same as for `json_read_value`.
+ */
+struct json_read_result json_read_value_parallel(
+    const char *first, const char *last, struct json_value *value,
+    const struct json_read_options *options, json_size threads);
+
+/**
+ * Read a buffer of newline delimited documents, one value per line.
+ *
+ * The lines are spread across `options->threads` workers, each reading into
+ * values made with its own allocator, and delivered to `handler`. Lines that
+ * hold nothing but whitespace are skipped.
+ *
+ * Errors:
+ * - `JSON_ERRC_NOT_ENOUGH_MEMORY`
+ * - `JSON_ERRC_CANCELLED`
+ * - The error of the first line that could not be read, if the handler has
+ *   no `on_error` callback.
+ */
+enum json_errc json_read_lines(
+    const char *first, const char *last, struct json_line_handler *handler,
+    const struct json_read_lines_options *options);
+
+/**
+ * Read a value from the file at `path`.
+ *
+ * The file is mapped into memory and read straight from the mapping instead
+ * of being copied into a buffer first. Anything but whitespace after the
+ * value is an error.
+ *
+ * Errors:
+ * - `JSON_ERRC_IO_ERROR`
+ * - The errors of `json_read_value`.
+ */
+enum json_errc json_read_file(
+    const char *path, struct json_value *value,
+    const struct json_read_options *options);
+
+/**
+ * Read a value from the open file descriptor `fd`, as by `json_read_file`.
+ *
+ * Regular files are mapped from their start; anything else, such as a pipe,
+ * is read to its end into a buffer. `fd` is not closed.
+ *
+ * Errors are the same as for `json_read_file`.
+ */
+enum json_errc json_read_fd(
+    int fd, struct json_value *value, const struct json_read_options *options);
+
+/**
+ * Read a value in situ, borrowing its strings from the input.
+ *
+ * Strings and object keys are unescaped in place and null terminated over
+ * their closing quotes instead of being copied, so the input is modified and
+ * must outlive `value`. Only strings with invalid code points that are to be
+ * replaced are still copied, as they may not fit in place.
+ *
+ * Errors are the same as for `json_read_value`. On failure, the input may
+ * have been partially modified.
+ */
+struct json_read_result json_read_value_insitu(
+    char *first, char *last, struct json_value *value,
+    const struct json_read_options *options);
+
+/**
+ * Read a value and report its tokens to `handler` instead of building it.
+ *
+ * No values, arrays or objects are created; strings without escapes are
+ * passed to the handler straight from the input. Since no objects are built,
+ * duplicate keys are not detected.
+ *
+ * Errors:
+ * - `JSON_ERRC_NOT_ENOUGH_MEMORY`
+ * - `JSON_ERRC_UNEXPECTED_TOKEN`
+ * - `JSON_ERRC_INVALID_ESCAPE`
+ * - `JSON_ERRC_INVALID_ENCODING`
+ * - `JSON_ERRC_MAX_DEPTH`
+ * - `JSON_ERRC_NUMBER_OUT_OF_RANGE`
+ * - `JSON_ERRC_CANCELLED`
+ */
+struct json_read_result json_read_events(
+    const char *first, const char *last, struct json_handler *handler,
+    const struct json_read_options *options);
+
+/**
+ * Read a value into a tape instead of a tree.
+ *
+ * The previous contents of `tape` are discarded, but its storage is reused.
+ * As with `json_read_events`, duplicate keys are not detected; lookups on the
+ * tape find the first entry with a key.
+ *
+ * Inputs of 4KB or more without comments are read in two stages: a SIMD pass
+ * finds every token start, and the tape is then built by stepping from one
+ * token start to the next.
+ *
+ * Errors:
+ * - `JSON_ERRC_NOT_ENOUGH_MEMORY`
+ * - `JSON_ERRC_UNEXPECTED_TOKEN`
+ * - `JSON_ERRC_INVALID_ESCAPE`
+ * - `JSON_ERRC_INVALID_ENCODING`
+ * - `JSON_ERRC_MAX_DEPTH`
+ * - `JSON_ERRC_NUMBER_OUT_OF_RANGE`
+ */
+struct json_read_result json_read_tape(
+    const char *first, const char *last, struct json_tape *tape,
+    const struct json_read_options *options);
+
+/**
+ * Incremental parser for input that arrives in chunks.
+ *
+ * The parser builds a value from a sequence of `json_parser_feed` calls and
+ * keeps its position in the document between them. Tokens are read straight
+ * from each chunk; only a token that is split between two chunks is copied,
+ * so the document never has to be held in one buffer.
+ */
+struct json_parser {
+    /** @private */
+    struct json_read_options _options;
+
+    /** @private */
+    struct json_value *_root;
+
+    /** @private */
+    struct json_value **_stack;
+
+    /** @private */
+    json_size _depth;
+
+    /** @private */
+    json_size _stack_capacity;
+
+    /** @private */
+    struct json_string _key;
+
+    /** @private */
+    char *_token;
+
+    /** @private */
+    json_size _token_size;
+
+    /** @private */
+    json_size _token_capacity;
+
+    /** @private */
+    struct json_allocator *_alloc;
+
+    /** @private */
+    enum json_errc _ec;
+
+    /** @private */
+    unsigned char _state;
+
+    /** @private */
+    unsigned char _token_kind;
+
+    /** @private */
+    unsigned char _comment;
+
+    /** @private */
+    json_bool _escape;
+};
+
+/**
+ * Construct a parser that reads into `value`.
+ *
+ * `value` must outlive the parser. Its allocator is used for the parser's
+ * own state as well as for the values it creates.
+ */
+void json_parser_construct(
+    struct json_parser *parser, struct json_value *value,
+    const struct json_read_options *options);
+
+void json_parser_destruct(struct json_parser *parser);
+
+/**
+ * Parse the next `n` bytes of the document.
+ *
+ * The chunk does not have to be kept alive after the call returns. Once an
+ * error has been returned, every later call returns the same error.
+ *
+ * Errors:
+ * - `JSON_ERRC_NOT_ENOUGH_MEMORY`
+ * - `JSON_ERRC_UNEXPECTED_TOKEN`
+ * - `JSON_ERRC_INVALID_ESCAPE`
+ * - `JSON_ERRC_INVALID_ENCODING`
+ * - `JSON_ERRC_MAX_DEPTH`
+ * - `JSON_ERRC_NUMBER_OUT_OF_RANGE`
+ * - `JSON_ERRC_DUPLICATE_KEY`
+ */
+enum json_errc json_parser_feed(
+    struct json_parser *parser, const char *chunk, json_size n);
+
+/**
+ * Signal the end of the document.
+ *
+ * Completes a number or literal at the end of the last chunk, and fails with
+ * `JSON_ERRC_UNEXPECTED_TOKEN` if the document is incomplete.
+ */
+enum json_errc json_parser_finish(struct json_parser *parser);
+
 struct json_write_result json_write_null(
     char *first, char *last, const struct json_write_options *options);
 
@@ -24,6 +24,18 @@ struct json_allocator_methods {
 
     json_bool (*is_equal)(
         const struct json_allocator *self, const struct json_allocator *other);
+
+    /**
+     * Resize the block at `p` from `old_bytes` to `new_bytes`, in place if
+     * possible, keeping its contents up to the smaller size. Returns `NULL`
+     * on failure, leaving the block untouched.
+     *
+     * Optional: allocators without it are resized by allocating a new block
+     * and copying.
+     */
+    void *(*reallocate)(struct json_allocator *self, void *p,
+                        json_size old_bytes, json_size new_bytes,
+                        json_size alignment);
 };
 
 struct json_allocator {
@@ -43,6 +55,16 @@ void json_allocator_deallocate(struct json_allocator *alloc, void *p,
 json_bool json_allocator_is_equal(
     const struct json_allocator *a, const struct json_allocator *b);
 
+/**
+ * Resize a block, as by the `reallocate` method of the allocator or, if it has
+ * none, by allocating a new block, copying and deallocating the old one.
+ *
+ * Returns `NULL` on failure, leaving the block untouched.
+ */
+void *json_allocator_reallocate(
+    struct json_allocator *alloc, void *p, json_size old_bytes,
+    json_size new_bytes, json_size alignment);
+
 const struct json_allocator_methods *json_allocator_get_methods(
     const struct json_allocator *alloc);
 
@@ -55,6 +77,126 @@ struct json_allocator *json_get_default_allocator(void);
 struct json_allocator *json_set_default_allocator(
     struct json_allocator *new_default);
 
+/**
+ * A monotonic allocator handing out memory from a list of chunks.
+ *
+ * Allocation bumps a pointer into the current chunk; when it is full, a new
+ * chunk twice the size of the previous one is taken from the upstream
+ * allocator. Deallocation does nothing, except that the most recent
+ * allocation is given back so that it can be grown in place. Reallocating
+ * the most recent allocation resizes it in place while the chunk has room.
+ * Memory is only returned by `json_arena_reset` and `json_arena_destruct`.
+ *
+ * Since deallocation does nothing, values made with an arena need not be
+ * destructed: resetting the arena disposes of all of them at once.
+ *
+ * An arena is not thread safe.
+ */
+struct json_arena {
+    /** @private */
+    struct json_allocator _base;
+
+    /** @private */
+    struct json_allocator *_upstream;
+
+    /** @private */
+    struct json_arena_chunk *_chunks;
+
+    /** @private */
+    char *_ptr;
+
+    /** @private */
+    char *_end;
+
+    /** @private */
+    json_size _chunk_size;
+};
+
+/**
+ * Construct an arena without allocating.
+ *
+ * @param arena Arena to initialize.
+ * @param chunk_size Size of the first chunk, or zero for a default.
+ * @param upstream Allocator chunks are taken from. If `NULL`, the default
+ * allocator is used.
+ */
+void json_arena_construct(
+    struct json_arena *arena, json_size chunk_size,
+    struct json_allocator *upstream);
+
+/**
+ * Return every chunk to the upstream allocator.
+ */
+void json_arena_destruct(struct json_arena *arena);
+
+/**
+ * Release everything allocated from an arena at once.
+ *
+ * Only the most recent chunk, which is also the largest, is kept for reuse.
+ */
+void json_arena_reset(struct json_arena *arena);
+
+/**
+ * Get the allocator interface of an arena.
+ */
+struct json_allocator *json_arena_allocator(struct json_arena *arena);
+
+/**
+ * Number of size classes of a pool.
+ */
+#define JSON_POOL_CLASS_COUNT 16
+
+/**
+ * An allocator recycling small blocks through per size free lists.
+ *
+ * Requests of up to `16 * JSON_POOL_CLASS_COUNT` bytes are rounded up to a
+ * multiple of 16 and served from the free list of that size, which covers
+ * every node of a document. An empty list is refilled all at once by
+ * carving up a new slab taken from the upstream allocator. Freed blocks go
+ * back on their list for reuse, so a document that is modified constantly
+ * does not fragment the heap. Larger or over-aligned requests are passed
+ * through to the upstream allocator.
+ *
+ * Slabs are only returned by `json_pool_destruct`. A pool is not thread
+ * safe.
+ */
+struct json_pool {
+    /** @private */
+    struct json_allocator _base;
+
+    /** @private */
+    struct json_allocator *_upstream;
+
+    /** @private */
+    struct json_pool_block *_free[JSON_POOL_CLASS_COUNT];
+
+    /** @private */
+    struct json_pool_slab *_slabs;
+};
+
+/**
+ * Construct a pool without allocating.
+ *
+ * @param pool Pool to initialize.
+ * @param upstream Allocator slabs and large blocks are taken from. If `NULL`,
+ * the default allocator is used.
+ */
+void json_pool_construct(
+    struct json_pool *pool, struct json_allocator *upstream);
+
+/**
+ * Return every slab to the upstream allocator.
+ *
+ * Large blocks passed through to the upstream allocator must have been
+ * deallocated already.
+ */
+void json_pool_destruct(struct json_pool *pool);
+
+/**
+ * Get the allocator interface of a pool.
+ */
+struct json_allocator *json_pool_allocator(struct json_pool *pool);
+
 /**
  * @}
  */
@@ -6,6 +6,9 @@
 #ifndef LIBJSON_OBJECT_H_
 #define LIBJSON_OBJECT_H_
 
+#include <stdatomic.h>
+#include <stdint.h>
+#include <libjson/errc.h>
 #include <libjson/fwd.h>
 #include <libjson/memory.h>
 
@@ -17,21 +20,80 @@
 
 /**
  * Represents a JSON object.
+ *
+ * Entries are kept in insertion order, which is what iteration walks. The
+ * first eight are kept in one array, and later ones in segments that double
+ * in size, so growing an object never moves its other entries. Keys are found
+ * through a separate open addressing hash index holding the position of each
+ * entry. Each slot of the index has a control byte holding seven bits of the
+ * hash of its key, and lookups compare a whole group of control bytes at once
+ * before looking at any key.
+ *
+ * Objects with up to eight entries have no hash index, and find keys by a
+ * linear scan of their entries.
+ *
+ * Keys are hashed with wyhash under a seed chosen at random once per process.
+ * Building the library with `LIBJSON_SIPHASH=1`, which defines `JSON_SIPHASH`,
+ * selects SipHash-2-4 instead; the choice is made at compile time only.
  */
 struct json_object {
     /** @private */
     json_size _size;
 
     /** @private */
-    json_size _bucket_count;
+    json_size _capacity;
+
+    /** @private */
+    struct json_entry *_entries;
+
+    /** @private */
+    struct json_entry **_segments;
 
     /** @private */
-    struct json_bucket *_buckets;
+    uint32_t *_index;
+
+    /** @private */
+    unsigned char *_ctrl;
+
+    /** @private */
+    struct json_object_rehash *_rehash;
+
+    /** @private */
+    json_bool _incremental;
 
     /** @private */
     struct json_allocator *_alloc;
 };
 
+/**
+ * An object key that keeps its hash, so that looking it up again does not
+ * hash it again.
+ *
+ * The characters are borrowed, and must outlive the key. Keys are hashed with
+ * a seed chosen at run time, so a key made by `JSON_KEY` cannot be hashed
+ * ahead of time; it is hashed by its first lookup instead, and keeps the
+ * hash from then on.
+ */
+struct json_key {
+    /** @private */
+    const char *_data;
+
+    /** @private */
+    json_size _size;
+
+    /** @private */
+    _Atomic json_uint _hash;
+};
+
+/**
+ * Initializer for a `json_key` naming a string literal, as in
+ * `static struct json_key name = JSON_KEY("name");`.
+ */
+#define JSON_KEY(literal)                                                     \
+    {                                                                         \
+        ._data = "" literal, ._size = sizeof(literal) - 1, ._hash = 0         \
+    }
+
 struct json_object_iter {
     /** @private */
     struct json_object *_object;
@@ -77,7 +139,28 @@ json_size json_object_size(const struct json_object *object);
 
 void json_object_clear(struct json_object *object);
 
-enum json_errc json_object_reserve(json_size n);
+/**
+ * Make room for at least `n` entries, so that inserting up to that many does
+ * not grow the object.
+ *
+ * Errors:
+ * - `JSON_ERRC_NOT_ENOUGH_MEMORY`
+ */
+enum json_errc json_object_reserve(struct json_object *object, json_size n);
+
+/**
+ * Choose how the hash index of an object is rebuilt when it grows.
+ *
+ * By default every entry is reindexed at once. With incremental rehashing,
+ * the previous index is kept and its entries are moved into the new one a
+ * few at a time by the insertions that follow, so no single insertion pays
+ * for reindexing a large object. Lookups check both indices in the meantime.
+ * The entries themselves are still copied when the object grows.
+ *
+ * Turning incremental rehashing off finishes any rehash in progress.
+ */
+void json_object_set_incremental_rehash(
+    struct json_object *object, json_bool incremental);
 
 void json_object_swap(struct json_object *a, struct json_object *b);
 
@@ -90,62 +173,123 @@ struct json_value *json_object_at(
 void json_object_find(struct json_object *object, const char *key, json_size n,
                       struct json_object_iter *iter);
 
-json_bool json_object_insert_copy(
+/**
+ * Construct a key borrowing the `n` characters at `data`, and hash it.
+ */
+void json_key_construct(struct json_key *key, const char *data, json_size n);
+
+/**
+ * Find the entry with `key`, as by `json_object_find`, reusing the hash kept
+ * by `key`. Keys are compared by their characters, so any object can be
+ * searched with the same key.
+ */
+void json_object_find_key(
+    struct json_object *object, struct json_key *key,
+    struct json_object_iter *iter);
+
+/**
+ * Value of the entry with `key`, or `NULL` if there is none, as by
+ * `json_object_at`.
+ */
+struct json_value *json_object_at_key(
+    struct json_object *object, struct json_key *key);
+
+/**
+ * Look up `n` keys at once, setting `values[i]` to the value of the entry with
+ * `keys[i]`, or to `NULL` if there is none.
+ *
+ * Keys are hashed and the memory their lookups touch is prefetched a batch at
+ * a time before any of them is compared, so the cache misses of the lookups
+ * overlap. This is faster than finding the keys one by one when extracting
+ * several fields from a large object.
+ *
+ * Returns the number of keys found.
+ */
+json_size json_object_find_many(
+    struct json_object *object, struct json_key *keys, json_size n,
+    struct json_value **values);
+
+/**
+ * Insert an entry for a copy of the `n` characters at `key`, with a copy of
+ * `value`, or with `value` itself, moved, by `json_object_insert_move`.
+ *
+ * If the object already has an entry with an equal key, nothing is inserted.
+ * Either way, `it` is set to the entry with the key unless it is `NULL`. A
+ * value that cannot be copied leaves the new entry null.
+ *
+ * Errors:
+ * - `JSON_ERRC_NOT_ENOUGH_MEMORY`
+ * - `JSON_ERRC_DUPLICATE_KEY`
+ */
+enum json_errc json_object_insert_copy(
     struct json_object *object, const char *key, json_size n,
     const struct json_value *value, struct json_object_iter *it);
 
-json_bool json_object_insert_move(
+enum json_errc json_object_insert_move(
     struct json_object *object, const char *key, json_size n,
     struct json_value *value, struct json_object_iter *it);
 
-json_bool json_object_emplace(struct json_object *object, const char *key,
-                              json_size n, struct json_allocator *alloc);
+/**
+ * Insert an entry for a copy of the `n` characters at `key`, with a value made
+ * in place by `alloc`, or by the allocator of the object if `NULL`.
+ *
+ * The value is null for `json_object_emplace`, and made as by the matching
+ * `json_value_construct` function for the others. If the object already has
+ * an entry with an equal key, nothing is inserted.
+ *
+ * Errors:
+ * - `JSON_ERRC_NOT_ENOUGH_MEMORY`
+ * - `JSON_ERRC_DUPLICATE_KEY`
+ */
+enum json_errc json_object_emplace(
+    struct json_object *object, const char *key, json_size n,
+    struct json_allocator *alloc);
 
-json_bool json_object_emplace_null(
+enum json_errc json_object_emplace_null(
     struct json_object *object, const char *key, json_size n,
     struct json_allocator *alloc);
 
-json_bool json_object_emplace_bool(
+enum json_errc json_object_emplace_bool(
     struct json_object *object, const char *key, json_size n, json_bool value,
     struct json_allocator *alloc);
 
-json_bool json_object_emplace_int(
+enum json_errc json_object_emplace_int(
     struct json_object *object, const char *key, json_size n, json_int value,
     struct json_allocator *alloc);
 
-json_bool json_object_emplace_float(
+enum json_errc json_object_emplace_float(
     struct json_object *object, const char *key, json_size n, json_float value,
     struct json_allocator *alloc);
 
-json_bool json_object_emplace_string_copy(
+enum json_errc json_object_emplace_string_copy(
     struct json_object *object, const char *key, json_size n,
     const struct json_string *value, struct json_allocator *alloc);
 
-json_bool json_object_emplace_string_move(
+enum json_errc json_object_emplace_string_move(
     struct json_object *object, const char *key, json_size n,
     struct json_string *value, struct json_allocator *alloc);
 
-json_bool json_object_emplace_array_copy(
+enum json_errc json_object_emplace_array_copy(
     struct json_object *object, const char *key, json_size n,
     const struct json_array *value, struct json_allocator *alloc);
 
-json_bool json_object_emplace_array_move(
+enum json_errc json_object_emplace_array_move(
     struct json_object *object, const char *key, json_size n,
     struct json_array *value, struct json_allocator *alloc);
 
-json_bool json_object_emplace_object_copy(
+enum json_errc json_object_emplace_object_copy(
     struct json_object *object, const char *key, json_size n,
     const struct json_object *value, struct json_allocator *alloc);
 
-json_bool json_object_emplace_object_move(
+enum json_errc json_object_emplace_object_move(
     struct json_object *object, const char *key, json_size n,
     struct json_object *value, struct json_allocator *alloc);
 
-json_bool json_object_emplace_copy(
+enum json_errc json_object_emplace_copy(
     struct json_object *object, const char *key, json_size n,
     const struct json_value *value, struct json_allocator *alloc);
 
-json_bool json_object_emplace_move(
+enum json_errc json_object_emplace_move(
     struct json_object *object, const char *key, json_size n,
     struct json_value *value, struct json_allocator *alloc);
 
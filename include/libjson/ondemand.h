@@ -0,0 +1,224 @@
+/**
+ * @file libjson/ondemand.h
+ *
+ * JSON On-Demand Reader
+ */
+#ifndef LIBJSON_ONDEMAND_H_
+#define LIBJSON_ONDEMAND_H_
+
+#include <libjson/errc.h>
+#include <libjson/fwd.h>
+#include <libjson/io.h>
+#include <libjson/string.h>
+#include <libjson/type.h>
+
+/**
+ * @defgroup OnDemand On-Demand
+ * Lazy reading of a document in place.
+ * @{
+ */
+
+/**
+ * A document read lazily from a buffer.
+ *
+ * Nothing is parsed up front: values are read only when the caller asks for
+ * them, and everything passed over on the way is skipped by matching brackets
+ * without building or validating it. The input must outlive the document and
+ * every value taken from it.
+ *
+ * Since skipped values are not validated, a malformed document may go
+ * unnoticed as long as its malformed parts are never read.
+ */
+struct json_ondemand {
+    /** @private */
+    const char *_first;
+
+    /** @private */
+    const char *_last;
+
+    /** @private */
+    struct json_read_options _options;
+
+    /** @private */
+    struct json_string _string;
+
+    /** @private */
+    struct json_string _key;
+};
+
+/**
+ * A value of an on-demand document.
+ *
+ * A value is only a position in the input, so it may be copied freely and
+ * read any number of times.
+ */
+struct json_ondemand_value {
+    /** @private */
+    struct json_ondemand *_doc;
+
+    /** @private */
+    const char *_ptr;
+};
+
+/**
+ * Iterator over the elements of an on-demand array or object.
+ */
+struct json_ondemand_iter {
+    /** @private */
+    struct json_ondemand *_doc;
+
+    /** @private */
+    const char *_ptr;
+
+    /** @private */
+    const char *_element;
+
+    /** @private */
+    char _close;
+};
+
+/**
+ * Construct a document over `[first, last)`.
+ *
+ * `alloc` is only used for strings that have to be unescaped.
+ */
+void json_ondemand_construct(
+    struct json_ondemand *doc, const char *first, const char *last,
+    const struct json_read_options *options, struct json_allocator *alloc);
+
+void json_ondemand_destruct(struct json_ondemand *doc);
+
+/**
+ * Get the top level value of the document.
+ *
+ * Errors:
+ * - `JSON_ERRC_UNEXPECTED_TOKEN`
+ */
+enum json_errc json_ondemand_root(
+    struct json_ondemand *doc, struct json_ondemand_value *value);
+
+/**
+ * Get the type of a value from its first character.
+ *
+ * Numbers with a fraction or exponent are `JSON_TYPE_FLOAT`, all others
+ * `JSON_TYPE_INT`. The value itself is not validated.
+ */
+enum json_errc json_ondemand_get_type(
+    const struct json_ondemand_value *value, enum json_type *type);
+
+json_bool json_ondemand_is_null(const struct json_ondemand_value *value);
+
+/**
+ * Errors:
+ * - `JSON_ERRC_UNEXPECTED_TOKEN`
+ */
+enum json_errc json_ondemand_get_bool(
+    const struct json_ondemand_value *value, json_bool *out);
+
+/**
+ * Read an integer value. Numbers with a fraction or exponent are rejected.
+ *
+ * Errors:
+ * - `JSON_ERRC_UNEXPECTED_TOKEN`
+ * - `JSON_ERRC_NUMBER_OUT_OF_RANGE`
+ */
+enum json_errc json_ondemand_get_int(
+    const struct json_ondemand_value *value, json_int *out);
+
+/**
+ * Read any number value as a float.
+ *
+ * Errors:
+ * - `JSON_ERRC_UNEXPECTED_TOKEN`
+ * - `JSON_ERRC_NUMBER_OUT_OF_RANGE`
+ */
+enum json_errc json_ondemand_get_float(
+    const struct json_ondemand_value *value, json_float *out);
+
+/**
+ * Read a string value.
+ *
+ * Strings without escapes are returned straight from the input. Others are
+ * unescaped into a buffer of the document, which is only valid until the next
+ * call to `json_ondemand_get_string`.
+ *
+ * Errors:
+ * - `JSON_ERRC_NOT_ENOUGH_MEMORY`
+ * - `JSON_ERRC_UNEXPECTED_TOKEN`
+ * - `JSON_ERRC_INVALID_ESCAPE`
+ * - `JSON_ERRC_INVALID_ENCODING`
+ */
+enum json_errc json_ondemand_get_string(
+    const struct json_ondemand_value *value, const char **data, json_size *n);
+
+/**
+ * Find the value of the first entry with key `[key, key + n)` in an object.
+ *
+ * Entries are scanned from the start of the object, and the values of
+ * entries before the match are skipped.
+ *
+ * Errors:
+ * - `JSON_ERRC_NOT_ENOUGH_MEMORY`
+ * - `JSON_ERRC_UNEXPECTED_TOKEN`
+ * - `JSON_ERRC_INVALID_ESCAPE`
+ * - `JSON_ERRC_INVALID_ENCODING`
+ * - `JSON_ERRC_MAX_DEPTH`
+ * - `JSON_ERRC_NOT_FOUND`
+ */
+enum json_errc json_ondemand_find_field(
+    const struct json_ondemand_value *object, const char *key, json_size n,
+    struct json_ondemand_value *out);
+
+/**
+ * Start iterating over the elements of an array.
+ *
+ * Errors:
+ * - `JSON_ERRC_UNEXPECTED_TOKEN`
+ */
+enum json_errc json_ondemand_array_begin(
+    const struct json_ondemand_value *array, struct json_ondemand_iter *iter);
+
+/**
+ * Get the next element of an array, skipping the previous one. Sets `*done`
+ * instead once the end of the array is reached.
+ *
+ * Errors:
+ * - `JSON_ERRC_UNEXPECTED_TOKEN`
+ * - `JSON_ERRC_MAX_DEPTH`
+ */
+enum json_errc json_ondemand_array_next(
+    struct json_ondemand_iter *iter, struct json_ondemand_value *element,
+    json_bool *done);
+
+/**
+ * Start iterating over the entries of an object.
+ *
+ * Errors:
+ * - `JSON_ERRC_UNEXPECTED_TOKEN`
+ */
+enum json_errc json_ondemand_object_begin(
+    const struct json_ondemand_value *object, struct json_ondemand_iter *iter);
+
+/**
+ * Get the key and value of the next entry of an object, skipping the
+ * previous value. Sets `*done` instead once the end of the object is reached.
+ *
+ * Keys with escapes are unescaped into a buffer of the document, which is
+ * only valid until the next key is read.
+ *
+ * Errors:
+ * - `JSON_ERRC_NOT_ENOUGH_MEMORY`
+ * - `JSON_ERRC_UNEXPECTED_TOKEN`
+ * - `JSON_ERRC_INVALID_ESCAPE`
+ * - `JSON_ERRC_INVALID_ENCODING`
+ * - `JSON_ERRC_MAX_DEPTH`
+ */
+enum json_errc json_ondemand_object_next(
+    struct json_ondemand_iter *iter, const char **key, json_size *n,
+    struct json_ondemand_value *value, json_bool *done);
+
+/**
+ * @}
+ */
+
+#endif
@@ -15,21 +15,50 @@
  * @{
  */
 
+/**
+ * Number of characters, not counting the null terminator, that a string
+ * stores inline without allocating: those that fit where the pointer, size
+ * and capacity of a longer string go, less the null terminator and a byte
+ * holding the size. That is 22 on 64-bit targets.
+ */
+#define JSON_STRING_INLINE_CAPACITY \
+    (sizeof(char *) + 2 * sizeof(json_size) - 2)
+
 /**
  * Represents a JSON string.
  *
  * The data is always null terminated.
+ *
+ * A string either owns its characters, or borrows them from a buffer that
+ * outlives it, such as the input of `json_read_value_insitu`. A borrowed
+ * string has no capacity, so any change in size copies it into storage of its
+ * own first.
+ *
+ * Strings of up to `JSON_STRING_INLINE_CAPACITY` characters that are not
+ * borrowed are stored inside the string itself, without allocating. Pointers
+ * to their characters are only valid for as long as the string is not moved,
+ * which includes an object holding it as a key growing.
  */
 struct json_string {
     /** @private */
     struct json_allocator *_alloc;
 
-    /** @private */
-    struct json_string_impl {
-        json_size _size;
-        json_size _capacity;
-        char _data[];
-    } *_impl;
+    /**
+     * @private
+     *
+     * The last byte of `_inline` holds the size of an inline string with its
+     * high bit set, and overlaps the last byte of `_heap._capacity`, which
+     * is zero.
+     */
+    union {
+        struct {
+            char *_data;
+            json_size _size;
+            json_size _capacity;
+        } _heap;
+
+        char _inline[JSON_STRING_INLINE_CAPACITY + 2];
+    };
 };
 
 /**
@@ -59,6 +88,23 @@ enum json_errc json_string_construct_move(
     struct json_string *string, struct json_string *other,
     struct json_allocator *alloc);
 
+/**
+ * Construct a string that borrows `[data, data + n)` instead of copying it.
+ *
+ * `data[n]` must be a null character, and the characters must outlive the
+ * string and every string it is moved to. Changes that do not grow the
+ * string modify the borrowed characters in place.
+ *
+ * @param string String to initialize.
+ * @param data Characters to borrow.
+ * @param n Number of characters, not including the null terminator.
+ * @param alloc Allocator used if the string is grown. If `NULL`, the default
+ * allocator is used.
+ */
+void json_string_construct_borrow(
+    struct json_string *string, char *data, json_size n,
+    struct json_allocator *alloc);
+
 /**
  * Destruct string.
  *
@@ -157,6 +203,25 @@ void json_string_clear(struct json_string *string);
  */
 enum json_errc json_string_reserve(struct json_string *string, json_size n);
 
+/**
+ * Reserve space for appending.
+ *
+ * Makes room for at least `count` characters past the end of the string.
+ * Unlike `json_string_reserve`, which allocates exactly what is asked for, the
+ * capacity grows by at least half whenever it grows, so appending to a string
+ * piece by piece copies it a bounded number of times overall.
+ *
+ * `json_string_push_back` and `json_string_append` grow strings this way.
+ *
+ * Errors:
+ * - `JSON_ERRC_NOT_ENOUGH_MEMORY`
+ *
+ * @param string
+ * @param count The number of characters about to be appended.
+ */
+enum json_errc json_string_append_reserve(
+    struct json_string *string, json_size count);
+
 /**
  * Resize string.
  *
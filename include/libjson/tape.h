@@ -0,0 +1,173 @@
+/**
+ * @file libjson/tape.h
+ *
+ * JSON Tape
+ */
+#ifndef LIBJSON_TAPE_H_
+#define LIBJSON_TAPE_H_
+
+#include <libjson/fwd.h>
+#include <libjson/memory.h>
+#include <libjson/type.h>
+
+/**
+ * @defgroup Tape Tape
+ * Compact read-only document representation.
+ * @{
+ */
+
+/**
+ * A read-only document stored as a flat sequence of 64-bit words.
+ *
+ * Each value is a tagged word in document order, followed by its payload for
+ * numbers and strings. Arrays and objects are bracketed by a start and an end
+ * word linked to each other, so a whole subtree is skipped in one step. The
+ * characters of all strings are kept together in a separate buffer.
+ *
+ * A tape is filled by `json_read_tape` and read through cursors. Both buffers
+ * are sized from the length of the input before reading it: the string
+ * buffer to a bound it cannot outgrow, and the words to half a word per byte
+ * of input, which only documents dense with small values outgrow. They are
+ * kept when the tape is read into again.
+ */
+struct json_tape {
+    /** @private */
+    json_uint *_words;
+
+    /** @private */
+    json_size _size;
+
+    /** @private */
+    json_size _capacity;
+
+    /** @private */
+    char *_strings;
+
+    /** @private */
+    json_size _strings_size;
+
+    /** @private */
+    json_size _strings_capacity;
+
+    /** @private */
+    struct json_allocator *_alloc;
+};
+
+/**
+ * A position of a value on a tape.
+ *
+ * A cursor is only valid while the tape is neither destructed nor read into
+ * again.
+ */
+struct json_tape_cursor {
+    /** @private */
+    const struct json_tape *_tape;
+
+    /** @private */
+    json_size _index;
+};
+
+/**
+ * Iterator over the elements of an array or the entries of an object.
+ */
+struct json_tape_iter {
+    /** @private */
+    const struct json_tape *_tape;
+
+    /** @private */
+    json_size _index;
+};
+
+/**
+ * Construct an empty tape.
+ *
+ * @param tape Tape to initialize.
+ * @param alloc Allocator to use. If `NULL`, the default allocator is used.
+ */
+void json_tape_construct(struct json_tape *tape, struct json_allocator *alloc);
+
+void json_tape_destruct(struct json_tape *tape);
+
+/**
+ * Remove all values, keeping the storage for the next read.
+ */
+void json_tape_clear(struct json_tape *tape);
+
+json_bool json_tape_empty(const struct json_tape *tape);
+
+/**
+ * Get a cursor to the top level value.
+ *
+ * The behavior of this operation is undefined if the tape is empty.
+ */
+void json_tape_root(
+    const struct json_tape *tape, struct json_tape_cursor *cursor);
+
+enum json_type json_tape_get_type(const struct json_tape_cursor *cursor);
+
+/**
+ * The behavior of the `json_tape_get` operations is undefined if the value
+ * is not of the type read, except that integers may be read as floats.
+ */
+json_bool json_tape_get_bool(const struct json_tape_cursor *cursor);
+
+json_int json_tape_get_int(const struct json_tape_cursor *cursor);
+
+json_float json_tape_get_float(const struct json_tape_cursor *cursor);
+
+/**
+ * Get the characters of a string value.
+ *
+ * The characters are null terminated and owned by the tape.
+ */
+const char *json_tape_get_string(
+    const struct json_tape_cursor *cursor, json_size *n);
+
+/**
+ * Get the number of elements of an array or entries of an object.
+ *
+ * This steps over every element, skipping their subtrees.
+ */
+json_size json_tape_size(const struct json_tape_cursor *cursor);
+
+/**
+ * Start iterating over the elements of an array.
+ */
+void json_tape_array_begin(
+    const struct json_tape_cursor *array, struct json_tape_iter *iter);
+
+/**
+ * Get the next element of an array. Returns `json_false` once the end of the
+ * array is reached.
+ */
+json_bool json_tape_array_next(
+    struct json_tape_iter *iter, struct json_tape_cursor *element);
+
+/**
+ * Start iterating over the entries of an object.
+ */
+void json_tape_object_begin(
+    const struct json_tape_cursor *object, struct json_tape_iter *iter);
+
+/**
+ * Get the key and value of the next entry of an object. Returns `json_false`
+ * once the end of the object is reached.
+ */
+json_bool json_tape_object_next(
+    struct json_tape_iter *iter, const char **key, json_size *n,
+    struct json_tape_cursor *value);
+
+/**
+ * Find the value of the first entry with key `[key, key + n)` in an object.
+ *
+ * Returns `json_false` if there is none.
+ */
+json_bool json_tape_find_field(
+    const struct json_tape_cursor *object, const char *key, json_size n,
+    struct json_tape_cursor *out);
+
+/**
+ * @}
+ */
+
+#endif
@@ -1,8 +1,28 @@
+#include <string.h>
 #include <libjson/array.h>
 #include <libjson/errc.h>
 #include <libjson/fwd.h>
 #include "./util.h"
 
+static inline void json_memcpy_values(
+    struct json_value *dest, const struct json_value *src, json_size n)
+{
+    if (n) {
+        memcpy(dest, src, n * sizeof(*dest));
+    }
+}
+
+// Reserve room for one more element, doubling the capacity when full.
+static enum json_errc json_array_grow(struct json_array *array)
+{
+    if (array->_size < array->_capacity) {
+        return JSON_ERRC_OK;
+    }
+
+    return json_array_reserve(
+        array, array->_capacity ? 2 * array->_capacity : 4);
+}
+
 void json_array_construct(
     struct json_array *array, struct json_allocator *alloc)
 {
@@ -34,6 +54,8 @@ enum json_errc json_array_construct_copy(
     } else {
         array->_data = NULL;
     }
+
+    return JSON_ERRC_OK;
 }
 
 enum json_errc json_array_construct_move(
@@ -54,6 +76,8 @@ enum json_errc json_array_construct_move(
     other->_data = NULL;
     other->_size = 0;
     other->_capacity = 0;
+
+    return JSON_ERRC_OK;
 }
 
 void json_array_destruct(struct json_array *array)
@@ -79,6 +103,7 @@ enum json_errc json_array_assign_copy(
     }
 
     array->_size = other->_size;
+    return JSON_ERRC_OK;
 }
 
 enum json_errc json_array_assign_move(
@@ -95,6 +120,7 @@ enum json_errc json_array_assign_move(
     }
 
     array->_size = other->_size;
+    return JSON_ERRC_OK;
 }
 
 struct json_allocator *json_array_get_allocator(const struct json_array *array)
@@ -136,7 +162,7 @@ enum json_errc json_array_push_back_copy(
 {
     enum json_errc ec;
 
-    if ((ec = json_array_reserve(array, array->_size + 1)) ||
+    if ((ec = json_array_grow(array)) ||
         (ec = json_value_construct_copy(
              array->_data + array->_size, value, array->_alloc))) {
         return ec;
@@ -151,7 +177,7 @@ enum json_errc json_array_push_back_move(
 {
     enum json_errc ec;
 
-    if ((ec = json_array_reserve(array, array->_size + 1)) ||
+    if ((ec = json_array_grow(array)) ||
         (ec = json_value_construct_move(
              array->_data + array->_size, value, array->_alloc))) {
         return ec;
@@ -166,7 +192,7 @@ enum json_errc json_array_emplace_back(
 {
     enum json_errc ec;
 
-    if ((ec = json_array_reserve(array, array->_size + 1))) {
+    if ((ec = json_array_grow(array))) {
         return ec;
     }
 
@@ -183,7 +209,7 @@ enum json_errc json_array_emplace_back_null(
 enum json_errc json_array_emplace_back_bool(
     struct json_array *array, json_bool value, struct json_allocator *alloc)
 {
-    if (json_array_reserve(array, array->_size + 1)) {
+    if (json_array_grow(array)) {
         return JSON_ERRC_NOT_ENOUGH_MEMORY;
     }
 
@@ -194,7 +220,7 @@ enum json_errc json_array_emplace_back_bool(
 enum json_errc json_array_emplace_back_int(
     struct json_array *array, json_int value, struct json_allocator *alloc)
 {
-    if (json_array_reserve(array, array->_size + 1)) {
+    if (json_array_grow(array)) {
         return JSON_ERRC_NOT_ENOUGH_MEMORY;
     }
 
@@ -205,7 +231,7 @@ enum json_errc json_array_emplace_back_int(
 enum json_errc json_array_emplace_back_float(
     struct json_array *array, json_float value, struct json_allocator *alloc)
 {
-    if (json_array_reserve(array, array->_size + 1)) {
+    if (json_array_grow(array)) {
         return JSON_ERRC_NOT_ENOUGH_MEMORY;
     }
 
@@ -307,7 +333,8 @@ void json_array_erase(struct json_array *array, json_size pos, json_size count)
     }
 
     memmove(array->_data + pos, array->_data + pos + count,
-            (array->_data - pos - count));
+            (array->_size - pos - count) * sizeof(*array->_data));
+    array->_size -= count;
 }
 
 enum json_errc json_array_shrink_to_fit(struct json_array *array)
@@ -331,9 +358,8 @@ enum json_errc json_array_shrink_to_fit(struct json_array *array)
 
 enum json_errc json_array_reserve(struct json_array *array, json_size n)
 {
-    if (n < array->_capacity) {
-        struct json_value *new_data =
-            json_allocate_values(array->_alloc, array->_size);
+    if (n > array->_capacity) {
+        struct json_value *new_data = json_allocate_values(array->_alloc, n);
 
         if (!new_data) {
             return JSON_ERRC_NOT_ENOUGH_MEMORY;
@@ -344,6 +370,8 @@ enum json_errc json_array_reserve(struct json_array *array, json_size n)
         array->_data = new_data;
         array->_capacity = n;
     }
+
+    return JSON_ERRC_OK;
 }
 
 enum json_errc json_array_resize(
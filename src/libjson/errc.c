@@ -8,6 +8,24 @@ const char *json_errc_message(enum json_errc ec)
         return "";
     case JSON_ERRC_NOT_ENOUGH_MEMORY:
         return "not enough memory";
+    case JSON_ERRC_UNEXPECTED_TOKEN:
+        return "unexpected token";
+    case JSON_ERRC_INVALID_ESCAPE:
+        return "invalid escape sequence";
+    case JSON_ERRC_INVALID_ENCODING:
+        return "invalid encoding";
+    case JSON_ERRC_MAX_DEPTH:
+        return "max depth exceeded";
+    case JSON_ERRC_NUMBER_OUT_OF_RANGE:
+        return "number out of range";
+    case JSON_ERRC_DUPLICATE_KEY:
+        return "duplicate key";
+    case JSON_ERRC_CANCELLED:
+        return "cancelled";
+    case JSON_ERRC_NOT_FOUND:
+        return "not found";
+    case JSON_ERRC_IO_ERROR:
+        return "input/output error";
     default:
         json_unreachable();
     }
@@ -0,0 +1,226 @@
+#include <libjson/errc.h>
+#include <libjson/fwd.h>
+#include <libjson/handler.h>
+#include <libjson/io.h>
+#include <libjson/memory.h>
+#include <libjson/string.h>
+#include <libjson/type.h>
+#include "./reader.h"
+#include "./util.h"
+
+struct json_event_reader {
+    struct json_reader r;
+    struct json_handler *handler;
+
+    /* Unescaped text of the last string that could not be borrowed. */
+    struct json_string buffer;
+};
+
+typedef int (*json_string_callback)(
+    struct json_handler *self, const char *data, json_size n);
+
+static inline enum json_errc json_event_result(int result)
+{
+    return result ? JSON_ERRC_CANCELLED : JSON_ERRC_OK;
+}
+
+static enum json_errc json_event_reader_read_string(
+    struct json_event_reader *er, json_string_callback callback)
+{
+    const char *data;
+    json_size n;
+    enum json_errc ec;
+
+    if ((ec = json_reader_read_string_span(&er->r, &er->buffer, &data, &n))) {
+        return ec;
+    }
+
+    return callback ? json_event_result(callback(er->handler, data, n))
+                    : JSON_ERRC_OK;
+}
+
+static enum json_errc json_event_reader_read_number(
+    struct json_event_reader *er)
+{
+    struct json_handler *handler = er->handler;
+    json_int int_value;
+    json_float float_value;
+    json_bool is_int;
+    enum json_errc ec;
+
+    if ((ec = json_reader_read_number(
+             &er->r, &int_value, &float_value, &is_int))) {
+        return ec;
+    } else if (is_int) {
+        return handler->on_int
+                   ? json_event_result(handler->on_int(handler, int_value))
+                   : JSON_ERRC_OK;
+    } else {
+        return handler->on_float
+                   ? json_event_result(handler->on_float(handler, float_value))
+                   : JSON_ERRC_OK;
+    }
+}
+
+static enum json_errc json_event_reader_read_value(
+    struct json_event_reader *er);
+
+static enum json_errc json_event_reader_read_array(
+    struct json_event_reader *er)
+{
+    struct json_reader *r = &er->r;
+    struct json_handler *handler = er->handler;
+    json_bool done = json_false;
+    enum json_errc ec;
+
+    ++r->first;
+
+    if (handler->on_start_array &&
+        (ec = json_event_result(handler->on_start_array(handler)))) {
+        return ec;
+    } else if ((ec = json_reader_consume_space(r))) {
+        return ec;
+    } else if (r->first != r->last && *r->first == ']') {
+        ++r->first;
+        done = json_true;
+    }
+
+    while (!done) {
+        if ((ec = json_event_reader_read_value(er)) ||
+            (ec = json_reader_read_separator(r, ']', &done))) {
+            return ec;
+        }
+    }
+
+    return handler->on_end_array
+               ? json_event_result(handler->on_end_array(handler))
+               : JSON_ERRC_OK;
+}
+
+static enum json_errc json_event_reader_read_object(
+    struct json_event_reader *er)
+{
+    struct json_reader *r = &er->r;
+    struct json_handler *handler = er->handler;
+    json_bool done = json_false;
+    enum json_errc ec;
+
+    ++r->first;
+
+    if (handler->on_start_object &&
+        (ec = json_event_result(handler->on_start_object(handler)))) {
+        return ec;
+    } else if ((ec = json_reader_consume_space(r))) {
+        return ec;
+    } else if (r->first != r->last && *r->first == '}') {
+        ++r->first;
+        done = json_true;
+    }
+
+    while (!done) {
+        if ((ec = json_event_reader_read_string(er, handler->on_key)) ||
+            (ec = json_reader_consume_space(r))) {
+            return ec;
+        } else if (r->first == r->last || *r->first != ':') {
+            return JSON_ERRC_UNEXPECTED_TOKEN;
+        }
+
+        ++r->first;
+
+        if ((ec = json_event_reader_read_value(er)) ||
+            (ec = json_reader_read_separator(r, '}', &done))) {
+            return ec;
+        }
+    }
+
+    return handler->on_end_object
+               ? json_event_result(handler->on_end_object(handler))
+               : JSON_ERRC_OK;
+}
+
+static enum json_errc json_event_reader_read_container(
+    struct json_event_reader *er)
+{
+    struct json_reader *r = &er->r;
+    enum json_errc ec;
+
+    if (r->depth >= r->options->max_depth) {
+        return JSON_ERRC_MAX_DEPTH;
+    }
+
+    ++r->depth;
+    ec = *r->first == '[' ? json_event_reader_read_array(er)
+                          : json_event_reader_read_object(er);
+    --r->depth;
+
+    return ec;
+}
+
+static enum json_errc json_event_reader_read_value(
+    struct json_event_reader *er)
+{
+    struct json_reader *r = &er->r;
+    struct json_handler *handler = er->handler;
+    json_bool value;
+    enum json_errc ec;
+
+    if ((ec = json_reader_consume_space(r))) {
+        return ec;
+    } else if (r->first == r->last) {
+        return JSON_ERRC_UNEXPECTED_TOKEN;
+    }
+
+    switch (*r->first) {
+    case 'n':
+        if ((ec = json_reader_read_null(r))) {
+            return ec;
+        }
+
+        return handler->on_null ? json_event_result(handler->on_null(handler))
+                                : JSON_ERRC_OK;
+    case 't':
+    case 'f':
+        if ((ec = json_reader_read_bool(r, &value))) {
+            return ec;
+        }
+
+        return handler->on_bool
+                   ? json_event_result(handler->on_bool(handler, value))
+                   : JSON_ERRC_OK;
+    case '-':
+    case '0':
+    case '1':
+    case '2':
+    case '3':
+    case '4':
+    case '5':
+    case '6':
+    case '7':
+    case '8':
+    case '9':
+        return json_event_reader_read_number(er);
+    case '"':
+        return json_event_reader_read_string(er, handler->on_string);
+    case '[':
+    case '{':
+        return json_event_reader_read_container(er);
+    default:
+        return JSON_ERRC_UNEXPECTED_TOKEN;
+    }
+}
+
+struct json_read_result json_read_events(
+    const char *first, const char *last, struct json_handler *handler,
+    const struct json_read_options *options)
+{
+    struct json_event_reader er = {
+        .r = json_make_reader(first, last, options),
+        .handler = handler,
+    };
+    enum json_errc ec;
+
+    json_string_construct(&er.buffer, json_get_default_allocator());
+    ec = json_event_reader_read_value(&er);
+    json_string_destruct(&er.buffer);
+    return (struct json_read_result){ .ec = ec, .ptr = er.r.first };
+}
@@ -0,0 +1,48 @@
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include "./util.h"
+
+// Zero while no seed has been chosen; seeds always have their low bit set.
+_Atomic json_uint64 json_hash_seed_value;
+
+// Gather a seed from the system's random source, falling back on the clock
+// and on addresses randomized by the loader where there is none.
+static json_uint64 json_hash_make_seed(void)
+{
+    json_uint64 seed = 0;
+    struct timespec ts = { 0 };
+    FILE *f = fopen("/dev/urandom", "rb");
+
+    if (f) {
+        if (fread(&seed, sizeof(seed), 1, f) != 1) {
+            seed = 0;
+        }
+
+        fclose(f);
+    }
+
+    if (!seed) {
+        timespec_get(&ts, TIME_UTC);
+        seed = json_wymix(
+            (json_uint64)ts.tv_sec ^ (uintptr_t)&ts,
+            (json_uint64)ts.tv_nsec ^ (uintptr_t)&json_hash_seed_value);
+    }
+
+    return seed | 1;
+}
+
+json_uint64 json_hash_choose_seed(void)
+{
+    json_uint64 seed = json_hash_make_seed();
+    json_uint64 expected = 0;
+
+    // Threads racing here agree on whichever seed is stored first.
+    if (!atomic_compare_exchange_strong(
+            &json_hash_seed_value, &expected, seed)) {
+        seed = expected;
+    }
+
+    return seed;
+}
@@ -0,0 +1,158 @@
+// Needed for MAP_POPULATE, madvise and O_CLOEXEC under strict ISO C modes.
+#define _DEFAULT_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <libjson/errc.h>
+#include <libjson/fwd.h>
+#include <libjson/io.h>
+#include <libjson/memory.h>
+#include <libjson/value.h>
+#include "./reader.h"
+#include "./util.h"
+
+/**
+ * Initial size of the buffer files that cannot be mapped are read into.
+ */
+#define JSON_FILE_BUFFER_SIZE (1 << 16)
+
+JSON_DEFINE_ALLOCATE_FUNCTION(json_allocate_buffer, char)
+JSON_DEFINE_DEALLOCATE_FUNCTION(json_deallocate_buffer, char)
+
+// Read a whole document from `[first, last)`, rejecting anything after it
+// but whitespace.
+static enum json_errc json_file_read_document(
+    const char *first, const char *last, struct json_value *value,
+    const struct json_read_options *options)
+{
+    struct json_read_result result =
+        json_read_value(first, last, value, options);
+    struct json_reader r = json_make_reader(result.ptr, last, options);
+    enum json_errc ec;
+
+    if (result.ec) {
+        return result.ec;
+    } else if ((ec = json_reader_consume_space(&r))) {
+        return ec;
+    }
+
+    return r.first == r.last ? JSON_ERRC_OK : JSON_ERRC_UNEXPECTED_TOKEN;
+}
+
+static enum json_errc json_file_read_mapped(
+    int fd, json_size size, struct json_value *value,
+    const struct json_read_options *options)
+{
+    int flags = MAP_PRIVATE;
+    char *data;
+    enum json_errc ec;
+
+#ifdef MAP_POPULATE
+    flags |= MAP_POPULATE;
+#endif
+
+    // Empty files cannot be mapped.
+    if (!size) {
+        return json_file_read_document(NULL, NULL, value, options);
+    }
+
+    if ((data = mmap(NULL, size, PROT_READ, flags, fd, 0)) == MAP_FAILED) {
+        return JSON_ERRC_IO_ERROR;
+    }
+
+#ifdef MADV_SEQUENTIAL
+    madvise(data, size, MADV_SEQUENTIAL);
+#endif
+
+    ec = json_file_read_document(data, data + size, value, options);
+    munmap(data, size);
+    return ec;
+}
+
+// Read everything left in `fd` into a buffer made with the allocator of
+// `value`, for files that cannot be mapped.
+static enum json_errc json_file_read_buffered(
+    int fd, struct json_value *value, const struct json_read_options *options)
+{
+    struct json_allocator *alloc = json_value_get_allocator(value);
+    json_size capacity = JSON_FILE_BUFFER_SIZE;
+    json_size size = 0;
+    char *data = json_allocate_buffer(alloc, capacity);
+    enum json_errc ec = JSON_ERRC_OK;
+
+    if (!data) {
+        return JSON_ERRC_NOT_ENOUGH_MEMORY;
+    }
+
+    for (;;) {
+        ssize_t n;
+
+        if (size == capacity) {
+            char *grown = json_allocate_buffer(alloc, 2 * capacity);
+
+            if (!grown) {
+                ec = JSON_ERRC_NOT_ENOUGH_MEMORY;
+                break;
+            }
+
+            memcpy(grown, data, size);
+            json_deallocate_buffer(alloc, data, capacity);
+            data = grown;
+            capacity *= 2;
+        }
+
+        if ((n = read(fd, data + size, capacity - size)) > 0) {
+            size += n;
+        } else if (!n) {
+            break;
+        } else if (errno != EINTR) {
+            ec = JSON_ERRC_IO_ERROR;
+            break;
+        }
+    }
+
+    if (!ec) {
+        ec = json_file_read_document(data, data + size, value, options);
+    }
+
+    json_deallocate_buffer(alloc, data, capacity);
+    return ec;
+}
+
+enum json_errc json_read_fd(
+    int fd, struct json_value *value, const struct json_read_options *options)
+{
+    struct stat st;
+
+    if (fstat(fd, &st)) {
+        return JSON_ERRC_IO_ERROR;
+    } else if (S_ISREG(st.st_mode)) {
+        return json_file_read_mapped(fd, st.st_size, value, options);
+    } else {
+        return json_file_read_buffered(fd, value, options);
+    }
+}
+
+enum json_errc json_read_file(
+    const char *path, struct json_value *value,
+    const struct json_read_options *options)
+{
+    enum json_errc ec;
+    int fd;
+
+    do {
+        fd = open(path, O_RDONLY | O_CLOEXEC);
+    } while (fd < 0 && errno == EINTR);
+
+    if (fd < 0) {
+        return JSON_ERRC_IO_ERROR;
+    }
+
+    ec = json_read_fd(fd, value, options);
+    close(fd);
+    return ec;
+}
@@ -1,3 +1,5 @@
+#include <math.h>
+#include <string.h>
 #include <uchar.h>
 #include <libjson/array.h>
 #include <libjson/entry.h>
@@ -6,22 +8,20 @@
 #include <libjson/object.h>
 #include <libjson/string.h>
 #include <libjson/value.h>
+#include "./number.h"
+#include "./reader.h"
+#include "./simd.h"
+#include "./table.h"
+#include "./utf8.h"
 #include "./util.h"
 
-struct json_reader {
-    const char *first;
-    const char *last;
-    const struct json_read_options *options;
-    json_size depth;
-};
-
 static inline struct json_read_result json_make_read_result(
     const char *ptr, enum json_errc ec)
 {
     return (struct json_read_result){ .ec = ec, .ptr = ptr };
 }
 
-static const struct json_read_options json_default_read_options = {
+const struct json_read_options json_default_read_options = {
     .max_depth = 250,
     .accept_invalid_code_points = json_false,
     .replace_invalid_code_points = json_false,
@@ -30,18 +30,6 @@ static const struct json_read_options json_default_read_options = {
     .accept_duplicate_keys = json_false
 };
 
-static inline struct json_reader json_make_reader(
-    const char *first, const char *last,
-    const struct json_read_options *options)
-{
-    return (struct json_reader){
-        .depth = 0,
-        .first = first,
-        .last = last,
-        .options = options ? options : &json_default_read_options
-    };
-}
-
 // https://www.unicode.org/versions/Unicode15.0.0/ch03.pdf#page=49
 static inline json_bool json_unicode_is_noncharacter(char32_t value)
 {
@@ -76,69 +64,6 @@ static inline char32_t json_unicode_surrogate_code_point(
            0x10000;
 }
 
-// See code point bit table:
-// https://en.wikipedia.org/wiki/UTF-8#Encoding
-static inline enum json_errc json_reader_read_utf8_char(
-    struct json_reader *r, char32_t *dest)
-{
-    if (r->first == r->last) {
-        return JSON_ERRC_UNEXPECTED_TOKEN;
-    }
-
-    char32_t b1 = *r->first;
-
-    if ((b1 >> 7) == 0b0) {
-        *dest = b1;
-    } else if ((b1 >> 5) == 0b110) {
-        if (++r->first == r->last) {
-            return JSON_ERRC_INVALID_ENCODING;
-        }
-
-        char32_t b2 = r->first[0];
-
-        if ((b2 >> 6) != 0b110) {
-            return JSON_ERRC_INVALID_ENCODING;
-        }
-
-        r->first += 1;
-        *dest = (b1 & 0x1F) << 6 | (b2 & 0x3F);
-    } else if ((b1 >> 4) == 0b1110) {
-        if (r->last - ++r->first < 2) {
-            return JSON_ERRC_INVALID_ENCODING;
-        }
-
-        char32_t b2 = r->first[0];
-        char32_t b3 = r->first[1];
-
-        if ((b2 >> 6) != 0b110 || (b3 >> 6) != 0b110) {
-            return JSON_ERRC_INVALID_ENCODING;
-        }
-
-        r->first += 2;
-        *dest = (b1 & 0x0F) << 12 | (b2 & 0x3F) << 6 | (b3 & 0x3F);
-    } else if ((b1 >> 3) == 0b11110) {
-        if (r->last - ++r->first < 3) {
-            return JSON_ERRC_INVALID_ENCODING;
-        }
-
-        char32_t b2 = r->first[0];
-        char32_t b3 = r->first[1];
-        char32_t b4 = r->first[2];
-
-        if ((b2 >> 6) != 0b110 || (b3 >> 6) != 0b110 || (b4 >> 6) != 0b110) {
-            return JSON_ERRC_INVALID_ENCODING;
-        }
-
-        r->first += 3;
-        *dest = (b1 & 0x07) << 17 | (b2 & 0x3F) << 12 | (b3 & 0x3F) << 6 |
-                (b4 & 0x3F);
-    } else {
-        return JSON_ERRC_INVALID_ENCODING;
-    }
-
-    return JSON_ERRC_OK;
-}
-
 static inline json_size json_write_utf8_char(char32_t code_point, char *out)
 {
     if (code_point > 0x10FFFF) {
@@ -164,12 +89,64 @@ static inline json_size json_write_utf8_char(char32_t code_point, char *out)
     }
 }
 
-static enum json_errc json_reader_consume_comment(struct json_reader *r);
+static enum json_errc json_reader_consume_comment(struct json_reader *r)
+{
+    const char *p;
+
+    if (!r->options->accept_comments || r->last - r->first < 2) {
+        return JSON_ERRC_UNEXPECTED_TOKEN;
+    }
+
+    if (r->first[1] == '/') {
+        p = memchr(r->first + 2, '\n', r->last - r->first - 2);
+        r->first = p ? p + 1 : r->last;
+        return JSON_ERRC_OK;
+    } else if (r->first[1] != '*') {
+        return JSON_ERRC_UNEXPECTED_TOKEN;
+    }
+
+    for (p = r->first + 2; (p = memchr(p, '*', r->last - p)); ++p) {
+        if (r->last - p >= 2 && p[1] == '/') {
+            r->first = p + 2;
+            return JSON_ERRC_OK;
+        }
+    }
+
+    return JSON_ERRC_UNEXPECTED_TOKEN;
+}
 
-static enum json_errc json_reader_consume_space(struct json_reader *r)
+// Every non-space byte following whitespace outside of a string is a token
+// start, so the next token is the first indexed position after the reader.
+static inline void json_reader_consume_space_indexed(struct json_reader *r)
+{
+    json_size pos = r->first - r->origin;
+
+    switch (*r->first) {
+    case '\n':
+    case '\r':
+    case '\t':
+    case ' ':
+        while (*r->index < pos) {
+            ++r->index;
+        }
+
+        r->first = r->origin + *r->index;
+        break;
+    }
+}
+
+enum json_errc json_reader_consume_space(struct json_reader *r)
 {
     enum json_errc ec;
 
+    if (r->index) {
+        if (r->first != r->last) {
+            json_reader_consume_space_indexed(r);
+        }
+
+        return JSON_ERRC_OK;
+    }
+
     while (r->first != r->last) {
         switch (*r->first) {
         case '/':
@@ -193,8 +170,7 @@ static enum json_errc json_reader_consume_space(struct json_reader *r)
 }
 
 static enum json_errc json_reader_append_code_point(
-    struct json_reader *reader, struct json_string *string,
-    char32_t code_point)
+    struct json_reader *reader, char **out, char32_t code_point)
 {
     if (json_unicode_is_surrogate(code_point) ||
         json_unicode_is_noncharacter(code_point)) {
@@ -205,143 +181,794 @@ static enum json_errc json_reader_append_code_point(
         }
     }
 
-    char buf[4];
-    json_size n = json_write_utf8_char(code_point, buf);
+    *out += json_write_utf8_char(code_point, *out);
+    return JSON_ERRC_OK;
+}
 
-    if (json_string_append(string, buf, n)) {
-        return JSON_ERRC_NOT_ENOUGH_MEMORY;
+enum json_errc json_reader_read_null(struct json_reader *r)
+{
+    if (r->last - r->first < 4 || memcmp(r->first, "null", 4)) {
+        return JSON_ERRC_UNEXPECTED_TOKEN;
     }
 
+    r->first += 4;
     return JSON_ERRC_OK;
 }
 
-static enum json_errc json_reader_read_null(struct json_reader *r)
+enum json_errc json_reader_read_bool(struct json_reader *r, json_bool *value)
 {
-    if (r->first - r->last < 4 || *r->first++ != 'n' || *r->first++ != 'u' ||
-        *r->first++ != 'l' || *r->first++ != 'l') {
+    if (r->last - r->first >= 4 && !memcmp(r->first, "true", 4)) {
+        r->first += 4;
+        *value = json_true;
+    } else if (r->last - r->first >= 5 && !memcmp(r->first, "false", 5)) {
+        r->first += 5;
+        *value = json_false;
+    } else {
         return JSON_ERRC_UNEXPECTED_TOKEN;
     }
 
     return JSON_ERRC_OK;
 }
 
-static enum json_errc json_reader_read_bool(
-    struct json_reader *r, json_bool *value)
+// Digits of `JSON_INT_MAX`; any run this long fits in a `json_uint64`.
+#define JSON_INT_MAX_DIGITS 19
+
+enum json_errc json_reader_read_int(
+    struct json_reader *r, json_int *dest)
 {
-    if (r->first == r->last) {
+    const char *p = r->first;
+    const char *first;
+    json_bool negative;
+    json_uint64 value = 0;
+    json_size digits;
+
+    negative = p != r->last && *p == '-';
+    p += negative;
+
+    if (p == r->last || !json_is_digit(*p)) {
+        r->first = p;
         return JSON_ERRC_UNEXPECTED_TOKEN;
-    } else if (*r->first == 't') {
-        if (r->last - r->first < 3 || *++r->first != 'r' ||
-            *++r->first != 'u' || *++r->first != 'e') {
-            return JSON_ERRC_UNEXPECTED_TOKEN;
+    }
+
+    if (*p == '0') {
+        r->first = p + 1;
+        *dest = 0;
+        return JSON_ERRC_OK;
+    }
+
+    // Digits are accumulated without checks; a run longer than the widest
+    // `json_int` is rejected after it has been consumed.
+    first = p;
+    while (r->last - p >= 8 && p - first <= JSON_INT_MAX_DIGITS - 8) {
+        json_uint64 word = json_load_unaligned_le64(p);
+
+        if (!json_swar_is_eight_digits(word)) {
+            break;
         }
 
-        *value = 1;
-    } else if (*r->first == 'f') {
-        if (r->last - r->first < 4 || *++r->first != 'a' ||
-            *++r->first != 'l' || *++r->first != 's' || *++r->first != 'e') {
-            return JSON_ERRC_UNEXPECTED_TOKEN;
+        value = 100000000 * value + json_swar_parse_eight_digits(word);
+        p += 8;
+    }
+
+    for (; p != r->last && json_is_digit(*p); ++p) {
+        if (p - first < JSON_INT_MAX_DIGITS) {
+            value = 10 * value + (*p - '0');
         }
+    }
 
-        *value = 0;
-    } else {
-        return JSON_ERRC_UNEXPECTED_TOKEN;
+    digits = p - first;
+    r->first = p;
+
+    if (digits > JSON_INT_MAX_DIGITS ||
+        value > (json_uint64)JSON_INT_MAX + negative) {
+        return JSON_ERRC_NUMBER_OUT_OF_RANGE;
     }
 
+    *dest = negative ? -(json_int)(value - 1) - 1 : (json_int)value;
     return JSON_ERRC_OK;
 }
 
-static enum json_errc json_reader_read_int(
-    struct json_reader *r, json_int *dest)
-{
+/**
+ * A scanned number literal, `mantissa * 10^exponent`.
+ */
+struct json_number {
+    /* First 19 significant digits; always fits in 64 bits. */
+    json_uint64 mantissa;
+    json_int exponent;
     json_bool negative;
-    json_int value;
 
-    if (r->last - r->first < 2) {
-        return JSON_ERRC_UNEXPECTED_TOKEN;
+    /* Nonzero digits were dropped beyond the first 19. */
+    json_bool truncated;
+
+    /* No fraction or exponent part. */
+    json_bool is_int;
+};
+
+#define JSON_NUMBER_MAX_DIGITS 19
+
+// Bound on the parsed exponent; anything larger over or underflows anyway and
+// the bound keeps the sum with the digit count from overflowing.
+#define JSON_NUMBER_MAX_EXPONENT 100000
+
+static inline void json_number_push_digit(
+    struct json_number *number, json_size *digits, char c, json_bool fraction)
+{
+    json_uint64 d = c - '0';
+
+    if (!number->mantissa && !d) {
+        number->exponent -= fraction;
+    } else if (*digits < JSON_NUMBER_MAX_DIGITS) {
+        number->mantissa = 10 * number->mantissa + d;
+        number->exponent -= fraction;
+        ++*digits;
+    } else {
+        number->exponent += !fraction;
+        number->truncated |= d != 0;
     }
+}
 
-    negative = *r->first == '-';
-    if (negative && ++r->first == r->last) {
-        return JSON_ERRC_UNEXPECTED_TOKEN;
+// Takes eight digits at once while they all fit into the mantissa.
+static inline const char *json_number_push_digits(
+    struct json_number *number, json_size *digits, const char *p,
+    const char *last, json_bool fraction)
+{
+    while (number->mantissa && *digits + 8 <= JSON_NUMBER_MAX_DIGITS &&
+           last - p >= 8) {
+        json_uint64 word = json_load_unaligned_le64(p);
+
+        if (!json_swar_is_eight_digits(word)) {
+            break;
+        }
+
+        number->mantissa =
+            100000000 * number->mantissa + json_swar_parse_eight_digits(word);
+        number->exponent -= 8 * fraction;
+        *digits += 8;
+        p += 8;
+    }
+
+    for (; p != last && json_is_digit(*p); ++p) {
+        json_number_push_digit(number, digits, *p, fraction);
+    }
+
+    return p;
+}
+
+static enum json_errc json_reader_scan_number(
+    struct json_reader *r, struct json_number *number)
+{
+    const char *p = r->first;
+    json_size digits = 0;
+    json_int exponent = 0;
+    json_bool exponent_negative;
+
+    *number = (struct json_number){ .is_int = json_true };
+
+    if (p != r->last && *p == '-') {
+        number->negative = json_true;
+        ++p;
     }
 
-    value = (unsigned char)*r->first;
-    if (value > 10) {
+    if (p == r->last || !json_is_digit(*p)) {
         return JSON_ERRC_UNEXPECTED_TOKEN;
-    } else if (value) {
-        while (++r->first != r->last) {
-            json_int next_value = (unsigned char)*r->first;
+    } else if (*p == '0') {
+        ++p;
+    } else {
+        number->mantissa = *p++ - '0';
+        digits = 1;
+        p = json_number_push_digits(number, &digits, p, r->last, json_false);
+    }
 
-            if (next_value > 10) {
-                break;
-            }
+    if (p != r->last && *p == '.') {
+        number->is_int = json_false;
+
+        if (++p == r->last || !json_is_digit(*p)) {
+            r->first = p;
+            return JSON_ERRC_UNEXPECTED_TOKEN;
+        }
+
+        p = json_number_push_digits(number, &digits, p, r->last, json_true);
+    }
+
+    if (p != r->last && (*p == 'e' || *p == 'E')) {
+        number->is_int = json_false;
+        exponent_negative = ++p != r->last && *p == '-';
+
+        if (p != r->last && (*p == '-' || *p == '+')) {
+            ++p;
+        }
+
+        if (p == r->last || !json_is_digit(*p)) {
+            r->first = p;
+            return JSON_ERRC_UNEXPECTED_TOKEN;
+        }
 
-            // TODO: Ensure defined behavior.
-            next_value += 10 * value;
-            if (next_value < value) {
-                return JSON_ERRC_NUMBER_OUT_OF_RANGE;
+        for (; p != r->last && json_is_digit(*p); ++p) {
+            if (exponent < JSON_NUMBER_MAX_EXPONENT) {
+                exponent = 10 * exponent + (*p - '0');
             }
+        }
+
+        number->exponent += exponent_negative ? -exponent : exponent;
+    }
+
+    r->first = p;
+    return JSON_ERRC_OK;
+}
+
+static enum json_errc json_number_to_float(
+    const struct json_number *number, const char *first, const char *last,
+    json_float *value)
+{
+    double result = json_decimal_to_double(
+        number->mantissa, number->exponent, number->negative);
+
+    // The dropped digits place the value between the mantissa and its
+    // successor; only if both round the same way is the result known.
+    if (number->truncated &&
+        result != json_decimal_to_double(
+                      number->mantissa + 1, number->exponent,
+                      number->negative)) {
+        enum json_errc ec = json_strtod(first, last, &result);
+
+        if (ec) {
+            return ec;
+        }
+    }
+
+    if (isinf(result)) {
+        return JSON_ERRC_NUMBER_OUT_OF_RANGE;
+    }
+
+    *value = result;
+    return JSON_ERRC_OK;
+}
+
+enum json_errc json_reader_read_float(
+    struct json_reader *r, json_float *value)
+{
+    const char *first = r->first;
+    struct json_number number;
+    enum json_errc ec;
+
+    if ((ec = json_reader_scan_number(r, &number))) {
+        return ec;
+    }
+
+    return json_number_to_float(&number, first, r->first, value);
+}
+
+// Copy the unescaped characters of `[r->first, last)` to `*out`. If `valid`,
+// the run is already known to be well formed UTF-8.
+static enum json_errc json_reader_copy_string_run(
+    struct json_reader *r, const char *last, json_bool valid, char **out)
+{
+    // When unescaping in place the output trails the input, possibly at the
+    // same position.
+    if (valid) {
+        if (*out != r->first) {
+            memmove(*out, r->first, last - r->first);
+        }
+
+        *out += last - r->first;
+        r->first = last;
+        return JSON_ERRC_OK;
+    }
+
+    while (r->first != last) {
+        const char *p = json_utf8_validate(r->first, last);
 
-            value = next_value;
+        memmove(*out, r->first, p - r->first);
+        *out += p - r->first;
+        r->first = p;
+
+        if (p == last) {
+            break;
+        } else if (!r->options->accept_invalid_code_points) {
+            return JSON_ERRC_INVALID_ENCODING;
+        } else if (r->options->replace_invalid_code_points) {
+            *out += json_write_utf8_char(0xFFFD, *out);
+        } else {
+            *(*out)++ = *p;
         }
 
-        if (negative) {
-            value = -value;
+        ++r->first;
+    }
+
+    return JSON_ERRC_OK;
+}
+
+static json_bool json_read_hex4(const char *p, char32_t *dest)
+{
+    char32_t value = 0;
+
+    for (json_size i = 0; i < 4; i++) {
+        char c = p[i];
+
+        if (c >= '0' && c <= '9') {
+            value = (value << 4) | (c - '0');
+        } else if (c >= 'a' && c <= 'f') {
+            value = (value << 4) | (c - 'a' + 10);
+        } else if (c >= 'A' && c <= 'F') {
+            value = (value << 4) | (c - 'A' + 10);
+        } else {
+            return json_false;
         }
     }
 
     *dest = value;
+    return json_true;
+}
+
+static enum json_errc json_reader_read_unicode_escape(
+    struct json_reader *r, const char *last, char **out)
+{
+    char32_t code_point;
+    char32_t low;
+
+    if (last - r->first < 4 || !json_read_hex4(r->first, &code_point)) {
+        return JSON_ERRC_INVALID_ESCAPE;
+    }
+
+    r->first += 4;
+
+    if (json_unicode_is_high_surrogate(code_point) && last - r->first >= 6 &&
+        r->first[0] == '\\' && r->first[1] == 'u' &&
+        json_read_hex4(r->first + 2, &low) &&
+        json_unicode_is_low_surrogate(low)) {
+        r->first += 6;
+        code_point = json_unicode_surrogate_code_point(code_point, low);
+    }
+
+    return json_reader_append_code_point(r, out, code_point);
+}
+
+static enum json_errc json_reader_read_escape(
+    struct json_reader *r, const char *last, char **out)
+{
+    if (last - r->first < 2) {
+        return JSON_ERRC_INVALID_ESCAPE;
+    }
+
+    r->first += 2;
+
+    switch (r->first[-1]) {
+    case '"':
+    case '\\':
+    case '/':
+        *(*out)++ = r->first[-1];
+        break;
+    case 'b':
+        *(*out)++ = '\b';
+        break;
+    case 'f':
+        *(*out)++ = '\f';
+        break;
+    case 'n':
+        *(*out)++ = '\n';
+        break;
+    case 'r':
+        *(*out)++ = '\r';
+        break;
+    case 't':
+        *(*out)++ = '\t';
+        break;
+    case 'u':
+        return json_reader_read_unicode_escape(r, last, out);
+    default:
+        r->first -= 2;
+        return JSON_ERRC_INVALID_ESCAPE;
+    }
+
     return JSON_ERRC_OK;
 }
 
-static enum json_errc json_reader_read_float(
-    struct json_reader *r, json_float *value);
+// Find the closing quote of the string body starting at `r->first`. Stops on
+// control characters, which must be escaped.
+enum json_errc json_reader_find_string_end(
+    struct json_reader *r, const char **end)
+{
+    const char *p = r->first;
+
+    for (;;) {
+        p = json_simd_find_string_special(p, r->last);
 
-static enum json_errc json_reader_read_string(
-    struct json_reader *r, struct json_string *value);
+        if (p == r->last) {
+            return JSON_ERRC_UNEXPECTED_TOKEN;
+        } else if (*p == '"') {
+            *end = p;
+            return JSON_ERRC_OK;
+        } else if (*p != '\\') {
+            r->first = p;
+            return JSON_ERRC_UNEXPECTED_TOKEN;
+        } else if (r->last - p < 2) {
+            return JSON_ERRC_UNEXPECTED_TOKEN;
+        }
 
-/** pre-declaration */
-static enum json_errc json_reader_read_value(
-    struct json_reader *r, struct json_value *value);
+        p += 2;
+    }
+}
 
-static enum json_errc json_reader_read_array(
-    struct json_reader *r, struct json_array *array)
+static enum json_errc json_reader_unescape_string(
+    struct json_reader *r, const char *last, char **out)
 {
+    // Escapes are ASCII, so validating the raw body validates every run.
+    json_bool valid = json_utf8_validate(r->first, last) == last;
     enum json_errc ec;
 
-    json_reader_consume_space(r);
+    while (r->first != last) {
+        const char *p = json_simd_find_string_special(r->first, last);
+
+        if ((ec = json_reader_copy_string_run(r, p, valid, out))) {
+            return ec;
+        } else if (r->first != last &&
+                   (ec = json_reader_read_escape(r, last, out))) {
+            return ec;
+        }
+    }
+
+    return JSON_ERRC_OK;
+}
+
+// Unescape the string body from `r->first` up to its closing quote `end`.
+static enum json_errc json_reader_read_string_body(
+    struct json_reader *r, const char *end, struct json_string *value)
+{
+    json_size bound;
+    char *data;
+    char *out;
+    enum json_errc ec;
+
+    // Unescaping never lengthens the body, except where a single invalid
+    // byte is replaced by a three byte replacement character.
+    bound = end - r->first;
+    if (r->options->accept_invalid_code_points &&
+        r->options->replace_invalid_code_points) {
+        bound *= 3;
+    }
+
+    json_string_clear(value);
+
+    if (json_string_reserve(value, bound)) {
+        return JSON_ERRC_NOT_ENOUGH_MEMORY;
+    }
+
+    data = json_string_chars(value);
+    out = data;
+    ec = json_reader_unescape_string(r, end, &out);
+
+    if (out != data) {
+        json_string_set_length(value, out - data);
+    }
 
-    if (r->first == r->last || *r->first != '[') {
+    if (!ec) {
+        r->first = end + 1;
+    }
+
+    return ec;
+}
+
+enum json_errc json_reader_read_string(
+    struct json_reader *r, struct json_string *value)
+{
+    const char *end;
+    enum json_errc ec;
+
+    if (r->first == r->last || *r->first != '"') {
         return JSON_ERRC_UNEXPECTED_TOKEN;
     }
 
     ++r->first;
-    json_reader_consume_space(r);
 
-    while (++r->first != r->last) {
-        if (*r->first == ']') {
-            ++r->first;
+    if ((ec = json_reader_find_string_end(r, &end))) {
+        return ec;
+    }
+
+    return json_reader_read_string_body(r, end, value);
+}
+
+enum json_errc json_reader_read_string_span(
+    struct json_reader *r, struct json_string *buffer, const char **data,
+    json_size *n)
+{
+    const char *first;
+    const char *end;
+    enum json_errc ec;
+
+    if (r->first == r->last || *r->first != '"') {
+        return JSON_ERRC_UNEXPECTED_TOKEN;
+    }
+
+    first = ++r->first;
+
+    if ((ec = json_reader_find_string_end(r, &end))) {
+        return ec;
+    }
+
+    // Without escapes the body is the string, provided it needs no encoding
+    // fixes.
+    if (!memchr(first, '\\', end - first) &&
+        ((r->options->accept_invalid_code_points &&
+          !r->options->replace_invalid_code_points) ||
+         json_utf8_validate(first, end) == end)) {
+        r->first = end + 1;
+        *data = first;
+        *n = end - first;
+        return JSON_ERRC_OK;
+    }
+
+    if ((ec = json_reader_read_string_body(r, end, buffer))) {
+        return ec;
+    }
+
+    *data = json_string_data(buffer);
+    *n = json_string_size(buffer);
+    return JSON_ERRC_OK;
+}
+
+// Read a string that becomes part of a tree. When reading in situ, the string
+// is unescaped in place and borrowed from the input, with its closing quote
+// overwritten by the null terminator.
+static enum json_errc json_reader_read_tree_string(
+    struct json_reader *r, struct json_string *value)
+{
+    const char *first;
+    const char *end;
+    char *data;
+    char *out;
+    enum json_errc ec;
+
+    if (!r->buffer) {
+        return json_reader_read_string(r, value);
+    } else if (r->first == r->last || *r->first != '"') {
+        return JSON_ERRC_UNEXPECTED_TOKEN;
+    }
+
+    first = ++r->first;
+
+    if ((ec = json_reader_find_string_end(r, &end))) {
+        return ec;
+    }
+
+    // A replacement character is longer than the byte it replaces, so such
+    // strings do not fit in place.
+    if (r->options->accept_invalid_code_points &&
+        r->options->replace_invalid_code_points &&
+        json_utf8_validate(first, end) != end) {
+        return json_reader_read_string_body(r, end, value);
+    }
+
+    data = r->buffer + (first - r->origin);
+    out = data;
+
+    if ((ec = json_reader_unescape_string(r, end, &out))) {
+        return ec;
+    }
+
+    *out = 0;
+    r->first = end + 1;
+    json_string_destruct(value);
+    json_string_construct_borrow(
+        value, data, out - data, json_string_get_allocator(value));
+    return JSON_ERRC_OK;
+}
+
+static enum json_errc json_reader_skip_container(struct json_reader *r)
+{
+    const char *p = r->first;
+    const char *end;
+    json_size depth = 0;
+    enum json_errc ec;
+
+    for (; (p = json_simd_find_bracket(p, r->last)) != r->last;) {
+        switch (*p) {
+        case '"':
+            r->first = p + 1;
+
+            if ((ec = json_reader_find_string_end(r, &end))) {
+                return ec;
+            }
+
+            p = end + 1;
+            break;
+        case '[':
+        case '{':
+            if (r->depth + ++depth > r->options->max_depth) {
+                r->first = p;
+                return JSON_ERRC_MAX_DEPTH;
+            }
+
+            ++p;
+            break;
+        case ']':
+        case '}':
+            if (!--depth) {
+                r->first = p + 1;
+                return JSON_ERRC_OK;
+            }
+
+            ++p;
+            break;
+        default:
+            r->first = p;
+
+            if ((ec = json_reader_consume_comment(r))) {
+                return ec;
+            }
+
+            p = r->first;
             break;
         }
+    }
+
+    r->first = p;
+    return JSON_ERRC_UNEXPECTED_TOKEN;
+}
+
+enum json_errc json_reader_skip_value(struct json_reader *r)
+{
+    const char *end;
+    enum json_errc ec;
+
+    if ((ec = json_reader_consume_space(r))) {
+        return ec;
+    } else if (r->first == r->last) {
+        return JSON_ERRC_UNEXPECTED_TOKEN;
+    }
 
-        if ((ec = json_array_emplace_back(array, NULL)) ||
-            (ec = json_reader_read_value(r, json_array_back(array)))) {
+    switch (*r->first) {
+    case '"':
+        ++r->first;
+
+        if ((ec = json_reader_find_string_end(r, &end))) {
             return ec;
         }
 
-        json_reader_consume_space(r);
+        r->first = end + 1;
+        return JSON_ERRC_OK;
+    case '[':
+    case '{':
+        return json_reader_skip_container(r);
+    default:
+        end = r->first;
 
-        if (*r->first == ',') {
-            ++r->first;
+        while (end != r->last && json_is_scalar(*end)) {
+            ++end;
+        }
+
+        if (end == r->first) {
+            return JSON_ERRC_UNEXPECTED_TOKEN;
         }
+
+        r->first = end;
+        return JSON_ERRC_OK;
+    }
+}
+
+// Consume the separator after an element. Sets `*done` if the closing bracket
+// was consumed instead.
+enum json_errc json_reader_read_separator(
+    struct json_reader *r, char close, json_bool *done)
+{
+    enum json_errc ec;
+
+    if ((ec = json_reader_consume_space(r))) {
+        return ec;
+    } else if (r->first == r->last) {
+        return JSON_ERRC_UNEXPECTED_TOKEN;
+    } else if (*r->first == close) {
+        ++r->first;
+        *done = json_true;
+        return JSON_ERRC_OK;
+    } else if (*r->first != ',') {
+        return JSON_ERRC_UNEXPECTED_TOKEN;
+    }
+
+    ++r->first;
+
+    if ((ec = json_reader_consume_space(r))) {
+        return ec;
+    } else if (r->options->accept_trailing_commas && r->first != r->last &&
+               *r->first == close) {
+        ++r->first;
+        *done = json_true;
     }
 
     return JSON_ERRC_OK;
 }
 
+static enum json_errc json_reader_read_array(
+    struct json_reader *r, struct json_array *array)
+{
+    json_bool done = json_false;
+    enum json_errc ec;
+
+    if ((ec = json_reader_consume_space(r))) {
+        return ec;
+    } else if (r->first == r->last || *r->first != '[') {
+        return JSON_ERRC_UNEXPECTED_TOKEN;
+    }
+
+    ++r->first;
+
+    if ((ec = json_reader_consume_space(r))) {
+        return ec;
+    } else if (r->first != r->last && *r->first == ']') {
+        ++r->first;
+        return JSON_ERRC_OK;
+    }
+
+    while (!done) {
+        if ((ec = json_array_emplace_back(
+                 array, json_array_get_allocator(array))) ||
+            (ec = json_reader_read_value(r, json_array_back(array))) ||
+            (ec = json_reader_read_separator(r, ']', &done))) {
+            return ec;
+        }
+    }
+
+    return JSON_ERRC_OK;
+}
+
+static enum json_errc json_reader_read_entry(
+    struct json_reader *r, struct json_object *object, struct json_string *key)
+{
+    struct json_entry *entry;
+    enum json_errc ec;
+
+    if ((ec = json_reader_read_tree_string(r, key)) ||
+        (ec = json_reader_consume_space(r))) {
+        return ec;
+    } else if (r->first == r->last || *r->first != ':') {
+        return JSON_ERRC_UNEXPECTED_TOKEN;
+    }
+
+    ++r->first;
+
+    ec = json_object_emplace_entry(object, key, &entry);
+
+    if (ec == JSON_ERRC_DUPLICATE_KEY && r->options->accept_duplicate_keys) {
+        json_value_assign_null(&entry->_value);
+    } else if (ec) {
+        return ec;
+    }
+
+    return json_reader_read_value(r, &entry->_value);
+}
+
 static enum json_errc json_reader_read_object(
-    struct json_reader *r, struct json_object *object);
+    struct json_reader *r, struct json_object *object)
+{
+    struct json_string key;
+    json_bool done = json_false;
+    enum json_errc ec;
+
+    if ((ec = json_reader_consume_space(r))) {
+        return ec;
+    } else if (r->first == r->last || *r->first != '{') {
+        return JSON_ERRC_UNEXPECTED_TOKEN;
+    }
+
+    ++r->first;
+
+    if ((ec = json_reader_consume_space(r))) {
+        return ec;
+    } else if (r->first != r->last && *r->first == '}') {
+        ++r->first;
+        return JSON_ERRC_OK;
+    }
+
+    json_string_construct(&key, json_object_get_allocator(object));
+
+    while (!done && !ec) {
+        if (!(ec = json_reader_read_entry(r, object, &key))) {
+            ec = json_reader_read_separator(r, '}', &done);
+        }
+    }
+
+    json_string_destruct(&key);
+    return ec;
+}
 
 static enum json_errc json_reader_read_value_null(
     struct json_reader *r, struct json_value *value)
@@ -370,10 +997,53 @@ static enum json_errc json_reader_read_value_bool(
     return JSON_ERRC_OK;
 }
 
-static enum json_errc json_reader_read_value_number(
-    struct json_reader *r, struct json_value *value);
+enum json_errc json_reader_read_number(
+    struct json_reader *r, json_int *int_value, json_float *float_value,
+    json_bool *is_int)
+{
+    const char *first = r->first;
+    struct json_number number;
+    enum json_errc ec;
 
-static enum json_errc json_reader_read_value_string(
+    if ((ec = json_reader_scan_number(r, &number))) {
+        return ec;
+    }
+
+    // Integers that do not fit in a `json_int` are read as floats, and `-0`
+    // is the integer zero.
+    if (number.is_int && !number.exponent &&
+        number.mantissa <= (json_uint64)JSON_INT_MAX + number.negative) {
+        *is_int = json_true;
+        *int_value = number.negative && number.mantissa
+                         ? -(json_int)(number.mantissa - 1) - 1
+                         : (json_int)number.mantissa;
+        return JSON_ERRC_OK;
+    }
+
+    *is_int = json_false;
+    return json_number_to_float(&number, first, r->first, float_value);
+}
+
+enum json_errc json_reader_read_value_number(
+    struct json_reader *r, struct json_value *value)
+{
+    json_int int_value;
+    json_float float_value;
+    json_bool is_int;
+    enum json_errc ec;
+
+    if ((ec = json_reader_read_number(r, &int_value, &float_value, &is_int))) {
+        return ec;
+    } else if (is_int) {
+        json_value_assign_int(value, int_value);
+    } else {
+        json_value_assign_float(value, float_value);
+    }
+
+    return JSON_ERRC_OK;
+}
+
+enum json_errc json_reader_read_value_string(
     struct json_reader *r, struct json_value *value)
 {
     struct json_string string;
@@ -381,12 +1051,12 @@ static enum json_errc json_reader_read_value_string(
 
     json_string_construct(&string, json_value_get_allocator(value));
 
-    if ((ec = json_reader_read_string(r, &string)) ||
-        (ec = json_value_assign_string_move(value, &string))) {
-        return ec;
+    if (!(ec = json_reader_read_tree_string(r, &string))) {
+        ec = json_value_assign_string_move(value, &string);
     }
 
-    return JSON_ERRC_OK;
+    json_string_destruct(&string);
+    return ec;
 }
 
 static enum json_errc json_reader_read_value_array(
@@ -395,14 +1065,20 @@ static enum json_errc json_reader_read_value_array(
     struct json_array array;
     enum json_errc ec;
 
+    if (r->depth >= r->options->max_depth) {
+        return JSON_ERRC_MAX_DEPTH;
+    }
+
     json_array_construct(&array, json_value_get_allocator(value));
+    ++r->depth;
 
-    if ((ec = json_reader_read_array(r, &array)) ||
-        (ec = json_value_assign_array_move(value, &array))) {
-        return ec;
+    if (!(ec = json_reader_read_array(r, &array))) {
+        ec = json_value_assign_array_move(value, &array);
     }
 
-    return JSON_ERRC_OK;
+    --r->depth;
+    json_array_destruct(&array);
+    return ec;
 }
 
 static enum json_errc json_reader_read_value_object(
@@ -411,17 +1087,23 @@ static enum json_errc json_reader_read_value_object(
     struct json_object object;
     enum json_errc ec;
 
+    if (r->depth >= r->options->max_depth) {
+        return JSON_ERRC_MAX_DEPTH;
+    }
+
     json_object_construct(&object, json_value_get_allocator(value));
+    ++r->depth;
 
-    if ((ec = json_reader_read_object(r, &object)) ||
-        (ec = json_value_assign_object_move(value, &object))) {
-        return ec;
+    if (!(ec = json_reader_read_object(r, &object))) {
+        ec = json_value_assign_object_move(value, &object);
     }
 
-    return JSON_ERRC_OK;
+    --r->depth;
+    json_object_destruct(&object);
+    return ec;
 }
 
-static enum json_errc json_reader_read_value(
+enum json_errc json_reader_read_value(
     struct json_reader *r, struct json_value *value)
 {
     json_reader_consume_space(r);
@@ -530,3 +1212,15 @@ struct json_read_result json_read_value(
     enum json_errc ec = json_reader_read_value(&r, value);
     return json_make_read_result(r.first, ec);
 }
+
+struct json_read_result json_read_value_insitu(
+    char *first, char *last, struct json_value *value,
+    const struct json_read_options *options)
+{
+    struct json_reader r = json_make_reader(first, last, options);
+    enum json_errc ec;
+
+    r.buffer = first;
+    ec = json_reader_read_value(&r, value);
+    return json_make_read_result(r.first, ec);
+}
@@ -1,3 +1,7 @@
+#include <locale.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
 #include <libjson/array.h>
 #include <libjson/entry.h>
 #include <libjson/fwd.h>
@@ -5,6 +9,8 @@
 #include <libjson/object.h>
 #include <libjson/string.h>
 #include <libjson/value.h>
+#include "./simd.h"
+#include "./table.h"
 #include "./util.h"
 
 struct json_writer {
@@ -79,7 +85,7 @@ static inline enum json_errc json_writer_name_sep(struct json_writer *w)
 {
     enum json_errc ec;
 
-    if ((json_writer_write_char(w, ':')) ||
+    if ((ec = json_writer_write_char(w, ':')) ||
         (w->options->indent_size && (ec = json_writer_write_char(w, ' ')))) {
         return ec;
     }
@@ -96,9 +102,16 @@ static inline enum json_errc json_writer_begin_object(struct json_writer *w)
 
 static inline enum json_errc json_writer_end_object(struct json_writer *w)
 {
-    enum json_errc ec = json_writer_write_char(w, '}');
-    w->depth -= (ec == JSON_ERRC_OK);
-    return ec;
+    enum json_errc ec;
+
+    // The closing bracket lines up with the opening one.
+    --w->depth;
+
+    if ((ec = json_writer_indent(w))) {
+        return ec;
+    }
+
+    return json_writer_write_char(w, '}');
 }
 
 static inline enum json_errc json_writer_begin_array(struct json_writer *w)
@@ -110,9 +123,16 @@ static inline enum json_errc json_writer_begin_array(struct json_writer *w)
 
 static inline enum json_errc json_writer_end_array(struct json_writer *w)
 {
-    enum json_errc ec = json_writer_write_char(w, ']');
-    w->depth -= (ec == JSON_ERRC_OK);
-    return ec;
+    enum json_errc ec;
+
+    // The closing bracket lines up with the opening one.
+    --w->depth;
+
+    if ((ec = json_writer_indent(w))) {
+        return ec;
+    }
+
+    return json_writer_write_char(w, ']');
 }
 
 static enum json_errc json_writer_write_null(struct json_writer *w)
@@ -188,52 +208,193 @@ static const char json_write_int_impl_table[] =
 static enum json_errc json_writer_write_int(
     struct json_writer *w, json_int value)
 {
-    json_size length;
+    // Negate in unsigned arithmetic so that the minimum value does not
+    // overflow.
+    json_uint magnitude = value < 0 ? 0 - (json_uint)value : (json_uint)value;
+    json_size length = (value < 0) + json_uint_log10(magnitude) + 1;
+    char *p;
 
-    if (value < 0) {
-        value = -value;
-        length = 1 + json_uint_log10(value);
+    if ((json_size)(w->last - w->first) < length) {
+        return JSON_ERRC_NOT_ENOUGH_MEMORY;
+    }
 
-        if (w->first - w->last < length) {
-            return JSON_ERRC_NOT_ENOUGH_MEMORY;
-        }
+    p = w->first + length;
 
+    if (value < 0) {
         *w->first = '-';
-    } else {
-        length = json_uint_log10(value);
-
-        if (w->first - w->last < length) {
-            return JSON_ERRC_NOT_ENOUGH_MEMORY;
-        }
     }
 
-    w->first += length;
+    w->first = p;
 
-    while (value >= 100) {
-        json_size n = 2 * (value % 100);
+    while (magnitude >= 100) {
+        json_size n = 2 * (magnitude % 100);
 
-        value /= 100;
-        w->first[--length] = json_write_int_impl_table[n + 1];
-        w->first[--length] = json_write_int_impl_table[n];
+        magnitude /= 100;
+        *--p = json_write_int_impl_table[n + 1];
+        *--p = json_write_int_impl_table[n];
     }
 
-    if (value >= 10) {
-        json_size n = 2 * value;
+    if (magnitude >= 10) {
+        json_size n = 2 * magnitude;
 
-        w->first[--length] = json_write_int_impl_table[n + 1];
-        w->first[--length] = json_write_int_impl_table[n];
+        *--p = json_write_int_impl_table[n + 1];
+        *--p = json_write_int_impl_table[n];
     } else {
-        w->first[--length] = '0' + value;
+        *--p = '0' + magnitude;
     }
 
     return JSON_ERRC_OK;
 }
 
+// Format `value` with `precision` significant digits and a '.' decimal point
+// regardless of the current locale. Returns the length written to `buf`.
+static json_size json_format_double(
+    char *buf, json_size size, int precision, double value)
+{
+    const char *point = localeconv()->decimal_point;
+    json_size point_size = strlen(point);
+    json_size n = (json_size)snprintf(buf, size, "%.*g", precision, value);
+    char *p;
+
+    if (point_size && (point[0] != '.' || point_size > 1) &&
+        (p = strstr(buf, point))) {
+        *p = '.';
+        memmove(p + 1, p + point_size, n - (p - buf) - point_size + 1);
+        n -= point_size - 1;
+    }
+
+    return n;
+}
+
+// Floats are read back as doubles, so they are written as the shortest of
+// 15, 16 or 17 significant digits that the reader turns into the same double.
+// A '.0' is appended to integral values so they are read back as floats.
 static enum json_errc json_writer_write_float(
-    struct json_writer *w, json_float value);
+    struct json_writer *w, json_float value)
+{
+    double d = (double)value;
+    char buf[40];
+    json_size n = 0;
+
+    if (!isfinite(d)) {
+        return JSON_ERRC_NUMBER_OUT_OF_RANGE;
+    }
+
+    for (int precision = 15; precision <= 17; ++precision) {
+        json_float parsed;
+
+        n = json_format_double(buf, sizeof(buf), precision, d);
+
+        if (precision == 17 ||
+            (json_read_float(buf, buf + n, &parsed, NULL).ec == JSON_ERRC_OK &&
+             (double)parsed == d)) {
+            break;
+        }
+    }
+
+    if (!memchr(buf, '.', n) && !memchr(buf, 'e', n)) {
+        buf[n++] = '.';
+        buf[n++] = '0';
+    }
+
+    if ((json_size)(w->last - w->first) < n) {
+        return JSON_ERRC_NOT_ENOUGH_MEMORY;
+    }
+
+    memcpy(w->first, buf, n);
+    w->first += n;
+    return JSON_ERRC_OK;
+}
+
+static const char json_write_string_impl_hex[] = "0123456789abcdef";
+
+static enum json_errc json_writer_write_escape(
+    struct json_writer *w, unsigned char c)
+{
+    char short_escape;
+
+    switch (c) {
+    case '"':
+        short_escape = '"';
+        break;
+    case '\\':
+        short_escape = '\\';
+        break;
+    case '\b':
+        short_escape = 'b';
+        break;
+    case '\f':
+        short_escape = 'f';
+        break;
+    case '\n':
+        short_escape = 'n';
+        break;
+    case '\r':
+        short_escape = 'r';
+        break;
+    case '\t':
+        short_escape = 't';
+        break;
+    default:
+        if (w->last - w->first < 6) {
+            return JSON_ERRC_NOT_ENOUGH_MEMORY;
+        }
+
+        *w->first++ = '\\';
+        *w->first++ = 'u';
+        *w->first++ = '0';
+        *w->first++ = '0';
+        *w->first++ = json_write_string_impl_hex[c >> 4];
+        *w->first++ = json_write_string_impl_hex[c & 0xF];
+        return JSON_ERRC_OK;
+    }
 
+    if (w->last - w->first < 2) {
+        return JSON_ERRC_NOT_ENOUGH_MEMORY;
+    }
+
+    *w->first++ = '\\';
+    *w->first++ = short_escape;
+    return JSON_ERRC_OK;
+}
+
+// Clean runs are copied as they are; only quotes, backslashes and control
+// characters are escaped.
 static enum json_errc json_writer_write_string(
-    struct json_writer *w, const struct json_string *value);
+    struct json_writer *w, const struct json_string *value)
+{
+    const char *first = json_string_const_chars(value);
+    const char *last = first + json_string_length(value);
+    enum json_errc ec;
+
+    if ((ec = json_writer_write_char(w, '"'))) {
+        return ec;
+    }
+
+    for (;;) {
+        const char *special = json_simd_find_string_special(first, last);
+        json_size n = special - first;
+
+        if ((json_size)(w->last - w->first) < n) {
+            return JSON_ERRC_NOT_ENOUGH_MEMORY;
+        }
+
+        memcpy(w->first, first, n);
+        w->first += n;
+
+        if (special == last) {
+            break;
+        }
+
+        if ((ec = json_writer_write_escape(w, *special))) {
+            return ec;
+        }
+
+        first = special + 1;
+    }
+
+    return json_writer_write_char(w, '"');
+}
 
 /* pre-declaration */
 static enum json_errc json_writer_write_value(
@@ -284,8 +445,40 @@ static enum json_errc json_writer_write_entry(
     return JSON_ERRC_OK;
 }
 
+// Entries are written in insertion order, so an object is always written the
+// same way.
 static enum json_errc json_writer_write_object(
-    struct json_writer *w, const struct json_object *value);
+    struct json_writer *w, const struct json_object *value)
+{
+    enum json_errc ec;
+    json_size size = value->_size;
+
+    if ((ec = json_writer_begin_object(w)) || (ec = json_writer_newline(w))) {
+        return ec;
+    }
+
+    if (size) {
+        --size;
+        for (json_size i = 0; i < size; i++) {
+            if ((ec = json_writer_indent(w)) ||
+                (ec = json_writer_write_entry(
+                     w, json_object_entry_at(value, i))) ||
+                (ec = json_writer_value_sep(w)) ||
+                (ec = json_writer_newline(w))) {
+                return ec;
+            }
+        }
+
+        if ((ec = json_writer_indent(w)) ||
+            (ec = json_writer_write_entry(
+                 w, json_object_entry_at(value, size))) ||
+            (ec = json_writer_newline(w))) {
+            return ec;
+        }
+    }
+
+    return json_writer_end_object(w);
+}
 
 static enum json_errc json_writer_write_value(
     struct json_writer *w, const struct json_value *value)
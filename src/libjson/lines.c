@@ -0,0 +1,360 @@
+#include <stdatomic.h>
+#include <string.h>
+#include <threads.h>
+#include <libjson/errc.h>
+#include <libjson/fwd.h>
+#include <libjson/handler.h>
+#include <libjson/io.h>
+#include <libjson/memory.h>
+#include <libjson/value.h>
+#include "./reader.h"
+#include "./simd.h"
+#include "./util.h"
+
+/**
+ * Number of lines a worker claims at a time.
+ */
+#define JSON_LINES_BATCH_SIZE 256
+
+/**
+ * Offsets of the start of every line, followed by one past the end of the
+ * input plus one, so that line `i` is `[starts[i], starts[i + 1] - 1)`.
+ */
+struct json_lines_index {
+    json_size *starts;
+    json_size size;
+    json_size capacity;
+    struct json_allocator *alloc;
+};
+
+struct json_lines_entry {
+    json_size line;
+    enum json_errc ec;
+    struct json_value value;
+};
+
+struct json_lines_reader {
+    const char *first;
+    struct json_lines_index index;
+    struct json_line_handler *handler;
+    const struct json_read_options *options;
+    json_bool ordered;
+    atomic_size_t next_batch;
+    atomic_bool stop;
+
+    /* Guards the fields below. */
+    mtx_t mutex;
+
+    /* Signalled when `next_delivery` advances or the read stops. */
+    cnd_t turn;
+
+    /* Batch whose lines are delivered next when reading in order. */
+    json_size next_delivery;
+
+    enum json_errc ec;
+};
+
+struct json_lines_worker {
+    struct json_lines_reader *reader;
+    struct json_allocator *alloc;
+    thrd_t thread;
+    json_bool started;
+
+    /* Lines of the current batch waiting for their turn. */
+    struct json_lines_entry entries[JSON_LINES_BATCH_SIZE];
+};
+
+JSON_DEFINE_ALLOCATE_FUNCTION(json_allocate_offsets, json_size)
+JSON_DEFINE_DEALLOCATE_FUNCTION(json_deallocate_offsets, json_size)
+JSON_DEFINE_ALLOCATE_FUNCTION(json_allocate_workers, struct json_lines_worker)
+JSON_DEFINE_DEALLOCATE_FUNCTION(
+    json_deallocate_workers, struct json_lines_worker)
+
+static enum json_errc json_lines_index_push(
+    struct json_lines_index *index, json_size offset)
+{
+    if (index->size == index->capacity) {
+        json_size capacity = 2 * index->capacity;
+        json_size *starts = json_allocate_offsets(index->alloc, capacity);
+
+        if (!starts) {
+            return JSON_ERRC_NOT_ENOUGH_MEMORY;
+        }
+
+        memcpy(starts, index->starts, index->size * sizeof(*starts));
+        json_deallocate_offsets(index->alloc, index->starts, index->capacity);
+        index->starts = starts;
+        index->capacity = capacity;
+    }
+
+    index->starts[index->size++] = offset;
+    return JSON_ERRC_OK;
+}
+
+static enum json_errc json_lines_index_push_block(
+    struct json_lines_index *index, const char *p, json_size offset)
+{
+    json_uint64 newlines = json_simd_eq_block(p, '\n');
+    enum json_errc ec;
+
+    while (newlines) {
+        if ((ec = json_lines_index_push(
+                 index, offset + json_simd_ctz(newlines) + 1))) {
+            return ec;
+        }
+
+        newlines &= newlines - 1;
+    }
+
+    return JSON_ERRC_OK;
+}
+
+static enum json_errc json_lines_index_construct(
+    struct json_lines_index *index, const char *first, const char *last,
+    struct json_allocator *alloc)
+{
+    json_size n = last - first;
+    json_size blocks = n / 64;
+    char tail[64];
+    enum json_errc ec;
+
+    index->alloc = alloc;
+    index->size = 0;
+    index->capacity = n / 64 + 2;
+
+    if (!(index->starts = json_allocate_offsets(alloc, index->capacity))) {
+        return JSON_ERRC_NOT_ENOUGH_MEMORY;
+    }
+
+    index->starts[index->size++] = 0;
+
+    for (json_size i = 0; i < blocks; i++) {
+        if ((ec = json_lines_index_push_block(
+                 index, first + 64 * i, 64 * i))) {
+            return ec;
+        }
+    }
+
+    if (n % 64) {
+        memset(tail, ' ', sizeof(tail));
+        memcpy(tail, first + 64 * blocks, n % 64);
+
+        if ((ec = json_lines_index_push_block(index, tail, 64 * blocks))) {
+            return ec;
+        }
+    }
+
+    return json_lines_index_push(index, n + 1);
+}
+
+static void json_lines_index_destruct(struct json_lines_index *index)
+{
+    if (index->starts) {
+        json_deallocate_offsets(index->alloc, index->starts, index->capacity);
+    }
+}
+
+// Read line `i` into `value`. Sets `*blank` instead if it holds nothing but
+// whitespace.
+static enum json_errc json_lines_read_line(
+    struct json_lines_reader *reader, json_size i, struct json_value *value,
+    json_bool *blank)
+{
+    const json_size *starts = reader->index.starts;
+    struct json_reader r = json_make_reader(
+        reader->first + starts[i], reader->first + starts[i + 1] - 1,
+        reader->options);
+    struct json_read_result result;
+    enum json_errc ec;
+
+    if ((ec = json_reader_consume_space(&r))) {
+        return ec;
+    } else if ((*blank = r.first == r.last)) {
+        return JSON_ERRC_OK;
+    }
+
+    result = json_read_value(r.first, r.last, value, reader->options);
+
+    if (result.ec) {
+        return result.ec;
+    }
+
+    r.first = result.ptr;
+
+    if ((ec = json_reader_consume_space(&r))) {
+        return ec;
+    }
+
+    return r.first == r.last ? JSON_ERRC_OK : JSON_ERRC_UNEXPECTED_TOKEN;
+}
+
+static enum json_errc json_lines_deliver(
+    struct json_lines_reader *reader, struct json_lines_entry *entry)
+{
+    struct json_line_handler *handler = reader->handler;
+
+    if (entry->ec && !handler->on_error) {
+        return entry->ec;
+    } else if (entry->ec) {
+        return handler->on_error(handler, entry->line, entry->ec)
+                   ? JSON_ERRC_CANCELLED
+                   : JSON_ERRC_OK;
+    } else {
+        return handler->on_value &&
+                       handler->on_value(handler, entry->line, &entry->value)
+                   ? JSON_ERRC_CANCELLED
+                   : JSON_ERRC_OK;
+    }
+}
+
+// Stop every worker. Must be called with the mutex held.
+static void json_lines_stop(
+    struct json_lines_reader *reader, enum json_errc ec)
+{
+    if (!reader->ec) {
+        reader->ec = ec;
+    }
+
+    atomic_store(&reader->stop, json_true);
+    cnd_broadcast(&reader->turn);
+}
+
+// Deliver the lines of `batch` once every earlier batch has been delivered.
+static void json_lines_deliver_batch(
+    struct json_lines_worker *worker, json_size batch, json_size n)
+{
+    struct json_lines_reader *reader = worker->reader;
+    enum json_errc ec;
+
+    mtx_lock(&reader->mutex);
+
+    while (!atomic_load(&reader->stop) && reader->next_delivery != batch) {
+        cnd_wait(&reader->turn, &reader->mutex);
+    }
+
+    for (json_size i = 0; i < n && !atomic_load(&reader->stop); i++) {
+        if ((ec = json_lines_deliver(reader, worker->entries + i))) {
+            json_lines_stop(reader, ec);
+        }
+    }
+
+    ++reader->next_delivery;
+    cnd_broadcast(&reader->turn);
+    mtx_unlock(&reader->mutex);
+
+    for (json_size i = 0; i < n; i++) {
+        json_value_destruct(&worker->entries[i].value);
+    }
+}
+
+static int json_lines_run(void *arg)
+{
+    struct json_lines_worker *worker = arg;
+    struct json_lines_reader *reader = worker->reader;
+    json_size count = reader->index.size - 1;
+
+    while (!atomic_load(&reader->stop)) {
+        json_size batch = atomic_fetch_add(&reader->next_batch, 1);
+        json_size begin = batch * JSON_LINES_BATCH_SIZE;
+        json_size end = begin + JSON_LINES_BATCH_SIZE;
+        json_size n = 0;
+
+        if (begin >= count) {
+            break;
+        } else if (end > count) {
+            end = count;
+        }
+
+        // Stop between lines, not batches, once any worker stops the read.
+        for (json_size i = begin; i < end && !atomic_load(&reader->stop);
+             i++) {
+            struct json_lines_entry *entry = worker->entries + n;
+            json_bool blank = json_false;
+            enum json_errc ec;
+
+            json_value_construct(&entry->value, worker->alloc);
+            entry->line = i;
+            entry->ec = json_lines_read_line(reader, i, &entry->value, &blank);
+
+            if (blank) {
+                json_value_destruct(&entry->value);
+            } else if (reader->ordered) {
+                ++n;
+            } else {
+                ec = json_lines_deliver(reader, entry);
+                json_value_destruct(&entry->value);
+
+                if (ec) {
+                    mtx_lock(&reader->mutex);
+                    json_lines_stop(reader, ec);
+                    mtx_unlock(&reader->mutex);
+                    return 0;
+                }
+            }
+        }
+
+        if (reader->ordered) {
+            json_lines_deliver_batch(worker, batch, n);
+        }
+    }
+
+    return 0;
+}
+
+enum json_errc json_read_lines(
+    const char *first, const char *last, struct json_line_handler *handler,
+    const struct json_read_lines_options *options)
+{
+    struct json_allocator *alloc = json_get_default_allocator();
+    json_size threads = options->threads ? options->threads : 1;
+    struct json_lines_reader reader = {
+        .first = first,
+        .handler = handler,
+        .options = options->read_options,
+        .ordered = options->ordered,
+        .next_delivery = 0,
+        .ec = JSON_ERRC_OK,
+    };
+    struct json_lines_worker *workers;
+
+    atomic_init(&reader.next_batch, 0);
+    atomic_init(&reader.stop, json_false);
+
+    if (json_lines_index_construct(&reader.index, first, last, alloc)) {
+        json_lines_index_destruct(&reader.index);
+        return JSON_ERRC_NOT_ENOUGH_MEMORY;
+    } else if (!(workers = json_allocate_workers(alloc, threads))) {
+        json_lines_index_destruct(&reader.index);
+        return JSON_ERRC_NOT_ENOUGH_MEMORY;
+    }
+
+    mtx_init(&reader.mutex, mtx_plain);
+    cnd_init(&reader.turn);
+
+    for (json_size k = 0; k < threads; k++) {
+        workers[k].reader = &reader;
+        workers[k].alloc =
+            options->allocators ? options->allocators[k] : NULL;
+    }
+
+    // The calling thread is the first worker. Batches are claimed as workers
+    // go, so any thread that could not be started is simply left out.
+    for (json_size k = 1; k < threads; k++) {
+        workers[k].started = thrd_create(
+            &workers[k].thread, json_lines_run, workers + k) == thrd_success;
+    }
+
+    json_lines_run(workers);
+
+    for (json_size k = 1; k < threads; k++) {
+        if (workers[k].started) {
+            thrd_join(workers[k].thread, NULL);
+        }
+    }
+
+    cnd_destroy(&reader.turn);
+    mtx_destroy(&reader.mutex);
+    json_deallocate_workers(alloc, workers, threads);
+    json_lines_index_destruct(&reader.index);
+    return reader.ec;
+}
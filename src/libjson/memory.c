@@ -1,5 +1,8 @@
 #include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include <libjson/memory.h>
 
 void json_allocator_construct(
@@ -27,6 +30,24 @@ json_bool json_allocator_is_equal(
     return a->_methods->is_equal(a, b);
 }
 
+void *json_allocator_reallocate(
+    struct json_allocator *alloc, void *p, json_size old_bytes,
+    json_size new_bytes, json_size alignment)
+{
+    void *q;
+
+    if (alloc->_methods->reallocate) {
+        return alloc->_methods->reallocate(
+            alloc, p, old_bytes, new_bytes, alignment);
+    } else if (!(q = json_allocator_allocate(alloc, new_bytes, alignment))) {
+        return NULL;
+    }
+
+    memcpy(q, p, old_bytes < new_bytes ? old_bytes : new_bytes);
+    json_allocator_deallocate(alloc, p, old_bytes, alignment);
+    return q;
+}
+
 const struct json_allocator_methods *json_allocator_get_methods(
     const struct json_allocator *alloc)
 {
@@ -76,6 +97,25 @@ static void json_stdc_allocator_deallocate(
     free(p);
 }
 
+// `realloc` only guarantees fundamental alignment, so over-aligned blocks are
+// moved by hand.
+static void *json_stdc_allocator_reallocate(
+    struct json_allocator *self, void *p, json_size old_bytes,
+    json_size new_bytes, json_size alignment)
+{
+    void *q;
+
+    if (alignment <= _Alignof(max_align_t)) {
+        return realloc(p, new_bytes);
+    } else if (!(q = aligned_alloc(alignment, new_bytes))) {
+        return NULL;
+    }
+
+    memcpy(q, p, old_bytes < new_bytes ? old_bytes : new_bytes);
+    json_stdc_allocator_deallocate(self, p, old_bytes, alignment);
+    return q;
+}
+
 static json_bool json_stdc_allocator_is_equal(
     const struct json_allocator *self, const struct json_allocator *other)
 {
@@ -86,6 +126,7 @@ static const struct json_allocator_methods json_stdc_allocator_methods = {
     .allocate = json_stdc_allocator_allocate,
     .deallocate = json_stdc_allocator_deallocate,
     .is_equal = json_stdc_allocator_is_equal,
+    .reallocate = json_stdc_allocator_reallocate,
 };
 
 static struct json_allocator json_stdc_allocator_value = {
@@ -110,3 +151,310 @@ struct json_allocator *json_set_default_allocator(
 {
     return atomic_exchange(&json_default_allocator, new_default);
 }
+
+/**
+ * Size of the first chunk of an arena constructed without one.
+ */
+#define JSON_ARENA_DEFAULT_CHUNK_SIZE (1 << 16)
+
+/**
+ * Chunks stop doubling in size past this.
+ */
+#define JSON_ARENA_MAX_CHUNK_SIZE (1 << 24)
+
+struct json_arena_chunk {
+    struct json_arena_chunk *next;
+    json_size size;
+    _Alignas(max_align_t) char data[];
+};
+
+static struct json_arena_chunk *json_arena_allocate_chunk(
+    struct json_arena *arena, json_size size)
+{
+    struct json_arena_chunk *chunk;
+
+    // `aligned_alloc` only takes sizes that are a multiple of the alignment.
+    // The rounding is usable, and is kept so the chunk is returned with the
+    // size it was allocated with.
+    size = (size + _Alignof(struct json_arena_chunk) - 1) &
+           ~(json_size)(_Alignof(struct json_arena_chunk) - 1);
+    chunk = json_allocator_allocate(
+        arena->_upstream, sizeof(*chunk) + size, _Alignof(*chunk));
+
+    if (chunk) {
+        chunk->size = size;
+        chunk->next = arena->_chunks;
+        arena->_chunks = chunk;
+        arena->_ptr = chunk->data;
+        arena->_end = chunk->data + size;
+    }
+
+    return chunk;
+}
+
+static void json_arena_deallocate_chunk(
+    struct json_arena *arena, struct json_arena_chunk *chunk)
+{
+    json_allocator_deallocate(
+        arena->_upstream, chunk, sizeof(*chunk) + chunk->size,
+        _Alignof(*chunk));
+}
+
+static void *json_arena_allocate(
+    struct json_allocator *self, json_size bytes, json_size alignment)
+{
+    struct json_arena *arena = (struct json_arena *)self;
+    json_size padding = -(uintptr_t)arena->_ptr & (alignment - 1);
+    json_size size;
+    void *p;
+
+    // Chunk data is maximally aligned, so a fresh chunk needs padding only
+    // for over-aligned requests.
+    if (!arena->_chunks || arena->_end - arena->_ptr < padding + bytes) {
+        size = alignment > _Alignof(max_align_t) ? bytes + alignment : bytes;
+
+        if (size < arena->_chunk_size) {
+            size = arena->_chunk_size;
+        }
+
+        if (!json_arena_allocate_chunk(arena, size)) {
+            return NULL;
+        } else if (arena->_chunk_size < JSON_ARENA_MAX_CHUNK_SIZE) {
+            arena->_chunk_size *= 2;
+        }
+
+        padding = -(uintptr_t)arena->_ptr & (alignment - 1);
+    }
+
+    p = arena->_ptr + padding;
+    arena->_ptr += padding + bytes;
+    return p;
+}
+
+static void json_arena_deallocate(
+    struct json_allocator *self, void *p, json_size bytes, json_size)
+{
+    struct json_arena *arena = (struct json_arena *)self;
+
+    // Give back the most recent allocation, so that a buffer that is grown
+    // right after being allocated reuses its space.
+    if ((char *)p + bytes == arena->_ptr) {
+        arena->_ptr = p;
+    }
+}
+
+// Grow or shrink the most recent allocation where it is; anything else is
+// copied, as by the allocator interface.
+static void *json_arena_reallocate(
+    struct json_allocator *self, void *p, json_size old_bytes,
+    json_size new_bytes, json_size alignment)
+{
+    struct json_arena *arena = (struct json_arena *)self;
+    void *q;
+
+    if ((char *)p + old_bytes == arena->_ptr &&
+        (json_size)(arena->_end - (char *)p) >= new_bytes) {
+        arena->_ptr = (char *)p + new_bytes;
+        return p;
+    } else if (!(q = json_arena_allocate(self, new_bytes, alignment))) {
+        return NULL;
+    }
+
+    memcpy(q, p, old_bytes < new_bytes ? old_bytes : new_bytes);
+    return q;
+}
+
+static json_bool json_arena_is_equal(
+    const struct json_allocator *self, const struct json_allocator *other)
+{
+    return self == other;
+}
+
+static const struct json_allocator_methods json_arena_methods = {
+    .allocate = json_arena_allocate,
+    .deallocate = json_arena_deallocate,
+    .is_equal = json_arena_is_equal,
+    .reallocate = json_arena_reallocate,
+};
+
+void json_arena_construct(
+    struct json_arena *arena, json_size chunk_size,
+    struct json_allocator *upstream)
+{
+    arena->_base._methods = &json_arena_methods;
+    arena->_upstream = upstream ? upstream : json_get_default_allocator();
+    arena->_chunks = NULL;
+    arena->_ptr = NULL;
+    arena->_end = NULL;
+    arena->_chunk_size =
+        chunk_size ? chunk_size : JSON_ARENA_DEFAULT_CHUNK_SIZE;
+}
+
+void json_arena_destruct(struct json_arena *arena)
+{
+    struct json_arena_chunk *next;
+
+    for (struct json_arena_chunk *chunk = arena->_chunks; chunk;
+         chunk = next) {
+        next = chunk->next;
+        json_arena_deallocate_chunk(arena, chunk);
+    }
+
+    arena->_chunks = NULL;
+    arena->_ptr = NULL;
+    arena->_end = NULL;
+}
+
+void json_arena_reset(struct json_arena *arena)
+{
+    struct json_arena_chunk *chunk = arena->_chunks;
+    struct json_arena_chunk *next;
+
+    if (!chunk) {
+        return;
+    }
+
+    for (next = chunk->next; next; next = chunk->next) {
+        chunk->next = next->next;
+        json_arena_deallocate_chunk(arena, next);
+    }
+
+    arena->_ptr = chunk->data;
+    arena->_end = chunk->data + chunk->size;
+}
+
+struct json_allocator *json_arena_allocator(struct json_arena *arena)
+{
+    return &arena->_base;
+}
+
+/**
+ * Block sizes of a pool are multiples of this.
+ */
+#define JSON_POOL_GRANULE 16
+
+/**
+ * Size of the slabs a pool carves blocks from.
+ */
+#define JSON_POOL_SLAB_SIZE (1 << 16)
+
+struct json_pool_block {
+    struct json_pool_block *next;
+};
+
+struct json_pool_slab {
+    struct json_pool_slab *next;
+    _Alignas(max_align_t) char data[JSON_POOL_SLAB_SIZE];
+};
+
+// Returns the size class of a request, or `JSON_POOL_CLASS_COUNT` if it is
+// to be passed through.
+static json_size json_pool_class(json_size bytes, json_size alignment)
+{
+    if (alignment > JSON_POOL_GRANULE ||
+        bytes > JSON_POOL_GRANULE * JSON_POOL_CLASS_COUNT) {
+        return JSON_POOL_CLASS_COUNT;
+    }
+
+    return bytes ? (bytes - 1) / JSON_POOL_GRANULE : 0;
+}
+
+// Carve a new slab into blocks of size class `k`.
+static json_bool json_pool_refill(struct json_pool *pool, json_size k)
+{
+    json_size size = (k + 1) * JSON_POOL_GRANULE;
+    struct json_pool_slab *slab = json_allocator_allocate(
+        pool->_upstream, sizeof(*slab), _Alignof(struct json_pool_slab));
+    struct json_pool_block *block;
+
+    if (!slab) {
+        return json_false;
+    }
+
+    slab->next = pool->_slabs;
+    pool->_slabs = slab;
+
+    for (json_size i = sizeof(slab->data) / size; i--;) {
+        block = (void *)(slab->data + i * size);
+        block->next = pool->_free[k];
+        pool->_free[k] = block;
+    }
+
+    return json_true;
+}
+
+static void *json_pool_allocate(
+    struct json_allocator *self, json_size bytes, json_size alignment)
+{
+    struct json_pool *pool = (struct json_pool *)self;
+    json_size k = json_pool_class(bytes, alignment);
+    struct json_pool_block *block;
+
+    if (k == JSON_POOL_CLASS_COUNT) {
+        return json_allocator_allocate(pool->_upstream, bytes, alignment);
+    } else if (!pool->_free[k] && !json_pool_refill(pool, k)) {
+        return NULL;
+    }
+
+    block = pool->_free[k];
+    pool->_free[k] = block->next;
+    return block;
+}
+
+static void json_pool_deallocate(
+    struct json_allocator *self, void *p, json_size bytes, json_size alignment)
+{
+    struct json_pool *pool = (struct json_pool *)self;
+    json_size k = json_pool_class(bytes, alignment);
+    struct json_pool_block *block = p;
+
+    if (k == JSON_POOL_CLASS_COUNT) {
+        json_allocator_deallocate(pool->_upstream, p, bytes, alignment);
+    } else if (block) {
+        block->next = pool->_free[k];
+        pool->_free[k] = block;
+    }
+}
+
+static json_bool json_pool_is_equal(
+    const struct json_allocator *self, const struct json_allocator *other)
+{
+    return self == other;
+}
+
+static const struct json_allocator_methods json_pool_methods = {
+    .allocate = json_pool_allocate,
+    .deallocate = json_pool_deallocate,
+    .is_equal = json_pool_is_equal,
+};
+
+void json_pool_construct(
+    struct json_pool *pool, struct json_allocator *upstream)
+{
+    pool->_base._methods = &json_pool_methods;
+    pool->_upstream = upstream ? upstream : json_get_default_allocator();
+    pool->_slabs = NULL;
+
+    for (json_size k = 0; k < JSON_POOL_CLASS_COUNT; k++) {
+        pool->_free[k] = NULL;
+    }
+}
+
+void json_pool_destruct(struct json_pool *pool)
+{
+    struct json_pool_slab *next;
+
+    for (struct json_pool_slab *slab = pool->_slabs; slab; slab = next) {
+        next = slab->next;
+        json_allocator_deallocate(
+            pool->_upstream, slab, sizeof(*slab),
+            _Alignof(struct json_pool_slab));
+    }
+
+    json_pool_construct(pool, pool->_upstream);
+}
+
+struct json_allocator *json_pool_allocator(struct json_pool *pool)
+{
+    return &pool->_base;
+}
@@ -0,0 +1,54 @@
+#ifndef LIBJSON_SRC_NUMBER_H_
+#define LIBJSON_SRC_NUMBER_H_
+
+#include <libjson/errc.h>
+#include <libjson/fwd.h>
+#include "./util.h"
+
+/**
+ * Nonzero if all eight bytes of the little endian word are ASCII digits.
+ */
+static inline json_bool json_swar_is_eight_digits(json_uint64 word)
+{
+    return ((word & 0xF0F0F0F0F0F0F0F0) |
+            (((word + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4)) ==
+           0x3333333333333333;
+}
+
+/**
+ * Convert eight ASCII digits, loaded as a little endian word, to their value.
+ *
+ * Adjacent digits are combined pairwise into 2, then 4, then 8 digit values,
+ * three multiplications in total.
+ */
+static inline json_uint64 json_swar_parse_eight_digits(json_uint64 word)
+{
+    const json_uint64 mask = 0x000000FF000000FF;
+    const json_uint64 mul1 = 100 + ((json_uint64)1000000 << 32);
+    const json_uint64 mul2 = 1 + ((json_uint64)10000 << 32);
+
+    word -= 0x3030303030303030;
+    word = word * 10 + (word >> 8);
+    return ((word & mask) * mul1 + ((word >> 16) & mask) * mul2) >> 32;
+}
+
+/**
+ * Compute `w * 10^q`, correctly rounded to the nearest binary64 value.
+ *
+ * Uses the exact floating point path when `w` and `10^q` are both exactly
+ * representable, and the Eisel-Lemire algorithm otherwise. Overflow yields
+ * infinity and underflow yields zero.
+ */
+double json_decimal_to_double(json_uint64 w, json_int q, json_bool negative);
+
+/**
+ * Convert the JSON number literal `[first, last)` to the nearest binary64
+ * value using the C library. Used for literals with more significant digits
+ * than fit in the fast path, where truncation makes the rounding ambiguous.
+ *
+ * Errors:
+ * - `JSON_ERRC_NOT_ENOUGH_MEMORY`
+ */
+enum json_errc json_strtod(const char *first, const char *last, double *value);
+
+#endif
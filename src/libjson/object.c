@@ -1,49 +1,509 @@
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
 #include <libjson/entry.h>
 #include <libjson/fwd.h>
 #include <libjson/object.h>
 #include <libjson/value.h>
-#include "./bucket.h"
+#include "./simd.h"
+#include "./table.h"
 #include "./util.h"
 
-static struct json_bucket *json_object_find_bucket(
-    struct json_object *object, const char *key, json_size n)
+/**
+ * Number of entries moved to the new hash index by each insertion while
+ * rehashing incrementally. Anything above one finishes the move before the
+ * new index fills up.
+ */
+#define JSON_OBJECT_REHASH_STEP 8
+
+/**
+ * Number of keys `json_object_find_many` hashes and prefetches before looking
+ * any of them up.
+ */
+#define JSON_OBJECT_FIND_BATCH 16
+
+/**
+ * Position returned by lookups that find no entry.
+ */
+#define JSON_OBJECT_NPOS ((json_size)-1)
+
+/**
+ * A hash index being replaced: the previous index of an object that rehashes
+ * incrementally, still covering its first `size` entries.
+ */
+struct json_object_rehash {
+    json_size capacity;
+    uint32_t *index;
+    unsigned char *ctrl;
+
+    /* Number of entries it covers. */
+    json_size size;
+
+    /* Number of those already in the new index. */
+    json_size moved;
+};
+
+JSON_DEFINE_ALLOCATE_FUNCTION(json_allocate_rehash, struct json_object_rehash)
+JSON_DEFINE_DEALLOCATE_FUNCTION(
+    json_deallocate_rehash, struct json_object_rehash)
+JSON_DEFINE_ALLOCATE_FUNCTION(json_allocate_index, uint32_t)
+JSON_DEFINE_DEALLOCATE_FUNCTION(json_deallocate_index, uint32_t)
+JSON_DEFINE_ALLOCATE_FUNCTION(json_allocate_segments, struct json_entry *)
+JSON_DEFINE_DEALLOCATE_FUNCTION(json_deallocate_segments, struct json_entry *)
+
+static json_bool json_object_is_small(const struct json_object *object)
+{
+    return object->_capacity <= JSON_OBJECT_SMALL_CAPACITY;
+}
+
+// Hash indices are grown once seven eighths of their slots are used, which
+// keeps probe sequences short, so there is only room for that many entries.
+// Small objects fill up completely.
+static json_size json_object_max_load(json_size capacity)
+{
+    return capacity <= JSON_OBJECT_SMALL_CAPACITY ? capacity
+                                                  : capacity - capacity / 8;
+}
+
+// Smallest capacity with room for `n` entries.
+static json_size json_object_capacity_for(json_size n)
+{
+    json_size capacity = 2;
+
+    while (json_object_max_load(capacity) < n) {
+        capacity *= 2;
+    }
+
+    return capacity;
+}
+
+// Small objects grow their first segment with their capacity; the others
+// have it full.
+static json_size json_object_first_segment_size(json_size capacity)
+{
+    return capacity < JSON_OBJECT_SMALL_CAPACITY ? capacity
+                                                 : JSON_OBJECT_SMALL_CAPACITY;
+}
+
+// The index of each slot of a hash index is followed by the control bytes of
+// all slots, in one allocation of this many `uint32_t`.
+static json_size json_object_index_size(json_size capacity)
+{
+    return capacity + capacity / sizeof(uint32_t);
+}
+
+static uint32_t *json_object_allocate_index(
+    struct json_allocator *alloc, json_size capacity, unsigned char **ctrl)
+{
+    uint32_t *index =
+        json_allocate_index(alloc, json_object_index_size(capacity));
+
+    if (index) {
+        *ctrl = (unsigned char *)(index + capacity);
+        memset(*ctrl, JSON_TABLE_EMPTY, capacity);
+    }
+
+    return index;
+}
+
+static void json_object_deallocate_index(
+    struct json_allocator *alloc, uint32_t *index, json_size capacity)
 {
-    json_uint64 pos = json_hash(key, n) & (object->_bucket_count - 1);
-    return object->_buckets + pos;
+    if (index) {
+        json_deallocate_index(alloc, index, json_object_index_size(capacity));
+    }
 }
 
-static struct json_entry *json_object_find_bucket_entry(
-    struct json_bucket *bucket, const char *key, json_size n)
+// Compare lengths first, so that most keys are rejected without touching
+// their characters.
+static json_bool json_object_key_equals(
+    const struct json_entry *entry, const char *key, json_size n)
 {
-    struct json_entry *entry = bucket->_first;
+    return n == json_string_length(&entry->_key) &&
+           !memcmp(key, json_string_const_chars(&entry->_key), n);
+}
+
+// Groups are probed in triangular order, which visits every group once since
+// their number is a power of two.
+static json_size json_object_find_indexed(
+    const struct json_object *object, json_size capacity,
+    const uint32_t *index, const unsigned char *ctrl, const char *key,
+    json_size n, json_uint64 hash)
+{
+    json_size mask = capacity / JSON_TABLE_GROUP_WIDTH - 1;
+    json_size group = json_table_h1(hash) & mask;
+
+    for (json_size i = 0; i <= mask; group = (group + ++i) & mask) {
+        json_size first = group * JSON_TABLE_GROUP_WIDTH;
+        unsigned match = json_table_match(ctrl + first, json_table_h2(hash));
 
-    for (; entry; entry = entry->_next) {
-        if (n == entry->_key._impl->_size &&
-            !memcmp(key, entry->_key._impl->_data, n)) {
-            break;
+        for (; match; match &= match - 1) {
+            json_size pos = index[first + json_simd_ctz(match)];
+            struct json_entry *entry = json_object_entry_at(object, pos);
+
+            if (entry->_hash == hash &&
+                json_object_key_equals(entry, key, n)) {
+                return pos;
+            }
+        }
+
+        if (json_table_match_empty(ctrl + first)) {
+            return JSON_OBJECT_NPOS;
         }
     }
 
-    return entry;
+    return JSON_OBJECT_NPOS;
 }
 
-static struct json_entry *json_object_find_entry(
-    struct json_object *object, const char *key, json_size n)
+// While rehashing, the previous index still covers the oldest entries and the
+// new one the rest, so a key may have to be looked up in both.
+static json_size json_object_find_hashed(
+    const struct json_object *object, const char *key, json_size n,
+    json_uint64 hash)
+{
+    const struct json_object_rehash *rehash = object->_rehash;
+    json_size pos = JSON_OBJECT_NPOS;
+
+    if (rehash) {
+        pos = json_object_find_indexed(
+            object, rehash->capacity, rehash->index, rehash->ctrl, key, n,
+            hash);
+    }
+
+    if (pos == JSON_OBJECT_NPOS) {
+        pos = json_object_find_indexed(
+            object, object->_capacity, object->_index, object->_ctrl, key, n,
+            hash);
+    }
+
+    return pos;
+}
+
+static json_size json_object_find_small(
+    const struct json_object *object, const char *key, json_size n)
+{
+    for (json_size pos = 0; pos < object->_size; ++pos) {
+        if (json_object_key_equals(object->_entries + pos, key, n)) {
+            return pos;
+        }
+    }
+
+    return JSON_OBJECT_NPOS;
+}
+
+// Position of the entry with key `[key, key + n)`, or `JSON_OBJECT_NPOS`.
+static json_size json_object_find_pos(
+    const struct json_object *object, const char *key, json_size n)
+{
+    if (json_object_is_small(object)) {
+        return json_object_find_small(object, key, n);
+    }
+
+    return json_object_find_hashed(object, key, n, json_hash(key, n));
+}
+
+// A hash of zero stands for one not yet computed. A key whose hash really is
+// zero is just hashed on every lookup.
+static json_uint64 json_key_hash(struct json_key *key)
+{
+    json_uint64 hash =
+        atomic_load_explicit(&key->_hash, memory_order_relaxed);
+
+    if (!hash) {
+        hash = json_hash(key->_data, key->_size);
+        atomic_store_explicit(&key->_hash, hash, memory_order_relaxed);
+    }
+
+    return hash;
+}
+
+static json_size json_object_find_key_pos(
+    const struct json_object *object, struct json_key *key)
+{
+    if (json_object_is_small(object)) {
+        return json_object_find_small(object, key->_data, key->_size);
+    }
+
+    return json_object_find_hashed(
+        object, key->_data, key->_size, json_key_hash(key));
+}
+
+// Look up a batch of keys in an object with a hash index in three passes:
+// the first hashes every key and prefetches the slots it probes first, the
+// second prefetches the first entry each key's control bytes point at, and
+// the third does the lookups. The loads of each pass are independent, so
+// their cache misses overlap instead of following one another.
+static json_size json_object_find_batch(
+    const struct json_object *object, struct json_key *keys, json_size n,
+    struct json_value **values)
+{
+    json_size mask = object->_capacity / JSON_TABLE_GROUP_WIDTH - 1;
+    json_uint64 hashes[JSON_OBJECT_FIND_BATCH];
+    json_size firsts[JSON_OBJECT_FIND_BATCH];
+    json_size found = 0;
+
+    for (json_size i = 0; i < n; i++) {
+        hashes[i] = json_key_hash(keys + i);
+        firsts[i] = (json_table_h1(hashes[i]) & mask) * JSON_TABLE_GROUP_WIDTH;
+        json_prefetch(object->_ctrl + firsts[i]);
+        json_prefetch(object->_index + firsts[i]);
+    }
+
+    for (json_size i = 0; i < n; i++) {
+        unsigned match = json_table_match(
+            object->_ctrl + firsts[i], json_table_h2(hashes[i]));
+
+        if (match) {
+            json_prefetch(json_object_entry_at(
+                object, object->_index[firsts[i] + json_simd_ctz(match)]));
+        }
+    }
+
+    for (json_size i = 0; i < n; i++) {
+        json_size pos = json_object_find_hashed(
+            object, keys[i]._data, keys[i]._size, hashes[i]);
+
+        values[i] = pos != JSON_OBJECT_NPOS
+                        ? &json_object_entry_at(object, pos)->_value
+                        : NULL;
+        found += pos != JSON_OBJECT_NPOS;
+    }
+
+    return found;
+}
+
+// Point the first unused slot on the probe sequence of `hash` at entry `pos`.
+// The index must have one.
+static void json_object_index_entry(
+    struct json_object *object, json_uint64 hash, json_size pos)
+{
+    json_size mask = object->_capacity / JSON_TABLE_GROUP_WIDTH - 1;
+    json_size group = json_table_h1(hash) & mask;
+
+    for (json_size i = 0;; group = (group + ++i) & mask) {
+        json_size first = group * JSON_TABLE_GROUP_WIDTH;
+        unsigned empty = json_table_match_empty(object->_ctrl + first);
+
+        if (empty) {
+            first += json_simd_ctz(empty);
+            object->_ctrl[first] = json_table_h2(hash);
+            object->_index[first] = pos;
+            return;
+        }
+    }
+}
+
+static void json_object_index_entries(
+    struct json_object *object, json_size first, json_size last)
+{
+    for (; first < last; ++first) {
+        json_object_index_entry(
+            object, json_object_entry_at(object, first)->_hash, first);
+    }
+}
+
+// Move up to `n` more entries from the previous index to the new one, and
+// drop the previous index once it has none left.
+static void json_object_rehash_step(struct json_object *object, json_size n)
+{
+    struct json_object_rehash *rehash = object->_rehash;
+
+    if (n > rehash->size - rehash->moved) {
+        n = rehash->size - rehash->moved;
+    }
+
+    json_object_index_entries(object, rehash->moved, rehash->moved + n);
+    rehash->moved += n;
+
+    if (rehash->moved == rehash->size) {
+        json_object_deallocate_index(
+            object->_alloc, rehash->index, rehash->capacity);
+        json_deallocate_rehash(object->_alloc, rehash, 1);
+        object->_rehash = NULL;
+    }
+}
+
+static void json_object_rehash_finish(struct json_object *object)
+{
+    if (object->_rehash) {
+        json_object_rehash_step(object, object->_rehash->size);
+    }
+}
+
+// Drop the previous index without moving what is left of it, for when the
+// entries it covers are gone.
+static void json_object_rehash_discard(struct json_object *object)
 {
-    return json_object_find_bucket_entry(
-        json_object_find_bucket(object, key, n), key, n);
+    struct json_object_rehash *rehash = object->_rehash;
+
+    if (rehash) {
+        json_object_deallocate_index(
+            object->_alloc, rehash->index, rehash->capacity);
+        json_deallocate_rehash(object->_alloc, rehash, 1);
+        object->_rehash = NULL;
+    }
 }
 
-static struct json_bucket *json_object_next_bucket(
+// Grow to `capacity` slots and build a new hash index, either at once or, when
+// rehashing incrementally, a few entries per later insertion. Only the first
+// segment of entries is ever moved, and only while the object is small, so
+// this moves at most eight entries. Entries keep the hash of their key once
+// the object has an index, so only an object that is getting its first index
+// hashes its keys here, and only those whose hash is not known yet.
+static enum json_errc json_object_grow(
+    struct json_object *object, json_size capacity)
+{
+    struct json_allocator *alloc = object->_alloc;
+    json_size size = json_object_first_segment_size(object->_capacity);
+    json_size new_size = json_object_first_segment_size(capacity);
+    struct json_entry *entries = object->_entries;
+    struct json_object_rehash *rehash = NULL;
+    uint32_t *index = NULL;
+    unsigned char *ctrl = NULL;
+    json_bool had_index = object->_index != NULL;
+
+    json_object_rehash_finish(object);
+
+    if (capacity > JSON_OBJECT_SMALL_CAPACITY &&
+        !(index = json_object_allocate_index(alloc, capacity, &ctrl))) {
+        return JSON_ERRC_NOT_ENOUGH_MEMORY;
+    }
+
+    // The entries are moved bitwise, as nothing points into them.
+    if (new_size != size) {
+        if (entries) {
+            entries = json_allocator_reallocate(
+                alloc, entries, size * sizeof(*entries),
+                new_size * sizeof(*entries), _Alignof(struct json_entry));
+        } else {
+            entries = json_allocate_entries(alloc, new_size);
+        }
+
+        if (!entries) {
+            json_object_deallocate_index(alloc, index, capacity);
+            return JSON_ERRC_NOT_ENOUGH_MEMORY;
+        }
+    }
+
+    // Without memory to track the move, fall back on rehashing at once.
+    if (object->_incremental && object->_index &&
+        (rehash = json_allocate_rehash(alloc, 1))) {
+        rehash->capacity = object->_capacity;
+        rehash->index = object->_index;
+        rehash->ctrl = object->_ctrl;
+        rehash->size = object->_size;
+        rehash->moved = 0;
+    } else {
+        json_object_deallocate_index(alloc, object->_index, object->_capacity);
+    }
+
+    object->_capacity = capacity;
+    object->_entries = entries;
+    object->_index = index;
+    object->_ctrl = ctrl;
+    object->_rehash = rehash;
+
+    if (index && !had_index) {
+        for (json_size pos = 0; pos < object->_size; ++pos) {
+            struct json_entry *entry = object->_entries + pos;
+
+            if (!entry->_hash) {
+                entry->_hash = json_hash(
+                    json_string_chars(&entry->_key),
+                    json_string_length(&entry->_key));
+            }
+        }
+    }
+
+    if (index && !rehash) {
+        json_object_index_entries(object, 0, object->_size);
+    }
+
+    return JSON_ERRC_OK;
+}
+
+// Allocate the segment starting at entry `pos`, and the table of segments if
+// it is the first one past the first segment.
+static enum json_errc json_object_allocate_segment(
     struct json_object *object, json_size pos)
 {
-    for (; pos < object->_bucket_count; ++pos) {
-        if (object->_buckets[pos]._first) {
-            return object->_buckets + pos;
+    unsigned s = json_object_segment_of(pos);
+
+    if (!object->_segments) {
+        object->_segments =
+            json_allocate_segments(object->_alloc, JSON_OBJECT_MAX_SEGMENTS);
+
+        if (!object->_segments) {
+            return JSON_ERRC_NOT_ENOUGH_MEMORY;
+        }
+
+        for (unsigned i = 0; i < JSON_OBJECT_MAX_SEGMENTS; i++) {
+            object->_segments[i] = NULL;
+        }
+    }
+
+    if (!object->_segments[s] &&
+        !(object->_segments[s] = json_allocate_entries(object->_alloc, pos))) {
+        return JSON_ERRC_NOT_ENOUGH_MEMORY;
+    }
+
+    return JSON_ERRC_OK;
+}
+
+// Allocate the segments holding the first `n` entries.
+static enum json_errc json_object_allocate_segments(
+    struct json_object *object, json_size n)
+{
+    enum json_errc ec;
+
+    for (json_size pos = JSON_OBJECT_SMALL_CAPACITY; pos < n; pos *= 2) {
+        if ((ec = json_object_allocate_segment(object, pos))) {
+            return ec;
         }
     }
 
-    return NULL;
+    return JSON_ERRC_OK;
+}
+
+static void json_object_deallocate_entries(struct json_object *object)
+{
+    if (object->_entries) {
+        json_deallocate_entries(
+            object->_alloc, object->_entries,
+            json_object_first_segment_size(object->_capacity));
+    }
+
+    if (object->_segments) {
+        for (unsigned s = 0; s < JSON_OBJECT_MAX_SEGMENTS; s++) {
+            if (object->_segments[s]) {
+                json_deallocate_entries(
+                    object->_alloc, object->_segments[s],
+                    JSON_OBJECT_SMALL_CAPACITY << s);
+            }
+        }
+
+        json_deallocate_segments(
+            object->_alloc, object->_segments, JSON_OBJECT_MAX_SEGMENTS);
+    }
+}
+
+static void json_object_destruct_entries(struct json_object *object)
+{
+    for (json_size pos = 0; pos < object->_size; ++pos) {
+        struct json_entry *entry = json_object_entry_at(object, pos);
+
+        json_string_destruct(&entry->_key);
+        json_value_destruct(&entry->_value);
+    }
+}
+
+static void json_object_iter_seek(
+    struct json_object *object, json_size pos, struct json_object_iter *iter)
+{
+    iter->_object = object;
+    iter->_pos = pos;
+    iter->_entry =
+        pos < object->_size ? json_object_entry_at(object, pos) : NULL;
 }
 
 void json_object_construct(
@@ -51,13 +511,66 @@ void json_object_construct(
 {
     object->_alloc = alloc ? alloc : json_get_default_allocator();
     object->_size = 0;
-    object->_buckets = NULL;
-    object->_bucket_count = 0;
+    object->_capacity = 0;
+    object->_entries = NULL;
+    object->_segments = NULL;
+    object->_index = NULL;
+    object->_ctrl = NULL;
+    object->_rehash = NULL;
+    object->_incremental = json_false;
+}
+
+// Insert a copy of `from`, whose key must not be in `object` already. The
+// hash of its key is reused rather than computed again.
+static enum json_errc json_object_copy_entry(
+    struct json_object *object, const struct json_entry *from)
+{
+    struct json_string key;
+    struct json_entry *entry;
+    enum json_errc ec;
+
+    if ((ec = json_string_construct_copy(&key, &from->_key, object->_alloc))) {
+        return ec;
+    } else if ((ec = json_object_emplace_entry_hashed(
+                    object, &key, from->_hash, &entry))) {
+        json_string_destruct(&key);
+    } else if ((ec = json_value_construct_copy(
+                    &entry->_value, &from->_value, object->_alloc))) {
+        json_value_construct(&entry->_value, object->_alloc);
+    }
+
+    return ec;
+}
+
+// Insert copies of the entries of `other`, none of whose keys may be in
+// `object` already.
+static enum json_errc json_object_copy_entries(
+    struct json_object *object, const struct json_object *other)
+{
+    enum json_errc ec = json_object_reserve(
+        object, object->_size + other->_size);
+
+    for (json_size pos = 0; !ec && pos < other->_size; ++pos) {
+        ec = json_object_copy_entry(object, json_object_entry_at(other, pos));
+    }
+
+    return ec;
 }
 
 enum json_errc json_object_construct_copy(
     struct json_object *object, const struct json_object *other,
-    struct json_allocator *alloc);
+    struct json_allocator *alloc)
+{
+    enum json_errc ec;
+
+    json_object_construct(object, alloc ? alloc : other->_alloc);
+
+    if ((ec = json_object_copy_entries(object, other))) {
+        json_object_destruct(object);
+    }
+
+    return ec;
+}
 
 enum json_errc json_object_construct_move(
     struct json_object *object, struct json_object *other,
@@ -71,35 +584,54 @@ enum json_errc json_object_construct_move(
 
     object->_alloc = alloc;
     object->_size = other->_size;
-    object->_buckets = other->_buckets;
-    object->_bucket_count = other->_bucket_count;
+    object->_capacity = other->_capacity;
+    object->_entries = other->_entries;
+    object->_segments = other->_segments;
+    object->_index = other->_index;
+    object->_ctrl = other->_ctrl;
+    object->_rehash = other->_rehash;
+    object->_incremental = other->_incremental;
     other->_size = 0;
-    other->_buckets = NULL;
-    other->_bucket_count = 0;
+    other->_capacity = 0;
+    other->_entries = NULL;
+    other->_segments = NULL;
+    other->_index = NULL;
+    other->_ctrl = NULL;
+    other->_rehash = NULL;
 
     return JSON_ERRC_OK;
 }
 
 void json_object_destruct(struct json_object *object)
 {
-    for (json_size pos = 0; pos < object->_bucket_count; ++pos) {
-        for (struct json_entry *entry = object->_buckets[pos]._first; entry;) {
-            struct json_entry *next = entry->_next;
+    json_object_destruct_entries(object);
+    json_object_rehash_discard(object);
+    json_object_deallocate_index(
+        object->_alloc, object->_index, object->_capacity);
+    json_object_deallocate_entries(object);
+}
 
-            json_entry_delete(entry, object->_alloc);
-            entry = next;
-        }
+enum json_errc json_object_assign_copy(
+    struct json_object *object, const struct json_object *other)
+{
+    if (object == other) {
+        return JSON_ERRC_OK;
     }
 
-    json_deallocate_entries(
-        object->_alloc, object->_buckets, object->_bucket_count);
+    json_object_clear(object);
+    return json_object_copy_entries(object, other);
 }
 
-enum json_errc json_object_assign_copy(
-    struct json_object *object, const struct json_object *other);
-
 enum json_errc json_object_assign_move(
-    struct json_object *object, struct json_object *other);
+    struct json_object *object, struct json_object *other)
+{
+    if (!json_allocator_is_equal(object->_alloc, other->_alloc)) {
+        return json_object_assign_copy(object, other);
+    }
+
+    json_object_destruct(object);
+    return json_object_construct_move(object, other, object->_alloc);
+}
 
 struct json_allocator *json_object_get_allocator(
     const struct json_object *object)
@@ -110,21 +642,13 @@ struct json_allocator *json_object_get_allocator(
 void json_object_begin(
     struct json_object *object, struct json_object_iter *iter)
 {
-    struct json_bucket *bucket = json_object_next_bucket(object, 0);
-
-    if (bucket->_first) {
-        iter->_entry = bucket->_first;
-        iter->_pos = bucket - object->_buckets;
-        iter->_object = object;
-    } else {
-        json_object_end(object, iter);
-    }
+    json_object_iter_seek(object, 0, iter);
 }
 
 void json_object_end(struct json_object *object, struct json_object_iter *iter)
 {
     iter->_entry = NULL;
-    iter->_pos = object->_bucket_count;
+    iter->_pos = object->_size;
     iter->_object = object;
 }
 
@@ -140,117 +664,397 @@ json_size json_object_size(const struct json_object *object)
 
 void json_object_clear(struct json_object *object)
 {
-    for (json_size pos = 0; pos < object->_bucket_count; ++pos) {
-        for (struct json_entry *entry = object->_buckets[pos]._first; entry;
-             entry = entry->_next) {
-            json_entry_delete(entry, object->_alloc);
-        }
+    json_object_destruct_entries(object);
+    json_object_rehash_discard(object);
+    object->_size = 0;
+
+    if (object->_ctrl) {
+        memset(object->_ctrl, JSON_TABLE_EMPTY, object->_capacity);
     }
+}
 
-    object->_size = 0;
+enum json_errc json_object_reserve(struct json_object *object, json_size n)
+{
+    enum json_errc ec;
+
+    if (n > json_object_max_load(object->_capacity) &&
+        (ec = json_object_grow(object, json_object_capacity_for(n)))) {
+        return ec;
+    }
+
+    return json_object_allocate_segments(object, n);
 }
 
-// enum json_errc json_object_reserve(json_size n);
+void json_object_set_incremental_rehash(
+    struct json_object *object, json_bool incremental)
+{
+    object->_incremental = incremental;
+
+    if (!incremental) {
+        json_object_rehash_finish(object);
+    }
+}
 
 void json_object_swap(struct json_object *object, struct json_object *other)
 {
     json_size size = object->_size;
-    json_size bucket_count = object->_bucket_count;
-    struct json_bucket *buckets = object->_buckets;
+    json_size capacity = object->_capacity;
+    struct json_entry *entries = object->_entries;
+    struct json_entry **segments = object->_segments;
+    uint32_t *index = object->_index;
+    unsigned char *ctrl = object->_ctrl;
+    struct json_object_rehash *rehash = object->_rehash;
+    json_bool incremental = object->_incremental;
 
     object->_size = other->_size;
-    object->_bucket_count = other->_bucket_count;
-    object->_buckets = other->_buckets;
+    object->_capacity = other->_capacity;
+    object->_entries = other->_entries;
+    object->_segments = other->_segments;
+    object->_index = other->_index;
+    object->_ctrl = other->_ctrl;
+    object->_rehash = other->_rehash;
+    object->_incremental = other->_incremental;
     other->_size = size;
-    other->_bucket_count = bucket_count;
-    other->_buckets = buckets;
+    other->_capacity = capacity;
+    other->_entries = entries;
+    other->_segments = segments;
+    other->_index = index;
+    other->_ctrl = ctrl;
+    other->_rehash = rehash;
+    other->_incremental = incremental;
+}
+
+// Value of the entry at `pos`, or `NULL` for `JSON_OBJECT_NPOS`.
+static struct json_value *json_object_value_at(
+    const struct json_object *object, json_size pos)
+{
+    return pos != JSON_OBJECT_NPOS ? &json_object_entry_at(object, pos)->_value
+                                   : NULL;
 }
 
 json_bool json_object_contains(
     const struct json_object *object, const char *key, json_size n)
 {
-    return json_object_find_entry(object, key, n);
+    return json_object_find_pos(object, key, n) != JSON_OBJECT_NPOS;
 }
 
 struct json_value *json_object_at(
     struct json_object *object, const char *key, json_size n)
 {
-    return &json_object_find_entry(object, key, n)->_value;
+    return json_object_value_at(object, json_object_find_pos(object, key, n));
 }
 
 void json_object_find(struct json_object *object, const char *key, json_size n,
                       struct json_object_iter *iter)
 {
-    struct json_bucket *bucket = json_object_find_bucket(object, key, n);
-    struct json_entry *entry = json_object_find_bucket_entry(bucket, key, n);
+    json_size pos = json_object_find_pos(object, key, n);
+    json_object_iter_seek(
+        object, pos != JSON_OBJECT_NPOS ? pos : object->_size, iter);
+}
+
+void json_key_construct(struct json_key *key, const char *data, json_size n)
+{
+    key->_data = data;
+    key->_size = n;
+    atomic_init(&key->_hash, 0);
+    json_key_hash(key);
+}
+
+void json_object_find_key(
+    struct json_object *object, struct json_key *key,
+    struct json_object_iter *iter)
+{
+    json_size pos = json_object_find_key_pos(object, key);
+    json_object_iter_seek(
+        object, pos != JSON_OBJECT_NPOS ? pos : object->_size, iter);
+}
+
+struct json_value *json_object_at_key(
+    struct json_object *object, struct json_key *key)
+{
+    return json_object_value_at(object, json_object_find_key_pos(object, key));
+}
+
+json_size json_object_find_many(
+    struct json_object *object, struct json_key *keys, json_size n,
+    struct json_value **values)
+{
+    json_size found = 0;
+
+    if (json_object_is_small(object)) {
+        for (json_size i = 0; i < n; i++) {
+            values[i] = json_object_at_key(object, keys + i);
+            found += values[i] != NULL;
+        }
+
+        return found;
+    }
 
-    if (entry) {
-        iter->_object = object;
-        iter->_pos = bucket - object->_buckets;
-        iter->_entry = json_object_find_bucket_entry(entry, key, n);
+    for (json_size i = 0; i < n; i += JSON_OBJECT_FIND_BATCH) {
+        json_size m = n - i < JSON_OBJECT_FIND_BATCH ? n - i
+                                                     : JSON_OBJECT_FIND_BATCH;
+        found += json_object_find_batch(object, keys + i, m, values + i);
+    }
+
+    return found;
+}
+
+// Insert an entry with a null value for `key` as
+// `json_object_emplace_entry_hashed` does, and set `*pos` to its position or
+// that of the entry with an equal key. The key is hashed at most once, and
+// only once the object has an index.
+static enum json_errc json_object_emplace_pos(
+    struct json_object *object, struct json_string *key, json_uint64 hash,
+    json_size *pos)
+{
+    const char *chars = json_string_chars(key);
+    json_size n = json_string_length(key);
+    struct json_entry *entry;
+    enum json_errc ec;
+
+    if (json_object_is_small(object)) {
+        *pos = json_object_find_small(object, chars, n);
     } else {
-        json_object_end(object, iter);
+        hash = hash ? hash : json_hash(chars, n);
+        *pos = json_object_find_hashed(object, chars, n, hash);
+    }
+
+    if (*pos != JSON_OBJECT_NPOS) {
+        return JSON_ERRC_DUPLICATE_KEY;
+    }
+
+    *pos = object->_size;
+
+    if (object->_size == json_object_max_load(object->_capacity)) {
+        if ((ec = json_object_grow(
+                 object, object->_capacity ? 2 * object->_capacity : 2))) {
+            return ec;
+        }
+
+        // The object may just have outgrown the linear scan.
+        if (!json_object_is_small(object) && !hash) {
+            hash = json_hash(chars, n);
+        }
+    }
+
+    // Segments are allocated whole, so only the first entry of one may need
+    // it allocated.
+    if (*pos >= JSON_OBJECT_SMALL_CAPACITY && !(*pos & (*pos - 1)) &&
+        (ec = json_object_allocate_segment(object, *pos))) {
+        return ec;
+    }
+
+    entry = json_object_entry_at(object, *pos);
+
+    // Moving the key copies it if the object has another allocator, which may
+    // fail, so it goes first and a failure leaves the object as it was.
+    if ((ec = json_string_construct_move(&entry->_key, key, object->_alloc))) {
+        return ec;
     }
+
+    if (!json_object_is_small(object)) {
+        json_object_index_entry(object, hash, object->_size);
+    }
+
+    if (object->_rehash) {
+        json_object_rehash_step(object, JSON_OBJECT_REHASH_STEP);
+    }
+
+    entry->_hash = hash;
+    json_value_construct(&entry->_value, object->_alloc);
+    ++object->_size;
+    return JSON_ERRC_OK;
 }
 
-json_bool json_object_insert_copy(
-    struct json_object *object, const char *key, json_size n,
-    const struct json_value *value, struct json_object_iter *it);
+enum json_errc json_object_emplace_entry_hashed(
+    struct json_object *object, struct json_string *key, json_uint64 hash,
+    struct json_entry **entry)
+{
+    json_size pos;
+    enum json_errc ec = json_object_emplace_pos(object, key, hash, &pos);
 
-json_bool json_object_insert_move(
-    struct json_object *object, const char *key, json_size n,
-    struct json_value *value, struct json_object_iter *it);
+    *entry = ec == JSON_ERRC_OK || ec == JSON_ERRC_DUPLICATE_KEY
+                 ? json_object_entry_at(object, pos)
+                 : NULL;
+    return ec;
+}
 
-json_bool json_object_emplace(struct json_object *object, const char *key,
-                              json_size n, struct json_allocator *alloc);
+enum json_errc json_object_emplace_entry(
+    struct json_object *object, struct json_string *key,
+    struct json_entry **entry)
+{
+    return json_object_emplace_entry_hashed(object, key, 0, entry);
+}
 
-json_bool json_object_emplace_null(
-    struct json_object *object, const char *key, json_size n,
-    struct json_allocator *alloc);
+// Insert an entry with a null value for a copy of the `n` characters at `key`,
+// as by `json_object_emplace_pos`.
+static enum json_errc json_object_emplace_chars(
+    struct json_object *object, const char *key, json_size n, json_size *pos)
+{
+    struct json_string string;
+    enum json_errc ec;
 
-json_bool json_object_emplace_bool(
-    struct json_object *object, const char *key, json_size n, json_bool value,
-    struct json_allocator *alloc);
+    json_string_construct(&string, object->_alloc);
 
-json_bool json_object_emplace_int(
-    struct json_object *object, const char *key, json_size n, json_int value,
-    struct json_allocator *alloc);
+    if ((ec = json_string_append(&string, key, n)) ||
+        (ec = json_object_emplace_pos(object, &string, 0, pos))) {
+        json_string_destruct(&string);
+    }
 
-json_bool json_object_emplace_float(
-    struct json_object *object, const char *key, json_size n, json_float value,
-    struct json_allocator *alloc);
+    return ec;
+}
 
-json_bool json_object_emplace_string_copy(
+enum json_errc json_object_insert_copy(
     struct json_object *object, const char *key, json_size n,
-    const struct json_string *value, struct json_allocator *alloc);
+    const struct json_value *value, struct json_object_iter *it)
+{
+    json_size pos;
+    enum json_errc ec = json_object_emplace_chars(object, key, n, &pos);
+    struct json_entry *entry;
 
-json_bool json_object_emplace_string_move(
-    struct json_object *object, const char *key, json_size n,
-    struct json_string *value, struct json_allocator *alloc);
+    if (ec == JSON_ERRC_NOT_ENOUGH_MEMORY) {
+        return ec;
+    }
 
-json_bool json_object_emplace_array_copy(
-    struct json_object *object, const char *key, json_size n,
-    const struct json_array *value, struct json_allocator *alloc);
+    entry = json_object_entry_at(object, pos);
 
-json_bool json_object_emplace_array_move(
-    struct json_object *object, const char *key, json_size n,
-    struct json_array *value, struct json_allocator *alloc);
+    if (!ec && (ec = json_value_construct_copy(
+                    &entry->_value, value, object->_alloc))) {
+        json_value_construct(&entry->_value, object->_alloc);
+    }
 
-json_bool json_object_emplace_object_copy(
-    struct json_object *object, const char *key, json_size n,
-    const struct json_object *value, struct json_allocator *alloc);
+    if (it) {
+        json_object_iter_seek(object, pos, it);
+    }
 
-json_bool json_object_emplace_object_move(
+    return ec;
+}
+
+enum json_errc json_object_insert_move(
     struct json_object *object, const char *key, json_size n,
-    struct json_object *value, struct json_allocator *alloc);
+    struct json_value *value, struct json_object_iter *it)
+{
+    json_size pos;
+    enum json_errc ec = json_object_emplace_chars(object, key, n, &pos);
+    struct json_entry *entry;
 
-json_bool json_object_emplace_copy(
+    if (ec == JSON_ERRC_NOT_ENOUGH_MEMORY) {
+        return ec;
+    }
+
+    entry = json_object_entry_at(object, pos);
+
+    if (!ec && (ec = json_value_construct_move(
+                    &entry->_value, value, object->_alloc))) {
+        json_value_construct(&entry->_value, object->_alloc);
+    }
+
+    if (it) {
+        json_object_iter_seek(object, pos, it);
+    }
+
+    return ec;
+}
+
+enum json_errc json_object_emplace(
     struct json_object *object, const char *key, json_size n,
-    const struct json_value *value, struct json_allocator *alloc);
+    struct json_allocator *alloc)
+{
+    return json_object_emplace_null(object, key, n, alloc);
+}
 
-json_bool json_object_emplace_move(
+enum json_errc json_object_emplace_null(
     struct json_object *object, const char *key, json_size n,
-    struct json_value *value, struct json_allocator *alloc);
+    struct json_allocator *alloc)
+{
+    json_size pos;
+    enum json_errc ec = json_object_emplace_chars(object, key, n, &pos);
+
+    if (!ec) {
+        json_value_construct_null(
+            &json_object_entry_at(object, pos)->_value,
+            alloc ? alloc : object->_alloc);
+    }
+
+    return ec;
+}
+
+enum json_errc json_object_emplace_bool(
+    struct json_object *object, const char *key, json_size n, json_bool value,
+    struct json_allocator *alloc)
+{
+    json_size pos;
+    enum json_errc ec = json_object_emplace_chars(object, key, n, &pos);
+
+    if (!ec) {
+        json_value_construct_bool(
+            &json_object_entry_at(object, pos)->_value, value,
+            alloc ? alloc : object->_alloc);
+    }
+
+    return ec;
+}
+
+enum json_errc json_object_emplace_int(
+    struct json_object *object, const char *key, json_size n, json_int value,
+    struct json_allocator *alloc)
+{
+    json_size pos;
+    enum json_errc ec = json_object_emplace_chars(object, key, n, &pos);
+
+    if (!ec) {
+        json_value_construct_int(
+            &json_object_entry_at(object, pos)->_value, value,
+            alloc ? alloc : object->_alloc);
+    }
+
+    return ec;
+}
+
+enum json_errc json_object_emplace_float(
+    struct json_object *object, const char *key, json_size n, json_float value,
+    struct json_allocator *alloc)
+{
+    json_size pos;
+    enum json_errc ec = json_object_emplace_chars(object, key, n, &pos);
+
+    if (!ec) {
+        json_value_construct_float(
+            &json_object_entry_at(object, pos)->_value, value,
+            alloc ? alloc : object->_alloc);
+    }
+
+    return ec;
+}
+
+// A value that cannot be made leaves its entry null.
+#define JSON_DEFINE_JSON_OBJECT_EMPLACE(suffix, value_type)                   \
+    enum json_errc json_object_emplace_##suffix(                              \
+        struct json_object *object, const char *key, json_size n,             \
+        value_type value, struct json_allocator *alloc)                       \
+    {                                                                         \
+        json_size pos;                                                        \
+        struct json_value *slot;                                              \
+        enum json_errc ec;                                                    \
+        alloc = alloc ? alloc : object->_alloc;                               \
+        if ((ec = json_object_emplace_chars(object, key, n, &pos))) {         \
+            return ec;                                                        \
+        }                                                                     \
+        slot = &json_object_entry_at(object, pos)->_value;                    \
+        if ((ec = json_value_construct_##suffix(slot, value, alloc))) {       \
+            json_value_construct(slot, alloc);                                \
+        }                                                                     \
+        return ec;                                                            \
+    }
+
+JSON_DEFINE_JSON_OBJECT_EMPLACE(string_copy, const struct json_string *)
+JSON_DEFINE_JSON_OBJECT_EMPLACE(string_move, struct json_string *)
+JSON_DEFINE_JSON_OBJECT_EMPLACE(array_copy, const struct json_array *)
+JSON_DEFINE_JSON_OBJECT_EMPLACE(array_move, struct json_array *)
+JSON_DEFINE_JSON_OBJECT_EMPLACE(object_copy, const struct json_object *)
+JSON_DEFINE_JSON_OBJECT_EMPLACE(object_move, struct json_object *)
+JSON_DEFINE_JSON_OBJECT_EMPLACE(copy, const struct json_value *)
+JSON_DEFINE_JSON_OBJECT_EMPLACE(move, struct json_value *)
 
 struct json_object *json_object_new(struct json_allocator *alloc)
 {
@@ -320,21 +1124,8 @@ struct json_value *json_object_iter_value(struct json_object_iter *iter)
 
 void json_object_iter_next(struct json_object_iter *iter)
 {
-    if (!iter->_entry) {
-        return;
-    } else if (iter->_entry->_next) {
-        iter->_entry = iter->_entry->_next;
-    } else {
-        struct json_bucket *bucket =
-            json_object_next_bucket(iter->_object, iter->_pos + 1);
-
-        if (bucket) {
-            iter->_entry = bucket->_first;
-            iter->_pos = bucket - iter->_object->_buckets;
-        } else {
-            iter->_entry = NULL;
-            iter->_pos = iter->_object->_bucket_count - 1;
-        }
+    if (iter->_entry) {
+        json_object_iter_seek(iter->_object, iter->_pos + 1, iter);
     }
 }
 
@@ -0,0 +1,308 @@
+#include <string.h>
+#include <libjson/errc.h>
+#include <libjson/fwd.h>
+#include <libjson/io.h>
+#include <libjson/ondemand.h>
+#include <libjson/string.h>
+#include <libjson/type.h>
+#include "./reader.h"
+#include "./util.h"
+
+static inline struct json_reader json_ondemand_reader(
+    struct json_ondemand *doc, const char *ptr)
+{
+    return json_make_reader(ptr, doc->_last, &doc->_options);
+}
+
+// A scalar must not run on into more scalar characters, so that `1.5` is not
+// read as the integer `1` or `nullx` as `null`.
+static inline enum json_errc json_ondemand_end_scalar(
+    const struct json_reader *r)
+{
+    return r->first != r->last && json_is_scalar(*r->first)
+               ? JSON_ERRC_UNEXPECTED_TOKEN
+               : JSON_ERRC_OK;
+}
+
+void json_ondemand_construct(
+    struct json_ondemand *doc, const char *first, const char *last,
+    const struct json_read_options *options, struct json_allocator *alloc)
+{
+    doc->_first = first;
+    doc->_last = last;
+    doc->_options = options ? *options : json_default_read_options;
+    json_string_construct(&doc->_string, alloc);
+    json_string_construct(&doc->_key, alloc);
+}
+
+void json_ondemand_destruct(struct json_ondemand *doc)
+{
+    json_string_destruct(&doc->_key);
+    json_string_destruct(&doc->_string);
+}
+
+enum json_errc json_ondemand_root(
+    struct json_ondemand *doc, struct json_ondemand_value *value)
+{
+    struct json_reader r = json_ondemand_reader(doc, doc->_first);
+    enum json_errc ec;
+
+    if ((ec = json_reader_consume_space(&r))) {
+        return ec;
+    } else if (r.first == r.last) {
+        return JSON_ERRC_UNEXPECTED_TOKEN;
+    }
+
+    value->_doc = doc;
+    value->_ptr = r.first;
+    return JSON_ERRC_OK;
+}
+
+enum json_errc json_ondemand_get_type(
+    const struct json_ondemand_value *value, enum json_type *type)
+{
+    const char *p = value->_ptr;
+    const char *last = value->_doc->_last;
+
+    switch (*p) {
+    case 'n':
+        *type = JSON_TYPE_NULL;
+        return JSON_ERRC_OK;
+    case 't':
+    case 'f':
+        *type = JSON_TYPE_BOOL;
+        return JSON_ERRC_OK;
+    case '"':
+        *type = JSON_TYPE_STRING;
+        return JSON_ERRC_OK;
+    case '[':
+        *type = JSON_TYPE_ARRAY;
+        return JSON_ERRC_OK;
+    case '{':
+        *type = JSON_TYPE_OBJECT;
+        return JSON_ERRC_OK;
+    case '-':
+    case '0':
+    case '1':
+    case '2':
+    case '3':
+    case '4':
+    case '5':
+    case '6':
+    case '7':
+    case '8':
+    case '9':
+        *type = JSON_TYPE_INT;
+
+        for (; p != last && json_is_scalar(*p); ++p) {
+            if (*p == '.' || *p == 'e' || *p == 'E') {
+                *type = JSON_TYPE_FLOAT;
+                break;
+            }
+        }
+
+        return JSON_ERRC_OK;
+    default:
+        return JSON_ERRC_UNEXPECTED_TOKEN;
+    }
+}
+
+json_bool json_ondemand_is_null(const struct json_ondemand_value *value)
+{
+    struct json_reader r = json_ondemand_reader(value->_doc, value->_ptr);
+
+    return !json_reader_read_null(&r) && !json_ondemand_end_scalar(&r);
+}
+
+enum json_errc json_ondemand_get_bool(
+    const struct json_ondemand_value *value, json_bool *out)
+{
+    struct json_reader r = json_ondemand_reader(value->_doc, value->_ptr);
+    enum json_errc ec;
+
+    if ((ec = json_reader_read_bool(&r, out))) {
+        return ec;
+    }
+
+    return json_ondemand_end_scalar(&r);
+}
+
+enum json_errc json_ondemand_get_int(
+    const struct json_ondemand_value *value, json_int *out)
+{
+    struct json_reader r = json_ondemand_reader(value->_doc, value->_ptr);
+    enum json_errc ec;
+
+    if ((ec = json_reader_read_int(&r, out))) {
+        return ec;
+    }
+
+    return json_ondemand_end_scalar(&r);
+}
+
+enum json_errc json_ondemand_get_float(
+    const struct json_ondemand_value *value, json_float *out)
+{
+    struct json_reader r = json_ondemand_reader(value->_doc, value->_ptr);
+    enum json_errc ec;
+
+    if ((ec = json_reader_read_float(&r, out))) {
+        return ec;
+    }
+
+    return json_ondemand_end_scalar(&r);
+}
+
+enum json_errc json_ondemand_get_string(
+    const struct json_ondemand_value *value, const char **data, json_size *n)
+{
+    struct json_ondemand *doc = value->_doc;
+    struct json_reader r = json_ondemand_reader(doc, value->_ptr);
+
+    return json_reader_read_string_span(&r, &doc->_string, data, n);
+}
+
+static enum json_errc json_ondemand_begin(
+    const struct json_ondemand_value *value, struct json_ondemand_iter *iter,
+    char open, char close)
+{
+    if (*value->_ptr != open) {
+        return JSON_ERRC_UNEXPECTED_TOKEN;
+    }
+
+    iter->_doc = value->_doc;
+    iter->_ptr = value->_ptr + 1;
+    iter->_element = NULL;
+    iter->_close = close;
+    return JSON_ERRC_OK;
+}
+
+// Move past the previously returned element, leaving the reader at the start
+// of the next one.
+static enum json_errc json_ondemand_advance(
+    struct json_ondemand_iter *iter, struct json_reader *r, json_bool *done)
+{
+    enum json_errc ec;
+
+    *done = json_false;
+
+    if (!iter->_close) {
+        *done = json_true;
+        return JSON_ERRC_OK;
+    }
+
+    if (iter->_element) {
+        r->first = iter->_element;
+
+        if ((ec = json_reader_skip_value(r)) ||
+            (ec = json_reader_read_separator(r, iter->_close, done))) {
+            return ec;
+        }
+    } else if ((ec = json_reader_consume_space(r))) {
+        return ec;
+    } else if (r->first != r->last && *r->first == iter->_close) {
+        ++r->first;
+        *done = json_true;
+    }
+
+    if (*done) {
+        iter->_ptr = r->first;
+        iter->_close = 0;
+    }
+
+    return JSON_ERRC_OK;
+}
+
+enum json_errc json_ondemand_array_begin(
+    const struct json_ondemand_value *array, struct json_ondemand_iter *iter)
+{
+    return json_ondemand_begin(array, iter, '[', ']');
+}
+
+enum json_errc json_ondemand_array_next(
+    struct json_ondemand_iter *iter, struct json_ondemand_value *element,
+    json_bool *done)
+{
+    struct json_reader r = json_ondemand_reader(iter->_doc, iter->_ptr);
+    enum json_errc ec;
+
+    if ((ec = json_ondemand_advance(iter, &r, done)) || *done) {
+        return ec;
+    } else if ((ec = json_reader_consume_space(&r))) {
+        return ec;
+    } else if (r.first == r.last) {
+        return JSON_ERRC_UNEXPECTED_TOKEN;
+    }
+
+    iter->_ptr = r.first;
+    iter->_element = r.first;
+    element->_doc = iter->_doc;
+    element->_ptr = r.first;
+    return JSON_ERRC_OK;
+}
+
+enum json_errc json_ondemand_object_begin(
+    const struct json_ondemand_value *object, struct json_ondemand_iter *iter)
+{
+    return json_ondemand_begin(object, iter, '{', '}');
+}
+
+enum json_errc json_ondemand_object_next(
+    struct json_ondemand_iter *iter, const char **key, json_size *n,
+    struct json_ondemand_value *value, json_bool *done)
+{
+    struct json_ondemand *doc = iter->_doc;
+    struct json_reader r = json_ondemand_reader(doc, iter->_ptr);
+    enum json_errc ec;
+
+    if ((ec = json_ondemand_advance(iter, &r, done)) || *done) {
+        return ec;
+    } else if ((ec = json_reader_read_string_span(&r, &doc->_key, key, n)) ||
+               (ec = json_reader_consume_space(&r))) {
+        return ec;
+    } else if (r.first == r.last || *r.first != ':') {
+        return JSON_ERRC_UNEXPECTED_TOKEN;
+    }
+
+    ++r.first;
+
+    if ((ec = json_reader_consume_space(&r))) {
+        return ec;
+    } else if (r.first == r.last) {
+        return JSON_ERRC_UNEXPECTED_TOKEN;
+    }
+
+    iter->_ptr = r.first;
+    iter->_element = r.first;
+    value->_doc = doc;
+    value->_ptr = r.first;
+    return JSON_ERRC_OK;
+}
+
+enum json_errc json_ondemand_find_field(
+    const struct json_ondemand_value *object, const char *key, json_size n,
+    struct json_ondemand_value *out)
+{
+    struct json_ondemand_iter iter;
+    struct json_ondemand_value value;
+    const char *data;
+    json_size size;
+    json_bool done;
+    enum json_errc ec;
+
+    if ((ec = json_ondemand_object_begin(object, &iter))) {
+        return ec;
+    }
+
+    for (;;) {
+        if ((ec = json_ondemand_object_next(
+                 &iter, &data, &size, &value, &done))) {
+            return ec;
+        } else if (done) {
+            return JSON_ERRC_NOT_FOUND;
+        } else if (size == n && !memcmp(data, key, n)) {
+            *out = value;
+            return JSON_ERRC_OK;
+        }
+    }
+}
@@ -0,0 +1,248 @@
+#include <string.h>
+#include <threads.h>
+#include <libjson/array.h>
+#include <libjson/errc.h>
+#include <libjson/fwd.h>
+#include <libjson/io.h>
+#include <libjson/memory.h>
+#include <libjson/value.h>
+#include "./reader.h"
+#include "./structural.h"
+#include "./util.h"
+
+/**
+ * Inputs are not split into parts smaller than this; below it the cost of
+ * starting a thread is not recovered.
+ */
+#define JSON_PARALLEL_MIN_CHUNK_SIZE (1 << 20)
+
+struct json_parallel_chunk {
+    struct json_reader r;
+    struct json_array array;
+    thrd_t thread;
+    json_bool is_last;
+    json_bool started;
+    enum json_errc ec;
+};
+
+JSON_DEFINE_ALLOCATE_FUNCTION(json_allocate_chunks, struct json_parallel_chunk)
+JSON_DEFINE_DEALLOCATE_FUNCTION(
+    json_deallocate_chunks, struct json_parallel_chunk)
+
+// Read the elements of one part of the top level array. Every part but the
+// last ends just before the comma it was split at, and the last ends with the
+// closing bracket.
+static enum json_errc json_parallel_read_elements(
+    struct json_parallel_chunk *chunk)
+{
+    struct json_reader *r = &chunk->r;
+    struct json_array *array = &chunk->array;
+    json_bool done = json_false;
+    enum json_errc ec;
+
+    // The split may have been at a trailing comma.
+    if (chunk->is_last && r->options->accept_trailing_commas &&
+        *r->first == ']') {
+        ++r->first;
+        return JSON_ERRC_OK;
+    }
+
+    while (!done) {
+        if ((ec = json_array_emplace_back(
+                 array, json_array_get_allocator(array))) ||
+            (ec = json_reader_read_value(r, json_array_back(array)))) {
+            return ec;
+        }
+
+        if (chunk->is_last) {
+            if ((ec = json_reader_read_separator(r, ']', &done))) {
+                return ec;
+            }
+        } else if ((ec = json_reader_consume_space(r))) {
+            return ec;
+        } else if (r->first == r->last) {
+            done = json_true;
+        } else if (*r->first != ',') {
+            return JSON_ERRC_UNEXPECTED_TOKEN;
+        } else {
+            ++r->first;
+        }
+    }
+
+    return JSON_ERRC_OK;
+}
+
+static int json_parallel_run(void *arg)
+{
+    struct json_parallel_chunk *chunk = arg;
+
+    chunk->ec = json_parallel_read_elements(chunk);
+    return 0;
+}
+
+static void json_parallel_init_chunk(
+    struct json_parallel_chunk *chunk, struct json_reader *r,
+    const json_uint32 *start, const char *last, struct json_allocator *alloc)
+{
+    chunk->r = *r;
+    chunk->r.first = r->origin + *start;
+    chunk->r.last = last;
+    chunk->r.index = start;
+    chunk->r.depth = 1;
+    chunk->is_last = last == r->last;
+    chunk->started = json_false;
+    chunk->ec = JSON_ERRC_OK;
+    json_array_construct(&chunk->array, alloc);
+}
+
+// Split the top level array at the first element boundary past each of `n`
+// evenly spaced points, using the structural index to tell commas between
+// elements from those nested deeper or inside strings. Returns the number of
+// parts, or zero if the input is not an array that can be split.
+static json_size json_parallel_split(
+    struct json_reader *r, struct json_parallel_chunk *chunks, json_size n,
+    struct json_allocator *alloc)
+{
+    const char *first = r->origin;
+    json_size size = r->last - r->origin;
+    const json_uint32 *p = r->index;
+    const json_uint32 *start;
+    json_size depth = 1;
+    json_size k = 0;
+
+    if (*p == size || first[*p] != '[') {
+        return 0;
+    }
+
+    start = ++p;
+
+    // The last part is bounded by its closing bracket, so the scan stops at
+    // the last split.
+    for (; depth && k + 1 < n && *p != size; ++p) {
+        switch (first[*p]) {
+        case '[':
+        case '{':
+            ++depth;
+            break;
+        case ']':
+        case '}':
+            --depth;
+            break;
+        case ',':
+            if (depth == 1 && *p >= (k + 1) * (size / n)) {
+                json_parallel_init_chunk(
+                    chunks + k++, r, start, first + *p, alloc);
+                start = p + 1;
+            }
+
+            break;
+        }
+    }
+
+    if (!k) {
+        return 0;
+    }
+
+    json_parallel_init_chunk(chunks + k++, r, start, r->last, alloc);
+    return k;
+}
+
+// Move the elements of every part into `value`.
+static enum json_errc json_parallel_splice(
+    struct json_parallel_chunk *chunks, json_size n, struct json_value *value)
+{
+    struct json_array array;
+    json_size size = 0;
+    enum json_errc ec;
+
+    for (json_size k = 0; k < n; k++) {
+        size += chunks[k].array._size;
+    }
+
+    json_array_construct(&array, json_value_get_allocator(value));
+
+    if (!(ec = json_array_reserve(&array, size))) {
+        for (json_size k = 0; k < n; k++) {
+            struct json_array *part = &chunks[k].array;
+
+            memcpy(array._data + array._size, part->_data,
+                   part->_size * sizeof(*part->_data));
+            array._size += part->_size;
+            part->_size = 0;
+        }
+
+        ec = json_value_assign_array_move(value, &array);
+    }
+
+    json_array_destruct(&array);
+    return ec;
+}
+
+struct json_read_result json_read_value_parallel(
+    const char *first, const char *last, struct json_value *value,
+    const struct json_read_options *options, json_size threads)
+{
+    struct json_reader r = json_make_reader(first, last, options);
+    struct json_allocator *alloc = json_value_get_allocator(value);
+    struct json_structural_index index;
+    struct json_parallel_chunk *chunks;
+    json_size n = (last - first) / JSON_PARALLEL_MIN_CHUNK_SIZE;
+    json_size parts;
+    enum json_errc ec = JSON_ERRC_OK;
+
+    if (n > threads) {
+        n = threads;
+    }
+
+    if (n < 2 || !r.options->max_depth || !json_reader_use_index(&r)) {
+        return json_read_value(first, last, value, options);
+    } else if (json_structural_index_construct(&index, first, last, alloc)) {
+        return json_read_value(first, last, value, options);
+    } else if (!(chunks = json_allocate_chunks(alloc, n))) {
+        json_structural_index_destruct(&index);
+        return json_read_value(first, last, value, options);
+    }
+
+    r.index = index.positions;
+
+    if (!(parts = json_parallel_split(&r, chunks, n, alloc))) {
+        json_deallocate_chunks(alloc, chunks, n);
+        json_structural_index_destruct(&index);
+        return json_read_value(first, last, value, options);
+    }
+
+    // The first part is read on the calling thread, as is any part a thread
+    // could not be started for.
+    for (json_size k = 1; k < parts; k++) {
+        chunks[k].started = thrd_create(
+            &chunks[k].thread, json_parallel_run, chunks + k) == thrd_success;
+    }
+
+    json_parallel_run(chunks);
+
+    for (json_size k = 1; k < parts; k++) {
+        if (chunks[k].started) {
+            thrd_join(chunks[k].thread, NULL);
+        } else {
+            json_parallel_run(chunks + k);
+        }
+    }
+
+    // Report the first error in document order, as a single pass would.
+    for (json_size k = 0; k < parts && !ec; k++) {
+        ec = chunks[k].ec;
+        r.first = chunks[k].r.first;
+    }
+
+    if (!ec) {
+        ec = json_parallel_splice(chunks, parts, value);
+    }
+
+    for (json_size k = 0; k < parts; k++) {
+        json_array_destruct(&chunks[k].array);
+    }
+
+    json_deallocate_chunks(alloc, chunks, n);
+    json_structural_index_destruct(&index);
+    return (struct json_read_result){ .ec = ec, .ptr = r.first };
+}
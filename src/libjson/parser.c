@@ -0,0 +1,544 @@
+#include <string.h>
+#include <libjson/array.h>
+#include <libjson/errc.h>
+#include <libjson/fwd.h>
+#include <libjson/io.h>
+#include <libjson/object.h>
+#include <libjson/string.h>
+#include <libjson/type.h>
+#include <libjson/value.h>
+#include "./reader.h"
+#include "./simd.h"
+#include "./table.h"
+#include "./util.h"
+
+// What the parser expects next, ignoring whitespace and comments.
+enum {
+    JSON_PARSER_VALUE,
+    JSON_PARSER_ARRAY_FIRST,
+    JSON_PARSER_ARRAY_NEXT,
+    JSON_PARSER_OBJECT_FIRST,
+    JSON_PARSER_OBJECT_NEXT,
+    JSON_PARSER_COLON,
+    JSON_PARSER_SEPARATOR,
+    JSON_PARSER_DONE,
+};
+
+// Kind of the token buffered in `_token`, if any.
+enum {
+    JSON_PARSER_TOKEN_NONE,
+    JSON_PARSER_TOKEN_STRING,
+    JSON_PARSER_TOKEN_SCALAR,
+};
+
+enum {
+    JSON_PARSER_COMMENT_NONE,
+    JSON_PARSER_COMMENT_START,
+    JSON_PARSER_COMMENT_LINE,
+    JSON_PARSER_COMMENT_BLOCK,
+    JSON_PARSER_COMMENT_BLOCK_STAR,
+};
+
+JSON_DEFINE_ALLOCATE_FUNCTION(json_allocate_frames, struct json_value *)
+JSON_DEFINE_DEALLOCATE_FUNCTION(json_deallocate_frames, struct json_value *)
+
+void json_parser_construct(
+    struct json_parser *parser, struct json_value *value,
+    const struct json_read_options *options)
+{
+    parser->_options = options ? *options : json_default_read_options;
+    parser->_root = value;
+    parser->_alloc = json_value_get_allocator(value);
+    parser->_stack = NULL;
+    parser->_depth = 0;
+    parser->_stack_capacity = 0;
+    parser->_token = NULL;
+    parser->_token_size = 0;
+    parser->_token_capacity = 0;
+    parser->_ec = JSON_ERRC_OK;
+    parser->_state = JSON_PARSER_VALUE;
+    parser->_token_kind = JSON_PARSER_TOKEN_NONE;
+    parser->_comment = JSON_PARSER_COMMENT_NONE;
+    parser->_escape = json_false;
+    json_string_construct(&parser->_key, parser->_alloc);
+}
+
+void json_parser_destruct(struct json_parser *parser)
+{
+    json_string_destruct(&parser->_key);
+
+    if (parser->_stack) {
+        json_deallocate_frames(
+            parser->_alloc, parser->_stack, parser->_stack_capacity);
+    }
+
+    if (parser->_token) {
+        json_deallocate_chars(
+            parser->_alloc, parser->_token, parser->_token_capacity);
+    }
+}
+
+static enum json_errc json_parser_append_token(
+    struct json_parser *parser, const char *first, const char *last)
+{
+    json_size n = last - first;
+
+    if (parser->_token_size + n > parser->_token_capacity) {
+        json_size capacity = 2 * parser->_token_capacity;
+        char *token;
+
+        if (capacity < parser->_token_size + n) {
+            capacity = parser->_token_size + n;
+        }
+
+        if (!(token = json_allocate_chars(parser->_alloc, capacity))) {
+            return JSON_ERRC_NOT_ENOUGH_MEMORY;
+        }
+
+        if (parser->_token) {
+            memcpy(token, parser->_token, parser->_token_size);
+            json_deallocate_chars(
+                parser->_alloc, parser->_token, parser->_token_capacity);
+        }
+
+        parser->_token = token;
+        parser->_token_capacity = capacity;
+    }
+
+    memcpy(parser->_token + parser->_token_size, first, n);
+    parser->_token_size += n;
+    return JSON_ERRC_OK;
+}
+
+static enum json_errc json_parser_push(
+    struct json_parser *parser, struct json_value *value)
+{
+    if (parser->_depth == parser->_stack_capacity) {
+        json_size capacity =
+            parser->_stack_capacity ? 2 * parser->_stack_capacity : 16;
+        struct json_value **stack =
+            json_allocate_frames(parser->_alloc, capacity);
+
+        if (!stack) {
+            return JSON_ERRC_NOT_ENOUGH_MEMORY;
+        }
+
+        if (parser->_stack) {
+            memcpy(stack, parser->_stack, parser->_depth * sizeof(*stack));
+            json_deallocate_frames(
+                parser->_alloc, parser->_stack, parser->_stack_capacity);
+        }
+
+        parser->_stack = stack;
+        parser->_stack_capacity = capacity;
+    }
+
+    parser->_stack[parser->_depth++] = value;
+    return JSON_ERRC_OK;
+}
+
+static inline struct json_value *json_parser_top(struct json_parser *parser)
+{
+    return parser->_stack[parser->_depth - 1];
+}
+
+// Find the value the next token is read into: the root, a new element of the
+// current array, or the entry of the current object for the pending key.
+static enum json_errc json_parser_emplace(
+    struct json_parser *parser, struct json_value **slot)
+{
+    struct json_value *top;
+    struct json_array *array;
+    struct json_entry *entry;
+    enum json_errc ec;
+
+    if (!parser->_depth) {
+        *slot = parser->_root;
+        return JSON_ERRC_OK;
+    }
+
+    top = json_parser_top(parser);
+
+    if (json_value_is_array(top)) {
+        array = json_value_as_array(top);
+
+        if ((ec = json_array_emplace_back(
+                 array, json_array_get_allocator(array)))) {
+            return ec;
+        }
+
+        *slot = json_array_back(array);
+        return JSON_ERRC_OK;
+    }
+
+    ec = json_object_emplace_entry(
+        json_value_as_object(top), &parser->_key, &entry);
+
+    if (ec == JSON_ERRC_DUPLICATE_KEY &&
+        parser->_options.accept_duplicate_keys) {
+        json_value_assign_null(&entry->_value);
+    } else if (ec) {
+        return ec;
+    }
+
+    *slot = &entry->_value;
+    return JSON_ERRC_OK;
+}
+
+static inline void json_parser_end_value(struct json_parser *parser)
+{
+    parser->_state =
+        parser->_depth ? JSON_PARSER_SEPARATOR : JSON_PARSER_DONE;
+}
+
+static enum json_errc json_parser_open(struct json_parser *parser, char c)
+{
+    struct json_value *slot;
+    struct json_array array;
+    struct json_object object;
+    enum json_errc ec;
+
+    if (parser->_depth >= parser->_options.max_depth) {
+        return JSON_ERRC_MAX_DEPTH;
+    } else if ((ec = json_parser_emplace(parser, &slot))) {
+        return ec;
+    }
+
+    if (c == '[') {
+        json_array_construct(&array, parser->_alloc);
+        ec = json_value_assign_array_move(slot, &array);
+        json_array_destruct(&array);
+        parser->_state = JSON_PARSER_ARRAY_FIRST;
+    } else {
+        json_object_construct(&object, parser->_alloc);
+        ec = json_value_assign_object_move(slot, &object);
+        json_object_destruct(&object);
+        parser->_state = JSON_PARSER_OBJECT_FIRST;
+    }
+
+    return ec ? ec : json_parser_push(parser, slot);
+}
+
+static enum json_errc json_parser_close(struct json_parser *parser, char c)
+{
+    json_bool is_array = c == ']';
+
+    if (!parser->_depth ||
+        json_value_is_array(json_parser_top(parser)) != is_array) {
+        return JSON_ERRC_UNEXPECTED_TOKEN;
+    }
+
+    --parser->_depth;
+    json_parser_end_value(parser);
+    return JSON_ERRC_OK;
+}
+
+// Read a complete string, number or literal token.
+static enum json_errc json_parser_read_token(
+    struct json_parser *parser, const char *first, const char *last)
+{
+    struct json_reader r = json_make_reader(first, last, &parser->_options);
+    struct json_value *slot;
+    json_bool bool_value;
+    enum json_errc ec;
+
+    if (parser->_state == JSON_PARSER_OBJECT_FIRST ||
+        parser->_state == JSON_PARSER_OBJECT_NEXT) {
+        if ((ec = json_reader_read_string(&r, &parser->_key))) {
+            return ec;
+        }
+
+        parser->_state = JSON_PARSER_COLON;
+    } else if ((ec = json_parser_emplace(parser, &slot))) {
+        return ec;
+    } else {
+        switch (*first) {
+        case 'n':
+            if (!(ec = json_reader_read_null(&r))) {
+                json_value_assign_null(slot);
+            }
+            break;
+        case 't':
+        case 'f':
+            if (!(ec = json_reader_read_bool(&r, &bool_value))) {
+                json_value_assign_bool(slot, bool_value);
+            }
+            break;
+        case '"':
+            ec = json_reader_read_value_string(&r, slot);
+            break;
+        default:
+            ec = json_reader_read_value_number(&r, slot);
+            break;
+        }
+
+        if (ec) {
+            return ec;
+        }
+
+        json_parser_end_value(parser);
+    }
+
+    return r.first == last ? JSON_ERRC_OK : JSON_ERRC_UNEXPECTED_TOKEN;
+}
+
+// Find the end of the current token in `[p, last)`. Sets `*done` if the token
+// ends before `last`; the state of an unfinished string is kept in `_escape`.
+static const char *json_parser_scan_token(
+    struct json_parser *parser, const char *p, const char *last,
+    json_bool *done)
+{
+    *done = json_false;
+
+    if (parser->_token_kind == JSON_PARSER_TOKEN_SCALAR) {
+        while (p != last && json_is_scalar(*p)) {
+            ++p;
+        }
+
+        *done = p != last;
+        return p;
+    }
+
+    if (parser->_escape && p != last) {
+        parser->_escape = json_false;
+        ++p;
+    }
+
+    while ((p = json_simd_find_string_special(p, last)) != last) {
+        if (*p != '\\') {
+            // A closing quote, or a control character the reader rejects.
+            *done = json_true;
+            return p + 1;
+        } else if (last - p < 2) {
+            parser->_escape = json_true;
+            return last;
+        }
+
+        p += 2;
+    }
+
+    return p;
+}
+
+// Consume the token starting at `p`, reading it in place if it ends within
+// the chunk and buffering it otherwise.
+static const char *json_parser_consume_token(
+    struct json_parser *parser, const char *p, const char *last)
+{
+    const char *end;
+    json_bool done;
+
+    if (*p == '"') {
+        parser->_token_kind = JSON_PARSER_TOKEN_STRING;
+        end = json_parser_scan_token(parser, p + 1, last, &done);
+    } else {
+        parser->_token_kind = JSON_PARSER_TOKEN_SCALAR;
+        end = json_parser_scan_token(parser, p, last, &done);
+    }
+
+    if (done) {
+        parser->_token_kind = JSON_PARSER_TOKEN_NONE;
+        parser->_ec = json_parser_read_token(parser, p, end);
+    } else {
+        parser->_ec = json_parser_append_token(parser, p, end);
+    }
+
+    return end;
+}
+
+// Continue a token that was split at the end of the previous chunk.
+static const char *json_parser_continue_token(
+    struct json_parser *parser, const char *p, const char *last)
+{
+    json_bool done;
+    const char *end = json_parser_scan_token(parser, p, last, &done);
+
+    if ((parser->_ec = json_parser_append_token(parser, p, end)) || !done) {
+        return end;
+    }
+
+    parser->_token_kind = JSON_PARSER_TOKEN_NONE;
+    parser->_ec = json_parser_read_token(
+        parser, parser->_token, parser->_token + parser->_token_size);
+    parser->_token_size = 0;
+    return end;
+}
+
+static const char *json_parser_consume_comment(
+    struct json_parser *parser, const char *p, const char *last)
+{
+    const char *end;
+
+    switch (parser->_comment) {
+    case JSON_PARSER_COMMENT_START:
+        if (*p == '/') {
+            parser->_comment = JSON_PARSER_COMMENT_LINE;
+        } else if (*p == '*') {
+            parser->_comment = JSON_PARSER_COMMENT_BLOCK;
+        } else {
+            parser->_ec = JSON_ERRC_UNEXPECTED_TOKEN;
+            return p;
+        }
+
+        return p + 1;
+    case JSON_PARSER_COMMENT_LINE:
+        if (!(end = memchr(p, '\n', last - p))) {
+            return last;
+        }
+
+        parser->_comment = JSON_PARSER_COMMENT_NONE;
+        return end + 1;
+    case JSON_PARSER_COMMENT_BLOCK:
+        if (!(end = memchr(p, '*', last - p))) {
+            return last;
+        }
+
+        parser->_comment = JSON_PARSER_COMMENT_BLOCK_STAR;
+        return end + 1;
+    case JSON_PARSER_COMMENT_BLOCK_STAR:
+        if (*p == '/') {
+            parser->_comment = JSON_PARSER_COMMENT_NONE;
+        } else if (*p != '*') {
+            parser->_comment = JSON_PARSER_COMMENT_BLOCK;
+        }
+
+        return p + 1;
+    default:
+        json_unreachable();
+    }
+}
+
+// Handle a structural character; anything else starts a token.
+static enum json_errc json_parser_consume_char(
+    struct json_parser *parser, char c)
+{
+    switch (c) {
+    case '[':
+    case '{':
+        switch (parser->_state) {
+        case JSON_PARSER_VALUE:
+        case JSON_PARSER_ARRAY_FIRST:
+        case JSON_PARSER_ARRAY_NEXT:
+            return json_parser_open(parser, c);
+        }
+        break;
+    case ']':
+        switch (parser->_state) {
+        case JSON_PARSER_ARRAY_NEXT:
+            if (!parser->_options.accept_trailing_commas) {
+                break;
+            }
+        case JSON_PARSER_ARRAY_FIRST:
+        case JSON_PARSER_SEPARATOR:
+            return json_parser_close(parser, c);
+        }
+        break;
+    case '}':
+        switch (parser->_state) {
+        case JSON_PARSER_OBJECT_NEXT:
+            if (!parser->_options.accept_trailing_commas) {
+                break;
+            }
+        case JSON_PARSER_OBJECT_FIRST:
+        case JSON_PARSER_SEPARATOR:
+            return json_parser_close(parser, c);
+        }
+        break;
+    case ',':
+        if (parser->_state == JSON_PARSER_SEPARATOR) {
+            parser->_state = json_value_is_array(json_parser_top(parser))
+                                 ? JSON_PARSER_ARRAY_NEXT
+                                 : JSON_PARSER_OBJECT_NEXT;
+            return JSON_ERRC_OK;
+        }
+        break;
+    case ':':
+        if (parser->_state == JSON_PARSER_COLON) {
+            parser->_state = JSON_PARSER_VALUE;
+            return JSON_ERRC_OK;
+        }
+        break;
+    }
+
+    return JSON_ERRC_UNEXPECTED_TOKEN;
+}
+
+// Whether a token may start in the current state.
+static inline json_bool json_parser_expects_token(
+    const struct json_parser *parser, char c)
+{
+    switch (parser->_state) {
+    case JSON_PARSER_VALUE:
+    case JSON_PARSER_ARRAY_FIRST:
+    case JSON_PARSER_ARRAY_NEXT:
+        return json_true;
+    case JSON_PARSER_OBJECT_FIRST:
+    case JSON_PARSER_OBJECT_NEXT:
+        return c == '"';
+    default:
+        return json_false;
+    }
+}
+
+enum json_errc json_parser_feed(
+    struct json_parser *parser, const char *chunk, json_size n)
+{
+    const char *p = chunk;
+    const char *last = chunk + n;
+
+    if (!parser->_ec && parser->_token_kind != JSON_PARSER_TOKEN_NONE) {
+        p = json_parser_continue_token(parser, p, last);
+    }
+
+    while (!parser->_ec && p != last) {
+        if (parser->_comment != JSON_PARSER_COMMENT_NONE) {
+            p = json_parser_consume_comment(parser, p, last);
+        } else if (json_is_space(*p)) {
+            ++p;
+        } else if (*p == '/') {
+            if (!parser->_options.accept_comments) {
+                parser->_ec = JSON_ERRC_UNEXPECTED_TOKEN;
+            } else {
+                parser->_comment = JSON_PARSER_COMMENT_START;
+                ++p;
+            }
+        } else if (*p == '"' || json_is_scalar(*p)) {
+            if (!json_parser_expects_token(parser, *p)) {
+                parser->_ec = JSON_ERRC_UNEXPECTED_TOKEN;
+            } else {
+                p = json_parser_consume_token(parser, p, last);
+            }
+        } else {
+            parser->_ec = json_parser_consume_char(parser, *p++);
+        }
+    }
+
+    return parser->_ec;
+}
+
+enum json_errc json_parser_finish(struct json_parser *parser)
+{
+    if (parser->_ec) {
+        return parser->_ec;
+    }
+
+    if (parser->_token_kind == JSON_PARSER_TOKEN_SCALAR) {
+        parser->_token_kind = JSON_PARSER_TOKEN_NONE;
+        parser->_ec = json_parser_read_token(
+            parser, parser->_token, parser->_token + parser->_token_size);
+        parser->_token_size = 0;
+
+        if (parser->_ec) {
+            return parser->_ec;
+        }
+    }
+
+    if (parser->_token_kind != JSON_PARSER_TOKEN_NONE ||
+        (parser->_comment != JSON_PARSER_COMMENT_NONE &&
+         parser->_comment != JSON_PARSER_COMMENT_LINE) ||
+        parser->_state != JSON_PARSER_DONE) {
+        parser->_ec = JSON_ERRC_UNEXPECTED_TOKEN;
+    }
+
+    return parser->_ec;
+}
@@ -0,0 +1,148 @@
+#ifndef LIBJSON_SRC_READER_H_
+#define LIBJSON_SRC_READER_H_
+
+#include <libjson/errc.h>
+#include <libjson/fwd.h>
+#include <libjson/io.h>
+#include "./structural.h"
+#include "./util.h"
+
+/**
+ * Cursor over an input buffer shared by the read functions and the parsers
+ * built on top of them.
+ */
+struct json_reader {
+    const char *first;
+    const char *last;
+    const struct json_read_options *options;
+    json_size depth;
+
+    /* Start of the input the structural index was built over. */
+    const char *origin;
+
+    /* Cursor into the structural index of a parallel read, or `NULL`. */
+    const json_uint32 *index;
+
+    /* Writable alias of `origin` when reading in situ, or `NULL`. */
+    char *buffer;
+};
+
+extern const struct json_read_options json_default_read_options;
+
+static inline struct json_reader json_make_reader(
+    const char *first, const char *last,
+    const struct json_read_options *options)
+{
+    return (struct json_reader){
+        .depth = 0,
+        .first = first,
+        .last = last,
+        .options = options ? options : &json_default_read_options,
+        .origin = first,
+        .index = NULL,
+        .buffer = NULL
+    };
+}
+
+static inline json_bool json_reader_use_index(const struct json_reader *r)
+{
+    return r->last - r->first >= JSON_STRUCTURAL_INDEX_MIN_SIZE &&
+           !r->options->accept_comments;
+}
+
+static inline json_bool json_is_space(char c)
+{
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+static inline json_bool json_is_digit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+/**
+ * Whether `c` may be part of a number or literal.
+ */
+static inline json_bool json_is_scalar(char c)
+{
+    switch (c) {
+    case ' ':
+    case '\n':
+    case '\r':
+    case '\t':
+    case '"':
+    case ',':
+    case ':':
+    case '[':
+    case ']':
+    case '{':
+    case '}':
+    case '/':
+        return json_false;
+    default:
+        return json_true;
+    }
+}
+
+enum json_errc json_reader_consume_space(struct json_reader *r);
+
+enum json_errc json_reader_read_null(struct json_reader *r);
+
+enum json_errc json_reader_read_bool(struct json_reader *r, json_bool *value);
+
+enum json_errc json_reader_read_int(struct json_reader *r, json_int *value);
+
+enum json_errc json_reader_read_float(struct json_reader *r, json_float *value);
+
+enum json_errc json_reader_read_string(
+    struct json_reader *r, struct json_string *value);
+
+/**
+ * Read a string without copying it if possible.
+ *
+ * Sets `[*data, *data + *n)` to the string body in the input if it contains
+ * no escapes, and otherwise unescapes it into `buffer`.
+ */
+enum json_errc json_reader_read_string_span(
+    struct json_reader *r, struct json_string *buffer, const char **data,
+    json_size *n);
+
+/**
+ * Skip the next value without reading it.
+ *
+ * Containers are skipped by matching brackets; their contents are not
+ * validated beyond finding the ends of strings.
+ */
+enum json_errc json_reader_skip_value(struct json_reader *r);
+
+/**
+ * Find the closing quote of the string body starting at `r->first`.
+ */
+enum json_errc json_reader_find_string_end(
+    struct json_reader *r, const char **end);
+
+/**
+ * Consume the separator after an array element or object entry. Sets `*done`
+ * if the closing bracket `close` was consumed instead.
+ */
+enum json_errc json_reader_read_separator(
+    struct json_reader *r, char close, json_bool *done);
+
+/**
+ * Read a number as a `json_int` if it is an integer that fits in one, and as
+ * a `json_float` otherwise. Sets `*is_int` to tell which was read.
+ */
+enum json_errc json_reader_read_number(
+    struct json_reader *r, json_int *int_value, json_float *float_value,
+    json_bool *is_int);
+
+enum json_errc json_reader_read_value_number(
+    struct json_reader *r, struct json_value *value);
+
+enum json_errc json_reader_read_value_string(
+    struct json_reader *r, struct json_value *value);
+
+enum json_errc json_reader_read_value(
+    struct json_reader *r, struct json_value *value);
+
+#endif
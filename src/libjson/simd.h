@@ -0,0 +1,360 @@
+#ifndef LIBJSON_SRC_SIMD_H_
+#define LIBJSON_SRC_SIMD_H_
+
+#include <stdint.h>
+#include "./util.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define JSON_SIMD_AVX2 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define JSON_SIMD_SSE2 1
+#endif
+
+#if defined(__PCLMUL__)
+#include <wmmintrin.h>
+#endif
+
+#if JSON_SIMD_AVX2 || JSON_SIMD_SSE2
+static inline __m128i json_simd_load128(const char *p)
+{
+    const void *q = p;
+    return _mm_loadu_si128(q);
+}
+#endif
+
+/**
+ * Character class bitmasks of a 64 byte block, one bit per byte with the
+ * least significant bit corresponding to the first byte.
+ */
+struct json_simd_block {
+    json_uint64 quote;
+    json_uint64 backslash;
+    json_uint64 space;
+    json_uint64 op;
+};
+
+#if JSON_SIMD_AVX2
+
+static inline __m256i json_simd_load(const char *p)
+{
+    const void *q = p;
+    return _mm256_loadu_si256(q);
+}
+
+static inline json_uint64 json_simd_movemask2(__m256i lo, __m256i hi)
+{
+    return (json_uint64)(uint32_t)_mm256_movemask_epi8(lo) |
+           (json_uint64)(uint32_t)_mm256_movemask_epi8(hi) << 32;
+}
+
+static inline json_uint64 json_simd_eq(__m256i lo, __m256i hi, char c)
+{
+    __m256i v = _mm256_set1_epi8(c);
+    return json_simd_movemask2(
+        _mm256_cmpeq_epi8(lo, v), _mm256_cmpeq_epi8(hi, v));
+}
+
+static inline void json_simd_classify(
+    const char *p, struct json_simd_block *block)
+{
+    __m256i lo = json_simd_load(p);
+    __m256i hi = json_simd_load(p + 32);
+
+    block->quote = json_simd_eq(lo, hi, '"');
+    block->backslash = json_simd_eq(lo, hi, '\\');
+    block->space = json_simd_eq(lo, hi, ' ') | json_simd_eq(lo, hi, '\t') |
+                   json_simd_eq(lo, hi, '\n') | json_simd_eq(lo, hi, '\r');
+    block->op = json_simd_eq(lo, hi, '{') | json_simd_eq(lo, hi, '}') |
+                json_simd_eq(lo, hi, '[') | json_simd_eq(lo, hi, ']') |
+                json_simd_eq(lo, hi, ':') | json_simd_eq(lo, hi, ',');
+}
+
+#elif JSON_SIMD_SSE2
+
+static inline __m128i json_simd_load(const char *p)
+{
+    return json_simd_load128(p);
+}
+
+static inline json_uint64 json_simd_eq(const __m128i *v, char c)
+{
+    __m128i m = _mm_set1_epi8(c);
+    return (json_uint64)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v[0], m)) |
+           (json_uint64)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v[1], m))
+               << 16 |
+           (json_uint64)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v[2], m))
+               << 32 |
+           (json_uint64)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v[3], m))
+               << 48;
+}
+
+static inline void json_simd_classify(
+    const char *p, struct json_simd_block *block)
+{
+    __m128i v[4] = {
+        json_simd_load(p),
+        json_simd_load(p + 16),
+        json_simd_load(p + 32),
+        json_simd_load(p + 48),
+    };
+
+    block->quote = json_simd_eq(v, '"');
+    block->backslash = json_simd_eq(v, '\\');
+    block->space = json_simd_eq(v, ' ') | json_simd_eq(v, '\t') |
+                   json_simd_eq(v, '\n') | json_simd_eq(v, '\r');
+    block->op = json_simd_eq(v, '{') | json_simd_eq(v, '}') |
+                json_simd_eq(v, '[') | json_simd_eq(v, ']') |
+                json_simd_eq(v, ':') | json_simd_eq(v, ',');
+}
+
+#else
+
+static inline void json_simd_classify(
+    const char *p, struct json_simd_block *block)
+{
+    block->quote = 0;
+    block->backslash = 0;
+    block->space = 0;
+    block->op = 0;
+
+    for (json_size i = 0; i < 64; i++) {
+        json_uint64 bit = (json_uint64)1 << i;
+
+        switch (p[i]) {
+        case '"':
+            block->quote |= bit;
+            break;
+        case '\\':
+            block->backslash |= bit;
+            break;
+        case ' ':
+        case '\t':
+        case '\n':
+        case '\r':
+            block->space |= bit;
+            break;
+        case '{':
+        case '}':
+        case '[':
+        case ']':
+        case ':':
+        case ',':
+            block->op |= bit;
+            break;
+        }
+    }
+}
+
+#endif
+
+/**
+ * Bitmask of the bytes equal to `c` in the 64 byte block at `p`.
+ */
+static inline json_uint64 json_simd_eq_block(const char *p, char c)
+{
+#if JSON_SIMD_AVX2
+    return json_simd_eq(json_simd_load(p), json_simd_load(p + 32), c);
+#elif JSON_SIMD_SSE2
+    __m128i v[4] = {
+        json_simd_load(p),
+        json_simd_load(p + 16),
+        json_simd_load(p + 32),
+        json_simd_load(p + 48),
+    };
+
+    return json_simd_eq(v, c);
+#else
+    json_uint64 mask = 0;
+
+    for (json_size i = 0; i < 64; i++) {
+        mask |= (json_uint64)(p[i] == c) << i;
+    }
+
+    return mask;
+#endif
+}
+
+/**
+ * Inclusive prefix xor; bit `i` of the result is the parity of bits `0..i`.
+ */
+static inline json_uint64 json_simd_prefix_xor(json_uint64 value)
+{
+#if defined(__PCLMUL__)
+    return (json_uint64)_mm_cvtsi128_si64(_mm_clmulepi64_si128(
+        _mm_set_epi64x(0, (long long)value), _mm_set1_epi8((char)0xFF), 0));
+#else
+    value ^= value << 1;
+    value ^= value << 2;
+    value ^= value << 4;
+    value ^= value << 8;
+    value ^= value << 16;
+    value ^= value << 32;
+    return value;
+#endif
+}
+
+static inline unsigned json_simd_ctz(json_uint64 value)
+{
+#if JSON_HAS_BUILTIN(__builtin_ctzll)
+    return __builtin_ctzll(value);
+#else
+    unsigned n = 0;
+
+    for (; !(value & 1); value >>= 1) {
+        ++n;
+    }
+
+    return n;
+#endif
+}
+
+#define JSON_SIMD_BROADCAST(c) ((json_uint64)0x0101010101010101ull * (c))
+
+/**
+ * Nonzero if any byte of the word is zero.
+ */
+static inline json_uint64 json_swar_has_zero(json_uint64 word)
+{
+    return (word - JSON_SIMD_BROADCAST(0x01)) & ~word &
+           JSON_SIMD_BROADCAST(0x80);
+}
+
+/**
+ * Nonzero if any byte of the word is less than `0x20`.
+ */
+static inline json_uint64 json_swar_has_control(json_uint64 word)
+{
+    return (word - JSON_SIMD_BROADCAST(0x20)) & ~word &
+           JSON_SIMD_BROADCAST(0x80);
+}
+
+static inline json_bool json_string_is_special(char c)
+{
+    return c == '"' || c == '\\' || (unsigned char)c < 0x20;
+}
+
+/**
+ * Find the first byte in `[first, last)` that ends a clean run of string
+ * characters: a quote, a backslash, or a control character. Returns `last` if
+ * there is none.
+ */
+static inline const char *json_simd_find_string_special(
+    const char *first, const char *last)
+{
+#if JSON_SIMD_AVX2
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i control = _mm256_set1_epi8(0x1F);
+
+    for (; last - first >= 32; first += 32) {
+        __m256i v = json_simd_load(first);
+        __m256i m = _mm256_or_si256(
+            _mm256_or_si256(
+                _mm256_cmpeq_epi8(v, quote), _mm256_cmpeq_epi8(v, backslash)),
+            _mm256_cmpeq_epi8(_mm256_min_epu8(v, control), v));
+        uint32_t mask = _mm256_movemask_epi8(m);
+
+        if (mask) {
+            return first + json_simd_ctz(mask);
+        }
+    }
+#elif JSON_SIMD_SSE2
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x1F);
+
+    for (; last - first >= 16; first += 16) {
+        __m128i v = json_simd_load(first);
+        __m128i m = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)),
+            _mm_cmpeq_epi8(_mm_min_epu8(v, control), v));
+        unsigned mask = _mm_movemask_epi8(m);
+
+        if (mask) {
+            return first + json_simd_ctz(mask);
+        }
+    }
+#else
+    for (; last - first >= 8; first += 8) {
+        json_uint64 word = json_load_unaligned_le64(first);
+
+        if (json_swar_has_zero(word ^ JSON_SIMD_BROADCAST('"')) ||
+            json_swar_has_zero(word ^ JSON_SIMD_BROADCAST('\\')) ||
+            json_swar_has_control(word)) {
+            break;
+        }
+    }
+
+#endif
+
+    for (; first != last; ++first) {
+        if (json_string_is_special(*first)) {
+            break;
+        }
+    }
+
+    return first;
+}
+
+static inline json_bool json_is_bracket(char c)
+{
+    return c == '"' || c == '[' || c == ']' || c == '{' || c == '}' ||
+           c == '/';
+}
+
+/**
+ * Find the first quote, bracket or slash in `[first, last)`, the bytes that
+ * matter when skipping over a container. Returns `last` if there is none.
+ */
+static inline const char *json_simd_find_bracket(
+    const char *first, const char *last)
+{
+#if JSON_SIMD_AVX2
+    for (; last - first >= 32; first += 32) {
+        __m256i v = json_simd_load(first);
+        // Clearing bit 5 folds `{}` onto `[]`.
+        __m256i w = _mm256_and_si256(v, _mm256_set1_epi8((char)0xDF));
+        __m256i m = _mm256_or_si256(
+            _mm256_or_si256(
+                _mm256_cmpeq_epi8(w, _mm256_set1_epi8('[')),
+                _mm256_cmpeq_epi8(w, _mm256_set1_epi8(']'))),
+            _mm256_or_si256(
+                _mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')),
+                _mm256_cmpeq_epi8(v, _mm256_set1_epi8('/'))));
+        uint32_t mask = _mm256_movemask_epi8(m);
+
+        if (mask) {
+            return first + json_simd_ctz(mask);
+        }
+    }
+#elif JSON_SIMD_SSE2
+    for (; last - first >= 16; first += 16) {
+        __m128i v = json_simd_load(first);
+        __m128i w = _mm_and_si128(v, _mm_set1_epi8((char)0xDF));
+        __m128i m = _mm_or_si128(
+            _mm_or_si128(
+                _mm_cmpeq_epi8(w, _mm_set1_epi8('[')),
+                _mm_cmpeq_epi8(w, _mm_set1_epi8(']'))),
+            _mm_or_si128(
+                _mm_cmpeq_epi8(v, _mm_set1_epi8('"')),
+                _mm_cmpeq_epi8(v, _mm_set1_epi8('/'))));
+        unsigned mask = _mm_movemask_epi8(m);
+
+        if (mask) {
+            return first + json_simd_ctz(mask);
+        }
+    }
+#endif
+
+    for (; first != last; ++first) {
+        if (json_is_bracket(*first)) {
+            break;
+        }
+    }
+
+    return first;
+}
+
+#endif
@@ -4,36 +4,62 @@
 #include <libjson/string.h>
 #include "./util.h"
 
-static struct {
-    json_size size;
-    json_size capacity;
-    char data;
-} json_string_impl_null = {};
+// The inline characters, their null terminator and the tag byte cover exactly
+// the pointer, size and capacity of a string on the heap.
+_Static_assert(
+    sizeof(((struct json_string *)0)->_inline) ==
+        sizeof(((struct json_string *)0)->_heap),
+    "inline characters must cover the heap fields");
+_Static_assert(
+    sizeof(struct json_string) ==
+        sizeof(struct json_allocator *) + sizeof(char *) +
+            2 * sizeof(json_size),
+    "strings must be four words");
+_Static_assert(
+    sizeof(char *) != 8 || sizeof(json_size) != 8 ||
+        (sizeof(struct json_string) == 32 &&
+         JSON_STRING_INLINE_CAPACITY == 22),
+    "strings must be 32 bytes with 22 inline characters on 64-bit targets");
+_Static_assert(
+    JSON_STRING_INLINE_CAPACITY < JSON_STRING_INLINE,
+    "the inline size must fit in the tag byte");
+
+// Allocate owned storage for `capacity` characters and the null terminator.
+static char *json_string_allocate(
+    json_size capacity, struct json_allocator *alloc)
+{
+    return json_allocate_chars(alloc, capacity + 1);
+}
 
-static struct json_string_impl *json_string_impl_new(
-    json_size size, json_size capacity, struct json_allocator *alloc)
+// Only strings with characters on the heap own an allocation; inline strings
+// have the inline flag set and borrowed ones have no capacity.
+static json_bool json_string_is_allocated(const struct json_string *string)
 {
-    struct json_string_impl *impl = json_allocator_allocate(
-        alloc, sizeof(*impl) + capacity + 1, _Alignof(*impl));
+    return !json_string_is_inline(string) &&
+           json_string_heap_capacity(string);
+}
 
-    if (impl) {
-        impl->_size = size;
-        impl->_capacity = capacity;
+static void json_string_deallocate(struct json_string *string)
+{
+    if (json_string_is_allocated(string)) {
+        json_deallocate_chars(
+            string->_alloc, string->_heap._data,
+            json_string_heap_capacity(string) + 1);
     }
-
-    return impl;
 }
 
-static void json_string_impl_delete(
-    struct json_string_impl *impl, struct json_allocator *alloc)
+static void json_string_set_null(struct json_string *string)
 {
-    json_allocator_deallocate(
-        alloc, impl, sizeof(*impl) + impl->_capacity + 1, _Alignof(*impl));
+    json_string_set_inline(string, 0);
 }
 
-static void json_string_set_null(struct json_string *string)
+// Take over the characters of `other`, leaving it empty. Nothing points into
+// a string, so even inline characters are moved bitwise.
+static void json_string_take(
+    struct json_string *string, struct json_string *other)
 {
-    string->_impl = (void *)&json_string_impl_null;
+    memcpy(string->_inline, other->_inline, sizeof(string->_inline));
+    json_string_set_null(other);
 }
 
 void json_string_construct(
@@ -47,22 +73,17 @@ enum json_errc json_string_construct_copy(
     struct json_string *string, const struct json_string *other,
     struct json_allocator *alloc)
 {
-    string->_alloc = alloc ? alloc : other->_alloc;
-
-    if (other->_impl->_size) {
-        string->_impl = json_string_impl_new(
-            other->_impl->_size, other->_impl->_size, string->_alloc);
+    json_size size = json_string_length(other);
 
-        if (!string->_impl) {
-            return JSON_ERRC_NOT_ENOUGH_MEMORY;
-        }
+    string->_alloc = alloc ? alloc : other->_alloc;
+    json_string_set_null(string);
 
-        memcpy(string->_impl->_data, other->_impl->_data,
-               other->_impl->_size + 1);
-    } else {
-        json_string_set_null(string);
+    if (json_string_reserve(string, size)) {
+        return JSON_ERRC_NOT_ENOUGH_MEMORY;
     }
 
+    memcpy(json_string_chars(string), json_string_const_chars(other), size);
+    json_string_set_length(string, size);
     return JSON_ERRC_OK;
 }
 
@@ -72,45 +93,59 @@ enum json_errc json_string_construct_move(
 {
     if (!alloc) {
         alloc = other->_alloc;
-    } else if (!json_allocator_is_equal(alloc, other->_alloc)) {
+    } else if (json_string_is_allocated(other) &&
+               !json_allocator_is_equal(alloc, other->_alloc)) {
         return json_string_construct_copy(string, other, alloc);
     }
 
-    string->_impl = other->_impl;
-    json_string_set_null(other);
-
+    string->_alloc = alloc;
+    json_string_take(string, other);
     return JSON_ERRC_OK;
 }
 
+void json_string_construct_borrow(
+    struct json_string *string, char *data, json_size n,
+    struct json_allocator *alloc)
+{
+    string->_alloc = alloc ? alloc : json_get_default_allocator();
+    string->_heap._data = data;
+    string->_heap._size = n;
+    json_string_set_heap_capacity(string, 0);
+}
+
 void json_string_destruct(struct json_string *string)
 {
-    if (string->_impl->_capacity) {
-        json_string_impl_delete(string->_impl, string->_alloc);
-    }
+    json_string_deallocate(string);
 }
 
 enum json_errc json_string_assign_copy(
     struct json_string *string, const struct json_string *other)
 {
-    if (json_string_reserve(string, other->_impl->_size)) {
+    json_size size = json_string_length(other);
+
+    if (string == other) {
+        return JSON_ERRC_OK;
+    } else if (json_string_reserve(string, size)) {
         return JSON_ERRC_NOT_ENOUGH_MEMORY;
     }
 
-    memcpy(string->_impl->_data, other->_impl->_data, other->_impl->_size + 1);
-    string->_impl->_size = other->_impl->_size;
-    return JSON_ERRC_NOT_ENOUGH_MEMORY;
+    memcpy(json_string_chars(string), json_string_const_chars(other), size);
+    json_string_set_length(string, size);
+    return JSON_ERRC_OK;
 }
 
 enum json_errc json_string_assign_move(
     struct json_string *string, struct json_string *other)
 {
-    if (!json_allocator_is_equal(string->_alloc, other->_alloc)) {
+    if (string == other) {
+        return JSON_ERRC_OK;
+    } else if (json_string_is_allocated(other) &&
+               !json_allocator_is_equal(string->_alloc, other->_alloc)) {
         return json_string_assign_copy(string, other);
     }
 
-    json_string_impl_delete(string->_impl, string->_alloc);
-    string->_impl = other->_impl;
-    json_string_set_null(other);
+    json_string_deallocate(string);
+    json_string_take(string, other);
     return JSON_ERRC_OK;
 }
 
@@ -122,60 +157,98 @@ struct json_allocator *json_string_get_allocator(
 
 json_bool json_string_empty(const struct json_string *string)
 {
-    return !string->_impl->_size;
+    return !json_string_length(string);
 }
 
 json_size json_string_size(const struct json_string *string)
 {
-    return string->_impl->_size;
+    return json_string_length(string);
 }
 
 json_size json_string_capacity(const struct json_string *string)
 {
-    return string->_impl->_capacity;
+    return json_string_is_inline(string) ? JSON_STRING_INLINE_CAPACITY
+                                         : json_string_heap_capacity(string);
 }
 
 void json_string_clear(struct json_string *string)
 {
-    if (string->_impl->_size) {
-        string->_impl->_size = 0;
-        string->_impl->_data[0] = 0;
+    if (json_string_length(string)) {
+        json_string_set_length(string, 0);
     }
 }
 
 enum json_errc json_string_reserve(struct json_string *string, json_size n)
 {
-    if (n > string->_impl->_capacity) {
-        struct json_string_impl *new_impl = json_string_impl_new(
-            string->_impl->_size, string->_impl->_size, string->_alloc);
+    json_size size = json_string_length(string);
+    char *data;
 
-        if (!new_impl) {
-            return JSON_ERRC_NOT_ENOUGH_MEMORY;
-        }
+    // A borrowed string has no capacity, so it is always copied here, inline
+    // if it fits, and into room for all of its characters.
+    if (n < size) {
+        n = size;
+    }
 
-        memcpy(
-            new_impl->_data, string->_impl->_data, string->_impl->_size + 1);
-        json_string_impl_delete(string->_impl, string->_alloc);
-        string->_impl = new_impl;
+    if (n <= json_string_capacity(string)) {
+        return JSON_ERRC_OK;
+    } else if (n <= JSON_STRING_INLINE_CAPACITY) {
+        data = string->_heap._data;
+        memcpy(string->_inline, data, size);
+        json_string_set_inline(string, size);
+        return JSON_ERRC_OK;
+    } else if (n > JSON_STRING_MAX_CAPACITY) {
+        return JSON_ERRC_NOT_ENOUGH_MEMORY;
+    }
+
+    // Owned characters are resized where the allocator can; inline and
+    // borrowed ones are copied out.
+    if (json_string_is_allocated(string)) {
+        data = json_allocator_reallocate(
+            string->_alloc, string->_heap._data,
+            json_string_heap_capacity(string) + 1, n + 1, _Alignof(char));
+    } else if ((data = json_string_allocate(n, string->_alloc))) {
+        memcpy(data, json_string_chars(string), size);
+    }
+
+    if (!data) {
+        return JSON_ERRC_NOT_ENOUGH_MEMORY;
     }
 
+    string->_heap._data = data;
+    json_string_set_heap_capacity(string, n);
+    json_string_set_length(string, size);
     return JSON_ERRC_OK;
 }
 
+enum json_errc json_string_append_reserve(
+    struct json_string *string, json_size count)
+{
+    json_size n = json_string_length(string) + count;
+    json_size capacity = json_string_capacity(string);
+
+    // Growing by at least half keeps appending one character at a time linear
+    // overall.
+    if (n > capacity && n < capacity + capacity / 2) {
+        n = capacity + capacity / 2;
+    }
+
+    return json_string_reserve(string, n);
+}
+
 enum json_errc json_string_resize(
     struct json_string *string, json_size new_size, char c)
 {
-    if (string->_impl->_size < new_size) {
+    json_size size = json_string_length(string);
+
+    if (size < new_size) {
         if (json_string_reserve(string, new_size)) {
             return JSON_ERRC_NOT_ENOUGH_MEMORY;
         }
 
-        memset(string->_impl->_data, c, new_size);
-        string->_impl->_data[new_size] = 0;
-        string->_impl->_size = new_size;
-    } else if (string->_impl->_size < new_size) {
-        string->_impl->_size = new_size;
-        string->_impl->_data[new_size] = 0;
+        memset(json_string_chars(string) + size, c, new_size - size);
+        json_string_set_length(string, new_size);
+    } else if (new_size < size) {
+        json_string_set_length(string, new_size);
     }
 
     return JSON_ERRC_OK;
@@ -183,23 +256,21 @@ enum json_errc json_string_resize(
 
 enum json_errc json_string_shrink_to_fit(struct json_string *string)
 {
-    if (string->_impl->_size < string->_impl->_capacity) {
-        if (string->_impl->_size) {
-            struct json_string_impl *new_impl = json_string_impl_new(
-                string->_impl->_size, string->_impl->_size, string->_alloc);
-
-            if (!new_impl) {
-                return JSON_ERRC_NOT_ENOUGH_MEMORY;
-            }
-
-            memcpy(new_impl->_data, string->_impl->_data,
-                   string->_impl->_size + 1);
-            json_string_impl_delete(string->_impl, string->_alloc);
-            string->_impl = new_impl;
-        } else {
-            json_string_impl_delete(string->_impl, string->_alloc);
-            json_string_set_null(string);
+    json_size size = json_string_length(string);
+    struct json_string shrunk;
+
+    if (json_string_is_allocated(string) &&
+        size < json_string_heap_capacity(string)) {
+        json_string_construct(&shrunk, string->_alloc);
+
+        if (json_string_reserve(&shrunk, size)) {
+            return JSON_ERRC_NOT_ENOUGH_MEMORY;
         }
+
+        memcpy(json_string_chars(&shrunk), string->_heap._data, size);
+        json_string_set_length(&shrunk, size);
+        json_string_deallocate(string);
+        json_string_take(string, &shrunk);
     }
 
     return JSON_ERRC_OK;
@@ -207,76 +278,81 @@ enum json_errc json_string_shrink_to_fit(struct json_string *string)
 
 char *json_string_front(struct json_string *string)
 {
-    return string->_impl->_data;
+    return json_string_chars(string);
 }
 
 char *json_string_back(struct json_string *string)
 {
-    return string->_impl->_data + string->_impl->_size - 1;
+    return json_string_chars(string) + json_string_length(string) - 1;
 }
 
 char *json_string_at(struct json_string *string, json_size pos)
 {
-    return string->_impl->_data + pos;
+    return json_string_chars(string) + pos;
 }
 
 char *json_string_data(struct json_string *string)
 {
-    return string->_impl->_data;
+    return json_string_chars(string);
 }
 
 void json_string_swap(struct json_string *string, struct json_string *other)
 {
-    struct json_string_impl *impl = string->_impl;
+    struct json_string tmp = *string;
 
-    string->_impl = other->_impl;
-    other->_impl = impl;
+    *string = *other;
+    *other = tmp;
 }
 
 int json_string_compare(
     const struct json_string *string, const struct json_string *other)
 {
-    json_size n = string->_impl->_size;
-    json_size m = string->_impl->_size;
-    int cmp = memcmp(string->_impl->_data, other->_impl->_data, n < m ? n : m);
+    json_size n = json_string_length(string);
+    json_size m = json_string_length(other);
+    int cmp = memcmp(
+        json_string_const_chars(string), json_string_const_chars(other),
+        n < m ? n : m);
 
-    return cmp ? cmp : json_compare_int(n, m);
+    return cmp ? cmp : (n > m) - (n < m);
 }
 
 void json_string_copy(const struct json_string *string, json_size start,
                       json_size count, char *dest)
 {
-    memcpy(dest, string->_impl->_data + start, count);
+    memcpy(dest, json_string_const_chars(string) + start, count);
 }
 
 void json_string_pop_back(struct json_string *string)
 {
-    --string->_impl->_size;
+    json_string_set_length(string, json_string_length(string) - 1);
 }
 
 enum json_errc json_string_push_back(struct json_string *string, char c)
 {
-    enum json_errc ec = json_string_reserve(string, string->_impl->_size + 1);
+    json_size size = json_string_length(string);
+    enum json_errc ec = json_string_append_reserve(string, 1);
 
     if (ec) {
         return ec;
     }
 
-    string->_impl->_data[string->_impl->_size] = c;
+    json_string_chars(string)[size] = c;
+    json_string_set_length(string, size + 1);
     return JSON_ERRC_OK;
 }
 
 enum json_errc json_string_append(
     struct json_string *string, const char *src, json_size count)
 {
-    enum json_errc ec =
-        json_string_reserve(string, string->_impl->_size + count);
+    json_size size = json_string_length(string);
+    enum json_errc ec = json_string_append_reserve(string, count);
 
     if (ec) {
         return ec;
     }
 
-    memcpy(string->_impl->_data + string->_impl->_size, src, count);
+    memcpy(json_string_chars(string) + size, src, count);
+    json_string_set_length(string, size + count);
     return JSON_ERRC_OK;
 }
 
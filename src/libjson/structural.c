@@ -0,0 +1,125 @@
+#include <stdint.h>
+#include <string.h>
+#include <libjson/errc.h>
+#include <libjson/fwd.h>
+#include <libjson/memory.h>
+#include "./simd.h"
+#include "./structural.h"
+#include "./util.h"
+
+struct json_structural_scanner {
+    /* Bit 0 set if the first byte of the next block is escaped. */
+    json_uint64 prev_escaped;
+
+    /* All bits set if the next block starts inside of a string. */
+    json_uint64 prev_in_string;
+
+    /* Bit 0 set if the last byte of the previous block was a scalar. */
+    json_uint64 prev_scalar;
+
+    json_uint32 *out;
+};
+
+JSON_DEFINE_ALLOCATE_FUNCTION(json_allocate_positions, json_uint32)
+JSON_DEFINE_DEALLOCATE_FUNCTION(json_deallocate_positions, json_uint32)
+
+// Backslashes are rare outside of escaped text, so runs are resolved one at a
+// time instead of with the carry-propagation trick.
+static inline json_uint64 json_structural_escaped(
+    json_uint64 backslash, json_uint64 *prev_escaped)
+{
+    json_uint64 escaped = *prev_escaped;
+
+    backslash &= ~escaped;
+    *prev_escaped = 0;
+
+    while (backslash) {
+        unsigned i = json_simd_ctz(backslash);
+
+        if (i == 63) {
+            *prev_escaped = 1;
+            break;
+        }
+
+        escaped |= (json_uint64)1 << (i + 1);
+        backslash &= ~((json_uint64)3 << i);
+    }
+
+    return escaped;
+}
+
+static inline void json_structural_scan_block(
+    struct json_structural_scanner *s, const char *p, json_uint32 offset)
+{
+    struct json_simd_block block;
+    json_uint64 escaped, quote, in_string, scalar, scalar_start, tokens;
+
+    json_simd_classify(p, &block);
+
+    escaped = json_structural_escaped(block.backslash, &s->prev_escaped);
+    quote = block.quote & ~escaped;
+    in_string = json_simd_prefix_xor(quote) ^ s->prev_in_string;
+    s->prev_in_string = 0 - (in_string >> 63);
+
+    scalar = ~(block.op | block.space | block.quote);
+    scalar_start = scalar & ~(scalar << 1 | s->prev_scalar);
+    s->prev_scalar = scalar >> 63;
+
+    // The prefix xor includes opening quotes and excludes closing quotes.
+    tokens = ((block.op | scalar_start) & ~in_string) | (quote & in_string);
+
+    while (tokens) {
+        *s->out++ = offset + json_simd_ctz(tokens);
+        tokens &= tokens - 1;
+    }
+}
+
+enum json_errc json_structural_index_construct(
+    struct json_structural_index *index, const char *first, const char *last,
+    struct json_allocator *alloc)
+{
+    json_size n = last - first;
+    json_size blocks = n / 64;
+    struct json_structural_scanner s = { 0 };
+    char tail[64];
+
+    index->alloc = alloc;
+    index->size = 0;
+    index->capacity = 0;
+    index->positions = NULL;
+
+    if (n >= UINT32_MAX) {
+        return JSON_ERRC_NOT_ENOUGH_MEMORY;
+    }
+
+    index->positions = json_allocate_positions(alloc, n + 1);
+    if (!index->positions) {
+        return JSON_ERRC_NOT_ENOUGH_MEMORY;
+    }
+
+    index->capacity = n + 1;
+    s.out = index->positions;
+
+    for (json_size i = 0; i < blocks; i++) {
+        json_structural_scan_block(&s, first + 64 * i, 64 * i);
+    }
+
+    if (n % 64) {
+        memset(tail, ' ', sizeof(tail));
+        memcpy(tail, first + 64 * blocks, n % 64);
+        json_structural_scan_block(&s, tail, 64 * blocks);
+    }
+
+    *s.out++ = n;
+    index->size = s.out - index->positions;
+
+    return JSON_ERRC_OK;
+}
+
+void json_structural_index_destruct(struct json_structural_index *index)
+{
+    if (index->positions) {
+        json_deallocate_positions(
+            index->alloc, index->positions, index->capacity);
+    }
+}
@@ -0,0 +1,48 @@
+#ifndef LIBJSON_SRC_STRUCTURAL_H_
+#define LIBJSON_SRC_STRUCTURAL_H_
+
+#include <libjson/errc.h>
+#include <libjson/fwd.h>
+#include <libjson/memory.h>
+#include "./util.h"
+
+/**
+ * Inputs smaller than this are not indexed; the cost of building the index is
+ * not recovered on small documents.
+ */
+#define JSON_STRUCTURAL_INDEX_MIN_SIZE 4096
+
+/**
+ * Offsets of every token start in an input buffer.
+ *
+ * `json_read_tape` builds the tape by walking it, and
+ * `json_read_value_parallel` walks it to find the commas between the elements
+ * of a top level array, whose parts then skip whitespace by it. The other
+ * readers read in one pass and do not build it, as skipping whitespace alone
+ * does not pay for the extra pass over the input.
+ *
+ * A token start is a structural character outside of a string, an opening
+ * quote, or the first byte of a run of scalar characters (numbers and
+ * literals). The last position is always the length of the input, so a
+ * cursor into the index never runs past its end.
+ */
+struct json_structural_index {
+    json_uint32 *positions;
+    json_size size;
+    json_size capacity;
+    struct json_allocator *alloc;
+};
+
+/**
+ * Build the structural index of `[first, last)`.
+ *
+ * Errors:
+ * - `JSON_ERRC_NOT_ENOUGH_MEMORY`
+ */
+enum json_errc json_structural_index_construct(
+    struct json_structural_index *index, const char *first, const char *last,
+    struct json_allocator *alloc);
+
+void json_structural_index_destruct(struct json_structural_index *index);
+
+#endif
@@ -0,0 +1,132 @@
+#ifndef LIBJSON_SRC_TABLE_H_
+#define LIBJSON_SRC_TABLE_H_
+
+#include <libjson/entry.h>
+#include <libjson/errc.h>
+#include <libjson/object.h>
+#include <libjson/string.h>
+#include "./simd.h"
+#include "./util.h"
+
+/**
+ * Number of control bytes probed at once. Hash indices have at least this
+ * many slots; smaller objects have none.
+ */
+#define JSON_TABLE_GROUP_WIDTH 16
+
+/**
+ * Objects with at most this many entries have no hash index, and find keys by
+ * a linear scan of their entries. Those entries are the first segment, which
+ * is the only one that grows with the object.
+ */
+#define JSON_OBJECT_SMALL_CAPACITY 8
+
+/**
+ * Entries past the first segment are kept in segments that double in size,
+ * so none of them is ever moved: segment `s` holds the entries at positions
+ * `[8 << s, 16 << s)`. Positions are 32-bit, so that many segments are enough
+ * for any object.
+ */
+#define JSON_OBJECT_SEGMENT_SHIFT 3
+#define JSON_OBJECT_MAX_SEGMENTS (32 - JSON_OBJECT_SEGMENT_SHIFT)
+
+/**
+ * Control byte of an unused slot. The control byte of a used slot holds the
+ * low seven bits of the hash of its key, so its high bit is clear.
+ */
+#define JSON_TABLE_EMPTY 0x80
+
+static inline unsigned char json_table_h2(json_uint64 hash)
+{
+    return hash & 0x7F;
+}
+
+static inline json_size json_table_h1(json_uint64 hash)
+{
+    return hash >> 7;
+}
+
+/**
+ * Bitmask of the control bytes equal to `c` in the group at `ctrl`.
+ */
+static inline unsigned json_table_match(
+    const unsigned char *ctrl, unsigned char c)
+{
+#if JSON_SIMD_AVX2 || JSON_SIMD_SSE2
+    __m128i v = json_simd_load128((const char *)ctrl);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(c)));
+#else
+    unsigned mask = 0;
+
+    for (unsigned i = 0; i < JSON_TABLE_GROUP_WIDTH; i++) {
+        mask |= (unsigned)(ctrl[i] == c) << i;
+    }
+
+    return mask;
+#endif
+}
+
+static inline unsigned json_table_match_empty(const unsigned char *ctrl)
+{
+    return json_table_match(ctrl, JSON_TABLE_EMPTY);
+}
+
+/**
+ * Segment holding the entry at `pos`, which must be past the first segment.
+ */
+static inline unsigned json_object_segment_of(json_size pos)
+{
+#if JSON_HAS_BUILTIN(__builtin_clzll)
+    return 63 - __builtin_clzll(pos) - JSON_OBJECT_SEGMENT_SHIFT;
+#else
+    unsigned s = 0;
+
+    for (pos >>= JSON_OBJECT_SEGMENT_SHIFT + 1; pos; pos >>= 1) {
+        ++s;
+    }
+
+    return s;
+#endif
+}
+
+static inline struct json_entry *json_object_entry_at(
+    const struct json_object *object, json_size pos)
+{
+    unsigned s;
+
+    if (pos < JSON_OBJECT_SMALL_CAPACITY) {
+        return object->_entries + pos;
+    }
+
+    s = json_object_segment_of(pos);
+    return object->_segments[s] + (pos - (JSON_OBJECT_SMALL_CAPACITY << s));
+}
+
+/**
+ * Insert an entry with a null value for `key`, taking over the key's storage.
+ *
+ * If the object already has an entry with an equal key, `*entry` is set to it,
+ * the key is left untouched and `JSON_ERRC_DUPLICATE_KEY` is returned.
+ *
+ * Entries past the first eight are never moved, but the first eight are
+ * while the object is small, so `*entry` is only valid until the next
+ * insertion into the object.
+ *
+ * Errors:
+ * - `JSON_ERRC_NOT_ENOUGH_MEMORY`
+ * - `JSON_ERRC_DUPLICATE_KEY`
+ */
+enum json_errc json_object_emplace_entry(
+    struct json_object *object, struct json_string *key,
+    struct json_entry **entry);
+
+/**
+ * Insert an entry as `json_object_emplace_entry` does, given the hash of the
+ * key, such as the one cached in an entry of another object. A hash of zero
+ * stands for one not computed yet.
+ */
+enum json_errc json_object_emplace_entry_hashed(
+    struct json_object *object, struct json_string *key, json_uint64 hash,
+    struct json_entry **entry);
+
+#endif
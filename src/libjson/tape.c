@@ -0,0 +1,728 @@
+#include <string.h>
+#include <libjson/errc.h>
+#include <libjson/fwd.h>
+#include <libjson/io.h>
+#include <libjson/memory.h>
+#include <libjson/string.h>
+#include <libjson/tape.h>
+#include <libjson/type.h>
+#include "./reader.h"
+#include "./structural.h"
+#include "./util.h"
+
+// Every value starts with a word holding its tag in the top byte. A string
+// keeps the offset of its characters in the remaining bits and its size in
+// the next word, a number its bits in the words that follow, and the start
+// and end words of a container the index of each other.
+enum {
+    JSON_TAPE_NULL = 'n',
+    JSON_TAPE_TRUE = 't',
+    JSON_TAPE_FALSE = 'f',
+    JSON_TAPE_INT = 'l',
+    JSON_TAPE_FLOAT = 'd',
+    JSON_TAPE_STRING = '"',
+    JSON_TAPE_ARRAY = '[',
+    JSON_TAPE_ARRAY_END = ']',
+    JSON_TAPE_OBJECT = '{',
+    JSON_TAPE_OBJECT_END = '}',
+};
+
+#define JSON_TAPE_TAG_SHIFT 56
+#define JSON_TAPE_PAYLOAD_MASK (((json_uint)1 << JSON_TAPE_TAG_SHIFT) - 1)
+#define JSON_TAPE_FLOAT_WORDS \
+    ((sizeof(json_float) + sizeof(json_uint) - 1) / sizeof(json_uint))
+
+JSON_DEFINE_ALLOCATE_FUNCTION(json_allocate_words, json_uint)
+JSON_DEFINE_DEALLOCATE_FUNCTION(json_deallocate_words, json_uint)
+
+static inline json_uint json_tape_make_word(unsigned tag, json_size payload)
+{
+    return (json_uint)tag << JSON_TAPE_TAG_SHIFT | payload;
+}
+
+static inline unsigned json_tape_tag(json_uint word)
+{
+    return word >> JSON_TAPE_TAG_SHIFT;
+}
+
+static inline json_size json_tape_payload(json_uint word)
+{
+    return word & JSON_TAPE_PAYLOAD_MASK;
+}
+
+void json_tape_construct(struct json_tape *tape, struct json_allocator *alloc)
+{
+    tape->_words = NULL;
+    tape->_size = 0;
+    tape->_capacity = 0;
+    tape->_strings = NULL;
+    tape->_strings_size = 0;
+    tape->_strings_capacity = 0;
+    tape->_alloc = alloc ? alloc : json_get_default_allocator();
+}
+
+void json_tape_destruct(struct json_tape *tape)
+{
+    if (tape->_words) {
+        json_deallocate_words(tape->_alloc, tape->_words, tape->_capacity);
+    }
+
+    if (tape->_strings) {
+        json_deallocate_chars(
+            tape->_alloc, tape->_strings, tape->_strings_capacity);
+    }
+}
+
+void json_tape_clear(struct json_tape *tape)
+{
+    tape->_size = 0;
+    tape->_strings_size = 0;
+}
+
+json_bool json_tape_empty(const struct json_tape *tape)
+{
+    return !tape->_size;
+}
+
+// Make room for `n` more words.
+static enum json_errc json_tape_reserve(struct json_tape *tape, json_size n)
+{
+    json_size capacity = tape->_capacity ? 2 * tape->_capacity : 64;
+    json_uint *words;
+
+    if (tape->_size + n <= tape->_capacity) {
+        return JSON_ERRC_OK;
+    }
+
+    while (capacity < tape->_size + n) {
+        capacity *= 2;
+    }
+
+    if (!(words = json_allocate_words(tape->_alloc, capacity))) {
+        return JSON_ERRC_NOT_ENOUGH_MEMORY;
+    }
+
+    if (tape->_words) {
+        memcpy(words, tape->_words, tape->_size * sizeof(*words));
+        json_deallocate_words(tape->_alloc, tape->_words, tape->_capacity);
+    }
+
+    tape->_words = words;
+    tape->_capacity = capacity;
+    return JSON_ERRC_OK;
+}
+
+// Make room for `n` more string characters.
+static enum json_errc json_tape_reserve_strings(
+    struct json_tape *tape, json_size n)
+{
+    json_size capacity =
+        tape->_strings_capacity ? 2 * tape->_strings_capacity : 256;
+    char *strings;
+
+    if (tape->_strings_size + n <= tape->_strings_capacity) {
+        return JSON_ERRC_OK;
+    }
+
+    while (capacity < tape->_strings_size + n) {
+        capacity *= 2;
+    }
+
+    if (!(strings = json_allocate_chars(tape->_alloc, capacity))) {
+        return JSON_ERRC_NOT_ENOUGH_MEMORY;
+    }
+
+    if (tape->_strings) {
+        memcpy(strings, tape->_strings, tape->_strings_size);
+        json_deallocate_chars(
+            tape->_alloc, tape->_strings, tape->_strings_capacity);
+    }
+
+    tape->_strings = strings;
+    tape->_strings_capacity = capacity;
+    return JSON_ERRC_OK;
+}
+
+struct json_tape_writer {
+    struct json_reader r;
+    struct json_tape *tape;
+
+    /* Unescaped text of the last string that could not be borrowed. */
+    struct json_string buffer;
+};
+
+static enum json_errc json_tape_writer_write_string(
+    struct json_tape_writer *w)
+{
+    struct json_tape *tape = w->tape;
+    const char *data;
+    json_size n;
+    enum json_errc ec;
+
+    if ((ec = json_reader_read_string_span(&w->r, &w->buffer, &data, &n)) ||
+        (ec = json_tape_reserve(tape, 2)) ||
+        (ec = json_tape_reserve_strings(tape, n + 1))) {
+        return ec;
+    }
+
+    memcpy(tape->_strings + tape->_strings_size, data, n);
+    tape->_strings[tape->_strings_size + n] = 0;
+    tape->_words[tape->_size++] =
+        json_tape_make_word(JSON_TAPE_STRING, tape->_strings_size);
+    tape->_words[tape->_size++] = n;
+    tape->_strings_size += n + 1;
+    return JSON_ERRC_OK;
+}
+
+static enum json_errc json_tape_writer_write_number(
+    struct json_tape_writer *w)
+{
+    struct json_tape *tape = w->tape;
+    json_int int_value;
+    json_float float_value;
+    json_bool is_int;
+    enum json_errc ec;
+
+    if ((ec = json_reader_read_number(
+             &w->r, &int_value, &float_value, &is_int)) ||
+        (ec = json_tape_reserve(tape, 1 + JSON_TAPE_FLOAT_WORDS))) {
+        return ec;
+    }
+
+    if (is_int) {
+        tape->_words[tape->_size] = json_tape_make_word(JSON_TAPE_INT, 0);
+        memcpy(tape->_words + tape->_size + 1, &int_value, sizeof(int_value));
+        tape->_size += 2;
+    } else {
+        tape->_words[tape->_size] = json_tape_make_word(JSON_TAPE_FLOAT, 0);
+        memcpy(
+            tape->_words + tape->_size + 1, &float_value, sizeof(float_value));
+        tape->_size += 1 + JSON_TAPE_FLOAT_WORDS;
+    }
+
+    return JSON_ERRC_OK;
+}
+
+static enum json_errc json_tape_writer_write_value(struct json_tape_writer *w);
+
+static enum json_errc json_tape_writer_write_key(struct json_tape_writer *w)
+{
+    struct json_reader *r = &w->r;
+    enum json_errc ec;
+
+    if ((ec = json_tape_writer_write_string(w)) ||
+        (ec = json_reader_consume_space(r))) {
+        return ec;
+    } else if (r->first == r->last || *r->first != ':') {
+        return JSON_ERRC_UNEXPECTED_TOKEN;
+    }
+
+    ++r->first;
+    return JSON_ERRC_OK;
+}
+
+static enum json_errc json_tape_writer_write_elements(
+    struct json_tape_writer *w, json_bool is_object)
+{
+    struct json_reader *r = &w->r;
+    char close = is_object ? '}' : ']';
+    json_bool done = json_false;
+    enum json_errc ec;
+
+    ++r->first;
+
+    if ((ec = json_reader_consume_space(r))) {
+        return ec;
+    } else if (r->first != r->last && *r->first == close) {
+        ++r->first;
+        return JSON_ERRC_OK;
+    }
+
+    while (!done) {
+        if ((is_object && (ec = json_tape_writer_write_key(w))) ||
+            (ec = json_tape_writer_write_value(w)) ||
+            (ec = json_reader_read_separator(r, close, &done))) {
+            return ec;
+        }
+    }
+
+    return JSON_ERRC_OK;
+}
+
+static enum json_errc json_tape_writer_write_container(
+    struct json_tape_writer *w)
+{
+    struct json_reader *r = &w->r;
+    struct json_tape *tape = w->tape;
+    json_bool is_object = *r->first == '{';
+    json_size start;
+    enum json_errc ec;
+
+    if (r->depth >= r->options->max_depth) {
+        return JSON_ERRC_MAX_DEPTH;
+    } else if ((ec = json_tape_reserve(tape, 1))) {
+        return ec;
+    }
+
+    // The start word is filled in once the end is known.
+    start = tape->_size++;
+    ++r->depth;
+    ec = json_tape_writer_write_elements(w, is_object);
+    --r->depth;
+
+    if (ec || (ec = json_tape_reserve(tape, 1))) {
+        return ec;
+    }
+
+    tape->_words[start] = json_tape_make_word(
+        is_object ? JSON_TAPE_OBJECT : JSON_TAPE_ARRAY, tape->_size);
+    tape->_words[tape->_size++] = json_tape_make_word(
+        is_object ? JSON_TAPE_OBJECT_END : JSON_TAPE_ARRAY_END, start);
+    return JSON_ERRC_OK;
+}
+
+static enum json_errc json_tape_writer_write_literal(
+    struct json_tape_writer *w)
+{
+    struct json_reader *r = &w->r;
+    struct json_tape *tape = w->tape;
+    json_bool value;
+    unsigned tag;
+    enum json_errc ec;
+
+    if (*r->first == 'n') {
+        if ((ec = json_reader_read_null(r))) {
+            return ec;
+        }
+
+        tag = JSON_TAPE_NULL;
+    } else {
+        if ((ec = json_reader_read_bool(r, &value))) {
+            return ec;
+        }
+
+        tag = value ? JSON_TAPE_TRUE : JSON_TAPE_FALSE;
+    }
+
+    if ((ec = json_tape_reserve(tape, 1))) {
+        return ec;
+    }
+
+    tape->_words[tape->_size++] = json_tape_make_word(tag, 0);
+    return JSON_ERRC_OK;
+}
+
+static enum json_errc json_tape_writer_write_value(struct json_tape_writer *w)
+{
+    struct json_reader *r = &w->r;
+    enum json_errc ec;
+
+    if ((ec = json_reader_consume_space(r))) {
+        return ec;
+    } else if (r->first == r->last) {
+        return JSON_ERRC_UNEXPECTED_TOKEN;
+    }
+
+    switch (*r->first) {
+    case 'n':
+    case 't':
+    case 'f':
+        return json_tape_writer_write_literal(w);
+    case '-':
+    case '0':
+    case '1':
+    case '2':
+    case '3':
+    case '4':
+    case '5':
+    case '6':
+    case '7':
+    case '8':
+    case '9':
+        return json_tape_writer_write_number(w);
+    case '"':
+        return json_tape_writer_write_string(w);
+    case '[':
+    case '{':
+        return json_tape_writer_write_container(w);
+    default:
+        return JSON_ERRC_UNEXPECTED_TOKEN;
+    }
+}
+
+enum json_tape_state {
+    JSON_TAPE_STATE_VALUE,
+    JSON_TAPE_STATE_KEY,
+    JSON_TAPE_STATE_NEXT,
+};
+
+// A number or literal must span its whole run of scalar characters, which
+// ends at whitespace or at the next token.
+static inline json_bool json_tape_scalar_ended(
+    const struct json_reader *r, const json_uint32 *p)
+{
+    return r->first == r->last || json_is_space(*r->first) ||
+           r->first == r->origin + p[1];
+}
+
+// Whether the token at `p` closes the innermost open container.
+static inline json_bool json_tape_at_close(
+    const struct json_reader *r, const json_uint32 *p, json_bool is_object)
+{
+    return r->origin + *p != r->last &&
+           r->origin[*p] == (is_object ? '}' : ']');
+}
+
+// The second stage of an indexed read: step from one token start to the next
+// instead of scanning for them. Until it is closed, the start word of an open
+// container holds the position after the start word of the one enclosing it,
+// so the tape itself is the stack of open containers.
+static enum json_errc json_tape_writer_write_indexed(
+    struct json_tape_writer *w, const json_uint32 *p)
+{
+    struct json_reader *r = &w->r;
+    struct json_tape *tape = w->tape;
+    enum json_tape_state state = JSON_TAPE_STATE_VALUE;
+    json_size open = 0;
+    json_size start;
+    json_bool is_object;
+    enum json_errc ec;
+    char c;
+
+    for (;;) {
+        if (state == JSON_TAPE_STATE_NEXT && !open) {
+            return JSON_ERRC_OK;
+        }
+
+        r->first = r->origin + *p;
+        c = r->first == r->last ? 0 : *r->first;
+
+        switch (state) {
+        case JSON_TAPE_STATE_KEY:
+            if (c != '"') {
+                return JSON_ERRC_UNEXPECTED_TOKEN;
+            } else if ((ec = json_tape_writer_write_string(w))) {
+                return ec;
+            }
+
+            r->first = r->origin + *++p;
+
+            if (r->first == r->last || *r->first != ':') {
+                return JSON_ERRC_UNEXPECTED_TOKEN;
+            }
+
+            ++p;
+            state = JSON_TAPE_STATE_VALUE;
+            break;
+        case JSON_TAPE_STATE_VALUE:
+            switch (c) {
+            case '[':
+            case '{':
+                if (r->depth >= r->options->max_depth) {
+                    return JSON_ERRC_MAX_DEPTH;
+                } else if ((ec = json_tape_reserve(tape, 1))) {
+                    return ec;
+                }
+
+                is_object = c == '{';
+                tape->_words[tape->_size] = json_tape_make_word(
+                    is_object ? JSON_TAPE_OBJECT : JSON_TAPE_ARRAY, open);
+                open = ++tape->_size;
+                ++r->depth;
+                ++p;
+
+                // An empty container is closed by the next state.
+                if (json_tape_at_close(r, p, is_object)) {
+                    state = JSON_TAPE_STATE_NEXT;
+                } else {
+                    state = is_object ? JSON_TAPE_STATE_KEY
+                                      : JSON_TAPE_STATE_VALUE;
+                }
+
+                continue;
+            case '"':
+                ec = json_tape_writer_write_string(w);
+                break;
+            case 'n':
+            case 't':
+            case 'f':
+                ec = json_tape_writer_write_literal(w);
+                break;
+            case '-':
+            case '0':
+            case '1':
+            case '2':
+            case '3':
+            case '4':
+            case '5':
+            case '6':
+            case '7':
+            case '8':
+            case '9':
+                ec = json_tape_writer_write_number(w);
+                break;
+            default:
+                return JSON_ERRC_UNEXPECTED_TOKEN;
+            }
+
+            if (ec) {
+                return ec;
+            } else if (c != '"' && !json_tape_scalar_ended(r, p)) {
+                return JSON_ERRC_UNEXPECTED_TOKEN;
+            }
+
+            ++p;
+            state = JSON_TAPE_STATE_NEXT;
+            break;
+        case JSON_TAPE_STATE_NEXT:
+            start = open - 1;
+            is_object = json_tape_tag(tape->_words[start]) == JSON_TAPE_OBJECT;
+
+            if (c == ',') {
+                ++p;
+
+                if (r->options->accept_trailing_commas &&
+                    json_tape_at_close(r, p, is_object)) {
+                    state = JSON_TAPE_STATE_NEXT;
+                } else {
+                    state = is_object ? JSON_TAPE_STATE_KEY
+                                      : JSON_TAPE_STATE_VALUE;
+                }
+
+                break;
+            } else if (c != (is_object ? '}' : ']')) {
+                return JSON_ERRC_UNEXPECTED_TOKEN;
+            } else if ((ec = json_tape_reserve(tape, 1))) {
+                return ec;
+            }
+
+            open = json_tape_payload(tape->_words[start]);
+            tape->_words[start] = json_tape_make_word(
+                is_object ? JSON_TAPE_OBJECT : JSON_TAPE_ARRAY, tape->_size);
+            tape->_words[tape->_size++] = json_tape_make_word(
+                is_object ? JSON_TAPE_OBJECT_END : JSON_TAPE_ARRAY_END, start);
+            --r->depth;
+            ++r->first;
+            ++p;
+            break;
+        }
+    }
+}
+
+struct json_read_result json_read_tape(
+    const char *first, const char *last, struct json_tape *tape,
+    const struct json_read_options *options)
+{
+    struct json_tape_writer w = {
+        .r = json_make_reader(first, last, options),
+        .tape = tape,
+    };
+    struct json_structural_index index;
+    json_size n = last - first;
+    enum json_errc ec;
+
+    json_tape_clear(tape);
+
+    // A string takes at least as many bytes of the input as of the string
+    // buffer, its NUL included, so that buffer never grows while reading.
+    // Values take at most a word for each byte of the input, and most
+    // documents need less than half that.
+    if ((ec = json_tape_reserve(tape, n / 2 + 2)) ||
+        (ec = json_tape_reserve_strings(tape, n))) {
+        return (struct json_read_result){ .ec = ec, .ptr = first };
+    }
+
+    json_string_construct(&w.buffer, tape->_alloc);
+
+    // Large inputs are read in two stages: the structural index finds every
+    // token start, and the tape is then built by walking those starts. If the
+    // index cannot be built, the input is read in one pass.
+    if (json_reader_use_index(&w.r) &&
+        !json_structural_index_construct(&index, first, last, tape->_alloc)) {
+        ec = json_tape_writer_write_indexed(&w, index.positions);
+        json_structural_index_destruct(&index);
+    } else {
+        ec = json_tape_writer_write_value(&w);
+    }
+
+    // A partial tape has unlinked containers, so it is not kept.
+    if (ec) {
+        json_tape_clear(tape);
+    }
+
+    json_string_destruct(&w.buffer);
+    return (struct json_read_result){ .ec = ec, .ptr = w.r.first };
+}
+
+// Index of the value after the one at `i`, skipping over its subtree.
+static inline json_size json_tape_next_index(
+    const struct json_tape *tape, json_size i)
+{
+    json_uint word = tape->_words[i];
+
+    switch (json_tape_tag(word)) {
+    case JSON_TAPE_INT:
+    case JSON_TAPE_STRING:
+        return i + 2;
+    case JSON_TAPE_FLOAT:
+        return i + 1 + JSON_TAPE_FLOAT_WORDS;
+    case JSON_TAPE_ARRAY:
+    case JSON_TAPE_OBJECT:
+        return json_tape_payload(word) + 1;
+    default:
+        return i + 1;
+    }
+}
+
+static inline const char *json_tape_string_at(
+    const struct json_tape *tape, json_size i, json_size *n)
+{
+    *n = tape->_words[i + 1];
+    return tape->_strings + json_tape_payload(tape->_words[i]);
+}
+
+void json_tape_root(
+    const struct json_tape *tape, struct json_tape_cursor *cursor)
+{
+    cursor->_tape = tape;
+    cursor->_index = 0;
+}
+
+enum json_type json_tape_get_type(const struct json_tape_cursor *cursor)
+{
+    switch (json_tape_tag(cursor->_tape->_words[cursor->_index])) {
+    case JSON_TAPE_NULL:
+        return JSON_TYPE_NULL;
+    case JSON_TAPE_TRUE:
+    case JSON_TAPE_FALSE:
+        return JSON_TYPE_BOOL;
+    case JSON_TAPE_INT:
+        return JSON_TYPE_INT;
+    case JSON_TAPE_FLOAT:
+        return JSON_TYPE_FLOAT;
+    case JSON_TAPE_STRING:
+        return JSON_TYPE_STRING;
+    case JSON_TAPE_ARRAY:
+        return JSON_TYPE_ARRAY;
+    case JSON_TAPE_OBJECT:
+        return JSON_TYPE_OBJECT;
+    default:
+        json_unreachable();
+    }
+}
+
+json_bool json_tape_get_bool(const struct json_tape_cursor *cursor)
+{
+    return json_tape_tag(cursor->_tape->_words[cursor->_index]) ==
+           JSON_TAPE_TRUE;
+}
+
+json_int json_tape_get_int(const struct json_tape_cursor *cursor)
+{
+    json_int value;
+
+    memcpy(&value, cursor->_tape->_words + cursor->_index + 1, sizeof(value));
+    return value;
+}
+
+json_float json_tape_get_float(const struct json_tape_cursor *cursor)
+{
+    const json_uint *word = cursor->_tape->_words + cursor->_index;
+    json_float value;
+
+    if (json_tape_tag(*word) == JSON_TAPE_INT) {
+        return json_tape_get_int(cursor);
+    }
+
+    memcpy(&value, word + 1, sizeof(value));
+    return value;
+}
+
+const char *json_tape_get_string(
+    const struct json_tape_cursor *cursor, json_size *n)
+{
+    return json_tape_string_at(cursor->_tape, cursor->_index, n);
+}
+
+json_size json_tape_size(const struct json_tape_cursor *cursor)
+{
+    const struct json_tape *tape = cursor->_tape;
+    json_bool is_object =
+        json_tape_tag(tape->_words[cursor->_index]) == JSON_TAPE_OBJECT;
+    json_size end = json_tape_payload(tape->_words[cursor->_index]);
+    json_size n = 0;
+
+    for (json_size i = cursor->_index + 1; i != end; ++n) {
+        i = json_tape_next_index(tape, i + (is_object ? 2 : 0));
+    }
+
+    return n;
+}
+
+void json_tape_array_begin(
+    const struct json_tape_cursor *array, struct json_tape_iter *iter)
+{
+    iter->_tape = array->_tape;
+    iter->_index = array->_index + 1;
+}
+
+json_bool json_tape_array_next(
+    struct json_tape_iter *iter, struct json_tape_cursor *element)
+{
+    const struct json_tape *tape = iter->_tape;
+
+    if (json_tape_tag(tape->_words[iter->_index]) == JSON_TAPE_ARRAY_END) {
+        return json_false;
+    }
+
+    element->_tape = tape;
+    element->_index = iter->_index;
+    iter->_index = json_tape_next_index(tape, iter->_index);
+    return json_true;
+}
+
+void json_tape_object_begin(
+    const struct json_tape_cursor *object, struct json_tape_iter *iter)
+{
+    iter->_tape = object->_tape;
+    iter->_index = object->_index + 1;
+}
+
+json_bool json_tape_object_next(
+    struct json_tape_iter *iter, const char **key, json_size *n,
+    struct json_tape_cursor *value)
+{
+    const struct json_tape *tape = iter->_tape;
+
+    if (json_tape_tag(tape->_words[iter->_index]) == JSON_TAPE_OBJECT_END) {
+        return json_false;
+    }
+
+    // Keys are always strings, so the value is two words on.
+    *key = json_tape_string_at(tape, iter->_index, n);
+    value->_tape = tape;
+    value->_index = iter->_index + 2;
+    iter->_index = json_tape_next_index(tape, iter->_index + 2);
+    return json_true;
+}
+
+json_bool json_tape_find_field(
+    const struct json_tape_cursor *object, const char *key, json_size n,
+    struct json_tape_cursor *out)
+{
+    struct json_tape_iter iter;
+    struct json_tape_cursor value;
+    const char *data;
+    json_size size;
+
+    json_tape_object_begin(object, &iter);
+
+    while (json_tape_object_next(&iter, &data, &size, &value)) {
+        if (size == n && !memcmp(data, key, n)) {
+            *out = value;
+            return json_true;
+        }
+    }
+
+    return json_false;
+}
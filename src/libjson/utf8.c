@@ -0,0 +1,266 @@
+#include <string.h>
+#include "./simd.h"
+#include "./utf8.h"
+#include "./util.h"
+
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+
+static inline const char *json_utf8_skip_ascii(
+    const char *first, const char *last)
+{
+#if JSON_SIMD_SSE2 || JSON_SIMD_AVX2
+    for (; last - first >= 16; first += 16) {
+        if (_mm_movemask_epi8(json_simd_load128(first))) {
+            break;
+        }
+    }
+#else
+    for (; last - first >= 8; first += 8) {
+        if (json_load_unaligned_le64(first) & JSON_SIMD_BROADCAST(0x80)) {
+            break;
+        }
+    }
+#endif
+
+    while (first != last && !((unsigned char)*first & 0x80)) {
+        ++first;
+    }
+
+    return first;
+}
+
+// Validate the sequence starting at `first`; returns its length, or zero if it
+// is ill formed.
+// https://www.unicode.org/versions/Unicode15.0.0/ch03.pdf#page=55
+static inline json_size json_utf8_sequence_length(
+    const char *first, const char *last)
+{
+    unsigned char b1 = *first;
+    unsigned char lo = 0x80;
+    unsigned char hi = 0xBF;
+    json_size n;
+
+    if (b1 < 0x80) {
+        return 1;
+    } else if (b1 >= 0xC2 && b1 <= 0xDF) {
+        n = 1;
+    } else if (b1 >= 0xE0 && b1 <= 0xEF) {
+        n = 2;
+        lo = b1 == 0xE0 ? 0xA0 : lo;
+        hi = b1 == 0xED ? 0x9F : hi;
+    } else if (b1 >= 0xF0 && b1 <= 0xF4) {
+        n = 3;
+        lo = b1 == 0xF0 ? 0x90 : lo;
+        hi = b1 == 0xF4 ? 0x8F : hi;
+    } else {
+        return 0;
+    }
+
+    if (last - first <= n || (unsigned char)first[1] < lo ||
+        (unsigned char)first[1] > hi) {
+        return 0;
+    }
+
+    for (json_size i = 2; i <= n; i++) {
+        if (((unsigned char)first[i] & 0xC0) != 0x80) {
+            return 0;
+        }
+    }
+
+    return n + 1;
+}
+
+static const char *json_utf8_validate_scalar(
+    const char *first, const char *last)
+{
+    for (;;) {
+        json_size n;
+
+        if ((first = json_utf8_skip_ascii(first, last)) == last) {
+            return last;
+        } else if (!(n = json_utf8_sequence_length(first, last))) {
+            return first;
+        }
+
+        first += n;
+    }
+}
+
+#if defined(__SSSE3__)
+
+// Error classes of the lookup algorithm from Keiser and Lemire, "Validating
+// UTF-8 In Less Than One Instruction Per Byte". Each class is a pattern over
+// the previous byte and the current byte; a byte pair is invalid if all three
+// table lookups agree on a class.
+#define JSON_UTF8_TOO_SHORT (1 << 0)
+#define JSON_UTF8_TOO_LONG (1 << 1)
+#define JSON_UTF8_OVERLONG_3 (1 << 2)
+#define JSON_UTF8_TOO_LARGE (1 << 3)
+#define JSON_UTF8_SURROGATE (1 << 4)
+#define JSON_UTF8_OVERLONG_2 (1 << 5)
+#define JSON_UTF8_TOO_LARGE_1000 (1 << 6)
+#define JSON_UTF8_OVERLONG_4 (1 << 6)
+#define JSON_UTF8_TWO_CONTS (1 << 7)
+#define JSON_UTF8_CARRY \
+    (JSON_UTF8_TOO_SHORT | JSON_UTF8_TOO_LONG | JSON_UTF8_TWO_CONTS)
+
+struct json_utf8_checker {
+    __m128i error;
+    __m128i prev_input;
+    __m128i prev_incomplete;
+};
+
+static inline __m128i json_utf8_high_nibbles(__m128i v)
+{
+    return _mm_and_si128(_mm_srli_epi16(v, 4), _mm_set1_epi8(0x0F));
+}
+
+static inline __m128i json_utf8_special_cases(__m128i input, __m128i prev1)
+{
+    const __m128i byte_1_high_table = _mm_setr_epi8(
+        JSON_UTF8_TOO_LONG, JSON_UTF8_TOO_LONG, JSON_UTF8_TOO_LONG,
+        JSON_UTF8_TOO_LONG, JSON_UTF8_TOO_LONG, JSON_UTF8_TOO_LONG,
+        JSON_UTF8_TOO_LONG, JSON_UTF8_TOO_LONG, JSON_UTF8_TWO_CONTS,
+        JSON_UTF8_TWO_CONTS, JSON_UTF8_TWO_CONTS, JSON_UTF8_TWO_CONTS,
+        JSON_UTF8_TOO_SHORT | JSON_UTF8_OVERLONG_2, JSON_UTF8_TOO_SHORT,
+        JSON_UTF8_TOO_SHORT | JSON_UTF8_OVERLONG_3 | JSON_UTF8_SURROGATE,
+        JSON_UTF8_TOO_SHORT | JSON_UTF8_TOO_LARGE | JSON_UTF8_TOO_LARGE_1000 |
+            JSON_UTF8_OVERLONG_4);
+    const __m128i byte_1_low_table = _mm_setr_epi8(
+        JSON_UTF8_CARRY | JSON_UTF8_OVERLONG_3 | JSON_UTF8_OVERLONG_2 |
+            JSON_UTF8_OVERLONG_4,
+        JSON_UTF8_CARRY | JSON_UTF8_OVERLONG_2, JSON_UTF8_CARRY,
+        JSON_UTF8_CARRY, JSON_UTF8_CARRY | JSON_UTF8_TOO_LARGE,
+        JSON_UTF8_CARRY | JSON_UTF8_TOO_LARGE | JSON_UTF8_TOO_LARGE_1000,
+        JSON_UTF8_CARRY | JSON_UTF8_TOO_LARGE | JSON_UTF8_TOO_LARGE_1000,
+        JSON_UTF8_CARRY | JSON_UTF8_TOO_LARGE | JSON_UTF8_TOO_LARGE_1000,
+        JSON_UTF8_CARRY | JSON_UTF8_TOO_LARGE | JSON_UTF8_TOO_LARGE_1000,
+        JSON_UTF8_CARRY | JSON_UTF8_TOO_LARGE | JSON_UTF8_TOO_LARGE_1000,
+        JSON_UTF8_CARRY | JSON_UTF8_TOO_LARGE | JSON_UTF8_TOO_LARGE_1000,
+        JSON_UTF8_CARRY | JSON_UTF8_TOO_LARGE | JSON_UTF8_TOO_LARGE_1000,
+        JSON_UTF8_CARRY | JSON_UTF8_TOO_LARGE | JSON_UTF8_TOO_LARGE_1000,
+        JSON_UTF8_CARRY | JSON_UTF8_TOO_LARGE | JSON_UTF8_TOO_LARGE_1000 |
+            JSON_UTF8_SURROGATE,
+        JSON_UTF8_CARRY | JSON_UTF8_TOO_LARGE | JSON_UTF8_TOO_LARGE_1000,
+        JSON_UTF8_CARRY | JSON_UTF8_TOO_LARGE | JSON_UTF8_TOO_LARGE_1000);
+    const __m128i byte_2_high_table = _mm_setr_epi8(
+        JSON_UTF8_TOO_SHORT, JSON_UTF8_TOO_SHORT, JSON_UTF8_TOO_SHORT,
+        JSON_UTF8_TOO_SHORT, JSON_UTF8_TOO_SHORT, JSON_UTF8_TOO_SHORT,
+        JSON_UTF8_TOO_SHORT, JSON_UTF8_TOO_SHORT,
+        JSON_UTF8_TOO_LONG | JSON_UTF8_OVERLONG_2 | JSON_UTF8_TWO_CONTS |
+            JSON_UTF8_OVERLONG_3 | JSON_UTF8_TOO_LARGE_1000 |
+            JSON_UTF8_OVERLONG_4,
+        JSON_UTF8_TOO_LONG | JSON_UTF8_OVERLONG_2 | JSON_UTF8_TWO_CONTS |
+            JSON_UTF8_OVERLONG_3 | JSON_UTF8_TOO_LARGE,
+        JSON_UTF8_TOO_LONG | JSON_UTF8_OVERLONG_2 | JSON_UTF8_TWO_CONTS |
+            JSON_UTF8_SURROGATE | JSON_UTF8_TOO_LARGE,
+        JSON_UTF8_TOO_LONG | JSON_UTF8_OVERLONG_2 | JSON_UTF8_TWO_CONTS |
+            JSON_UTF8_SURROGATE | JSON_UTF8_TOO_LARGE,
+        JSON_UTF8_TOO_SHORT, JSON_UTF8_TOO_SHORT, JSON_UTF8_TOO_SHORT,
+        JSON_UTF8_TOO_SHORT);
+
+    __m128i byte_1_high = _mm_shuffle_epi8(
+        byte_1_high_table, json_utf8_high_nibbles(prev1));
+    __m128i byte_1_low = _mm_shuffle_epi8(
+        byte_1_low_table, _mm_and_si128(prev1, _mm_set1_epi8(0x0F)));
+    __m128i byte_2_high = _mm_shuffle_epi8(
+        byte_2_high_table, json_utf8_high_nibbles(input));
+
+    return _mm_and_si128(_mm_and_si128(byte_1_high, byte_1_low), byte_2_high);
+}
+
+static inline void json_utf8_check_chunk(
+    struct json_utf8_checker *c, __m128i input)
+{
+    __m128i prev1 = _mm_alignr_epi8(input, c->prev_input, 15);
+    __m128i prev2 = _mm_alignr_epi8(input, c->prev_input, 14);
+    __m128i prev3 = _mm_alignr_epi8(input, c->prev_input, 13);
+    __m128i special_cases = json_utf8_special_cases(input, prev1);
+
+    // Third and fourth bytes of a sequence must be continuations, which the
+    // two byte lookup cannot see.
+    __m128i must_be_continuation = _mm_and_si128(
+        _mm_or_si128(
+            _mm_subs_epu8(prev2, _mm_set1_epi8((char)(0xE0 - 0x80))),
+            _mm_subs_epu8(prev3, _mm_set1_epi8((char)(0xF0 - 0x80)))),
+        _mm_set1_epi8((char)0x80));
+
+    c->error = _mm_or_si128(
+        c->error, _mm_xor_si128(must_be_continuation, special_cases));
+
+    // A lead byte in the last three positions needs bytes of the next chunk.
+    c->prev_incomplete = _mm_subs_epu8(
+        input,
+        _mm_setr_epi8(
+            -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+            (char)(0xF0 - 1), (char)(0xE0 - 1), (char)(0xC0 - 1)));
+    c->prev_input = input;
+}
+
+static inline void json_utf8_check_ascii(struct json_utf8_checker *c)
+{
+    c->error = _mm_or_si128(c->error, c->prev_incomplete);
+    c->prev_incomplete = _mm_setzero_si128();
+    c->prev_input = _mm_setzero_si128();
+}
+
+static json_bool json_utf8_is_valid(const char *first, const char *last)
+{
+    struct json_utf8_checker c = {
+        .error = _mm_setzero_si128(),
+        .prev_input = _mm_setzero_si128(),
+        .prev_incomplete = _mm_setzero_si128(),
+    };
+    char tail[16] = { 0 };
+
+    for (; last - first >= 64; first += 64) {
+        __m128i v0 = json_simd_load128(first);
+        __m128i v1 = json_simd_load128(first + 16);
+        __m128i v2 = json_simd_load128(first + 32);
+        __m128i v3 = json_simd_load128(first + 48);
+
+        if (!_mm_movemask_epi8(
+                _mm_or_si128(_mm_or_si128(v0, v1), _mm_or_si128(v2, v3)))) {
+            json_utf8_check_ascii(&c);
+        } else {
+            json_utf8_check_chunk(&c, v0);
+            json_utf8_check_chunk(&c, v1);
+            json_utf8_check_chunk(&c, v2);
+            json_utf8_check_chunk(&c, v3);
+        }
+    }
+
+    for (; last - first >= 16; first += 16) {
+        json_utf8_check_chunk(&c, json_simd_load128(first));
+    }
+
+    if (first != last) {
+        memcpy(tail, first, last - first);
+        json_utf8_check_chunk(&c, json_simd_load128(tail));
+    }
+
+    c.error = _mm_or_si128(c.error, c.prev_incomplete);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(c.error, _mm_setzero_si128())) ==
+           0xFFFF;
+}
+
+#endif
+
+const char *json_utf8_validate(const char *first, const char *last)
+{
+    // Inputs are mostly ASCII; only look for the error position once the
+    // vector check has failed.
+    if ((first = json_utf8_skip_ascii(first, last)) == last) {
+        return last;
+    }
+
+#if defined(__SSSE3__)
+    if (json_utf8_is_valid(first, last)) {
+        return last;
+    }
+#endif
+
+    return json_utf8_validate_scalar(first, last);
+}
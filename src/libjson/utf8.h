@@ -0,0 +1,12 @@
+#ifndef LIBJSON_SRC_UTF8_H_
+#define LIBJSON_SRC_UTF8_H_
+
+/**
+ * Validate UTF-8.
+ *
+ * Returns the first byte of `[first, last)` that does not start a well formed
+ * UTF-8 sequence, or `last` if the whole range is valid.
+ */
+const char *json_utf8_validate(const char *first, const char *last);
+
+#endif
@@ -1,6 +1,8 @@
 #ifndef LIBJSON_SRC_UTIL_H_
 #define LIBJSON_SRC_UTIL_H_
 
+#include <limits.h>
+#include <stdatomic.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
@@ -12,6 +14,7 @@
 #include <libjson/string.h>
 #include <libjson/value.h>
 
+typedef uint32_t json_uint32;
 typedef uint64_t json_uint64;
 
 #define JSON_DEFINE_ALLOCATE_FUNCTION(NAME, TYPE)                       \
@@ -67,6 +70,15 @@ JSON_DEFINE_DEALLOCATE_FUNCTION(json_deallocate_chars, char)
     } while (0)
 #endif
 
+/**
+ * Hint that the memory at `p` is about to be read.
+ */
+#if JSON_HAS_BUILTIN(__builtin_prefetch)
+#define json_prefetch(p) __builtin_prefetch(p)
+#else
+#define json_prefetch(p) ((void)(p))
+#endif
+
 #define JSON_LITTLE_ENDIAN 1
 #define JSON_BIG_ENDIAN 2
 
@@ -78,6 +90,100 @@ JSON_DEFINE_DEALLOCATE_FUNCTION(json_deallocate_chars, char)
 #error "libjson: Architecture not supported."
 #endif
 
+/**
+ * Byte of a string holding the size of an inline string, or the last byte of
+ * the capacity of a string on the heap.
+ */
+#define JSON_STRING_TAG (JSON_STRING_INLINE_CAPACITY + 1)
+
+/**
+ * Flag set in the tag byte of a string stored inline, whose other bits hold
+ * its size.
+ */
+#define JSON_STRING_INLINE 0x80
+
+/**
+ * The capacity of a string on the heap is stored shifted so that the byte it
+ * shares with the tag is zero: its high byte on little-endian targets, and
+ * its low byte, shifted out of the way, on others.
+ */
+#if JSON_NATIVE_ENDIAN == JSON_LITTLE_ENDIAN
+#define JSON_STRING_CAPACITY_SHIFT 0
+#else
+#define JSON_STRING_CAPACITY_SHIFT CHAR_BIT
+#endif
+
+/**
+ * Largest capacity of a string on the heap, which leaves the tag byte zero.
+ */
+#define JSON_STRING_MAX_CAPACITY \
+    (((json_size)1 << (sizeof(json_size) * CHAR_BIT - CHAR_BIT)) - 1)
+
+static inline json_bool json_string_is_inline(const struct json_string *string)
+{
+    return (unsigned char)string->_inline[JSON_STRING_TAG] &
+           JSON_STRING_INLINE;
+}
+
+static inline json_size json_string_heap_capacity(
+    const struct json_string *string)
+{
+    return string->_heap._capacity >> JSON_STRING_CAPACITY_SHIFT;
+}
+
+static inline void json_string_set_heap_capacity(
+    struct json_string *string, json_size capacity)
+{
+    string->_heap._capacity = capacity << JSON_STRING_CAPACITY_SHIFT;
+}
+
+static inline json_size json_string_length(const struct json_string *string)
+{
+    return json_string_is_inline(string)
+               ? (unsigned char)string->_inline[JSON_STRING_TAG] &
+                     ~JSON_STRING_INLINE
+               : string->_heap._size;
+}
+
+static inline char *json_string_chars(struct json_string *string)
+{
+    return json_string_is_inline(string) ? string->_inline
+                                         : string->_heap._data;
+}
+
+static inline const char *json_string_const_chars(
+    const struct json_string *string)
+{
+    return json_string_is_inline(string) ? string->_inline
+                                         : string->_heap._data;
+}
+
+/**
+ * Store a string of `n` characters inline, whose characters are already in
+ * place, and terminate it.
+ */
+static inline void json_string_set_inline(
+    struct json_string *string, json_size n)
+{
+    string->_inline[JSON_STRING_TAG] = (char)(JSON_STRING_INLINE | n);
+    string->_inline[n] = 0;
+}
+
+/**
+ * Set the size of a string that has room for `n` characters, and terminate
+ * it.
+ */
+static inline void json_string_set_length(
+    struct json_string *string, json_size n)
+{
+    if (json_string_is_inline(string)) {
+        json_string_set_inline(string, n);
+    } else {
+        string->_heap._size = n;
+        string->_heap._data[n] = 0;
+    }
+}
+
 static inline json_uint64 json_load_unaligned_le64(const void *p)
 {
 #if JSON_NATIVE_ENDIAN == JSON_LITTLE_ENDIAN && JSON_HAS_ATTRIBUTE(packed)
@@ -86,31 +192,51 @@ static inline json_uint64 json_load_unaligned_le64(const void *p)
     } __attribute__((packed)) *pv = p;
     return pv->value;
 #else
-    uint8_t *pv = p;
+    const uint8_t *pv = p;
     return ((json_uint64)pv[0] << 0) | ((json_uint64)pv[1] << 8) |
            ((json_uint64)pv[2] << 16) | ((json_uint64)pv[3] << 24) |
            ((json_uint64)pv[4] << 32) | ((json_uint64)pv[5] << 40) |
-           ((json_uint64)ov[6] << 48) | ((json_uint64)pv[7] << 56);
+           ((json_uint64)pv[6] << 48) | ((json_uint64)pv[7] << 56);
 #endif
 }
 
-static inline void json_store_unaligned_le64(void *p, json_uint64 value)
+static inline json_uint64 json_load_unaligned_le32(const void *p)
 {
 #if JSON_NATIVE_ENDIAN == JSON_LITTLE_ENDIAN && JSON_HAS_ATTRIBUTE(packed)
-    struct {
-        json_uint64 value;
+    const struct {
+        json_uint32 value;
     } __attribute__((packed)) *pv = p;
-    pv->value = value;
+    return pv->value;
+#else
+    const uint8_t *pv = p;
+    return ((json_uint64)pv[0] << 0) | ((json_uint64)pv[1] << 8) |
+           ((json_uint64)pv[2] << 16) | ((json_uint64)pv[3] << 24);
+#endif
+}
+
+struct json_uint128 {
+    json_uint64 high;
+    json_uint64 low;
+};
+
+static inline struct json_uint128 json_mul64(json_uint64 a, json_uint64 b)
+{
+#if defined(__SIZEOF_INT128__)
+    unsigned __int128 p = (unsigned __int128)a * b;
+    return (struct json_uint128){ .high = p >> 64, .low = (json_uint64)p };
 #else
-    uint8_t *pv = p;
-    pv[0] = value >> 0;
-    pv[1] = value >> 8;
-    pv[2] = value >> 16;
-    pv[3] = value >> 24;
-    pv[4] = value >> 32;
-    pv[5] = value >> 40;
-    pv[6] = value >> 48;
-    pv[7] = value >> 56;
+    json_uint64 a_lo = (uint32_t)a, a_hi = a >> 32;
+    json_uint64 b_lo = (uint32_t)b, b_hi = b >> 32;
+    json_uint64 lo_lo = a_lo * b_lo;
+    json_uint64 hi_lo = a_hi * b_lo;
+    json_uint64 lo_hi = a_lo * b_hi;
+    json_uint64 hi_hi = a_hi * b_hi;
+    json_uint64 cross = (lo_lo >> 32) + (uint32_t)hi_lo + lo_hi;
+
+    return (struct json_uint128){
+        .high = (hi_lo >> 32) + (cross >> 32) + hi_hi,
+        .low = (cross << 32) | (uint32_t)lo_lo,
+    };
 #endif
 }
 
@@ -147,7 +273,7 @@ static inline json_uint64 json_siphash(
     json_uint64 m;
 
     for (json_size i = 0; i < words; i++) {
-        m = json_load_unaligned_le64(p + 8 * words);
+        m = json_load_unaligned_le64(p + 8 * i);
         v3 ^= m;
         json_sipround(&v0, &v1, &v2, &v3);
         json_sipround(&v0, &v1, &v2, &v3);
@@ -155,7 +281,7 @@ static inline json_uint64 json_siphash(
     }
 
     p += words << 3;
-    m = 0;
+    m = (json_uint64)n << 56;
     switch (bytes) {
     case 7:
         m |= ((uint64_t)p[6] << 48);
@@ -189,9 +315,123 @@ static inline json_uint64 json_siphash(
     return v0 ^ v1 ^ v2 ^ v3;
 }
 
+static inline json_uint64 json_wymix(json_uint64 a, json_uint64 b)
+{
+    struct json_uint128 p = json_mul64(a, b);
+    return p.low ^ p.high;
+}
+
+/**
+ * wyhash of `[data, data + n)`.
+ *
+ * Keys of up to 16 bytes are read as at most four overlapping words and
+ * mixed with a single wide multiplication.
+ */
+static inline json_uint64 json_wyhash(
+    const void *data, json_size n, json_uint64 seed)
+{
+    static const json_uint64 s[] = {
+        0xA0761D6478BD642Full,
+        0xE7037ED1A0B428DBull,
+        0x8EBC6AF09C88C6E3ull,
+        0x589965CC75374CC3ull,
+    };
+    const uint8_t *p = data;
+    json_uint64 a = 0;
+    json_uint64 b = 0;
+    struct json_uint128 m;
+
+    seed ^= json_wymix(seed ^ s[0], s[1]);
+
+    if (n <= 16) {
+        if (n >= 4) {
+            json_size k = (n >> 3) << 2;
+
+            a = json_load_unaligned_le32(p) << 32 |
+                json_load_unaligned_le32(p + k);
+            b = json_load_unaligned_le32(p + n - 4) << 32 |
+                json_load_unaligned_le32(p + n - 4 - k);
+        } else if (n) {
+            a = (json_uint64)p[0] << 16 | (json_uint64)p[n >> 1] << 8 |
+                p[n - 1];
+        }
+    } else {
+        json_size i = n;
+
+        if (i > 48) {
+            json_uint64 see1 = seed;
+            json_uint64 see2 = seed;
+
+            do {
+                seed = json_wymix(
+                    json_load_unaligned_le64(p) ^ s[1],
+                    json_load_unaligned_le64(p + 8) ^ seed);
+                see1 = json_wymix(
+                    json_load_unaligned_le64(p + 16) ^ s[2],
+                    json_load_unaligned_le64(p + 24) ^ see1);
+                see2 = json_wymix(
+                    json_load_unaligned_le64(p + 32) ^ s[3],
+                    json_load_unaligned_le64(p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+
+            seed ^= see1 ^ see2;
+        }
+
+        for (; i > 16; p += 16, i -= 16) {
+            seed = json_wymix(
+                json_load_unaligned_le64(p) ^ s[1],
+                json_load_unaligned_le64(p + 8) ^ seed);
+        }
+
+        a = json_load_unaligned_le64(p + i - 16);
+        b = json_load_unaligned_le64(p + i - 8);
+    }
+
+    m = json_mul64(a ^ s[1], b ^ seed);
+    return json_wymix(m.low ^ s[0] ^ n, m.high ^ s[1]);
+}
+
+/**
+ * Seed of `json_hash`, or zero until one has been chosen.
+ */
+extern _Atomic json_uint64 json_hash_seed_value;
+
+/**
+ * Choose the seed of `json_hash` if no thread has yet, and return it.
+ */
+json_uint64 json_hash_choose_seed(void);
+
+/**
+ * Seed of `json_hash`, chosen at random the first time it is needed and kept
+ * for the life of the process. Once chosen it is a single relaxed load, which
+ * is a plain load on the targets we build for.
+ */
+static inline json_uint64 json_hash_seed(void)
+{
+    json_uint64 seed =
+        atomic_load_explicit(&json_hash_seed_value, memory_order_relaxed);
+
+    return seed ? seed : json_hash_choose_seed();
+}
+
+/**
+ * Hash of an object key.
+ *
+ * wyhash by default. Building with `JSON_SIPHASH` defined to a nonzero value
+ * selects SipHash-2-4 instead, keyed from the same seed. Either way the
+ * random seed keeps keys that collide from being predictable.
+ */
 static inline json_uint64 json_hash(const void *data, json_size n)
 {
-    return json_siphash(data, n, 0xA57C99119D45DB87ull, 0x934E39892F6AB5A4ull);
+#if JSON_SIPHASH
+    json_uint64 seed = json_hash_seed();
+    return json_siphash(
+        data, n, seed, json_wymix(seed, 0x934E39892F6AB5A4ull));
+#else
+    return json_wyhash(data, n, json_hash_seed());
+#endif
 }
 
 static inline int json_compare_int(int a, int b)
@@ -143,19 +143,92 @@ enum json_errc json_value_construct_object_move(
 
 enum json_errc json_value_construct_copy(
     struct json_value *value, const struct json_value *other,
-    struct json_allocator *alloc);
+    struct json_allocator *alloc)
+{
+    alloc = alloc ? alloc : json_value_get_allocator(other);
+
+    switch (other->_type) {
+    case JSON_TYPE_NULL:
+        json_value_construct_null(value, alloc);
+        break;
+    case JSON_TYPE_BOOL:
+        json_value_construct_bool(
+            value, other->_data._primitive._value._bool, alloc);
+        break;
+    case JSON_TYPE_INT:
+        json_value_construct_int(
+            value, other->_data._primitive._value._int, alloc);
+        break;
+    case JSON_TYPE_FLOAT:
+        json_value_construct_float(
+            value, other->_data._primitive._value._float, alloc);
+        break;
+    case JSON_TYPE_STRING:
+        return json_value_construct_string_copy(
+            value, other->_data._string, alloc);
+    case JSON_TYPE_ARRAY:
+        return json_value_construct_array_copy(
+            value, other->_data._array, alloc);
+    case JSON_TYPE_OBJECT:
+        return json_value_construct_object_copy(
+            value, other->_data._object, alloc);
+    default:
+        json_unreachable();
+    }
+
+    return 0;
+}
+
+// The string, array and object of `other` are taken over as they are when
+// they are kept by the same allocator, leaving `other` null.
 
 static enum json_errc json_value_construct_move_with_string(
     struct json_value *value, struct json_value *other,
-    struct json_allocator *alloc);
+    struct json_allocator *alloc)
+{
+    struct json_string *string = other->_data._string;
+
+    if (alloc && !json_allocator_is_equal(alloc, string->_alloc)) {
+        return json_value_construct_string_move(value, string, alloc);
+    }
+
+    value->_type = JSON_TYPE_STRING;
+    value->_data._string = string;
+    json_value_construct_null(other, string->_alloc);
+    return JSON_ERRC_OK;
+}
 
 static enum json_errc json_value_construct_move_with_array(
     struct json_value *value, struct json_value *other,
-    struct json_allocator *alloc);
+    struct json_allocator *alloc)
+{
+    struct json_array *array = other->_data._array;
+
+    if (alloc && !json_allocator_is_equal(alloc, array->_alloc)) {
+        return json_value_construct_array_move(value, array, alloc);
+    }
+
+    value->_type = JSON_TYPE_ARRAY;
+    value->_data._array = array;
+    json_value_construct_null(other, array->_alloc);
+    return JSON_ERRC_OK;
+}
 
 static enum json_errc json_value_construct_move_with_object(
     struct json_value *value, struct json_value *other,
-    struct json_allocator *alloc);
+    struct json_allocator *alloc)
+{
+    struct json_object *object = other->_data._object;
+
+    if (alloc && !json_allocator_is_equal(alloc, object->_alloc)) {
+        return json_value_construct_object_move(value, object, alloc);
+    }
+
+    value->_type = JSON_TYPE_OBJECT;
+    value->_data._object = object;
+    json_value_construct_null(other, object->_alloc);
+    return JSON_ERRC_OK;
+}
 
 enum json_errc json_value_construct_move(
     struct json_value *value, struct json_value *other,
@@ -340,7 +413,6 @@ void json_value_assign_bool(struct json_value *value, json_bool new_value)
 
     switch (value->_type) {
     case JSON_TYPE_NULL:
-        break;
     case JSON_TYPE_BOOL:
     case JSON_TYPE_INT:
     case JSON_TYPE_FLOAT:
@@ -373,7 +445,6 @@ void json_value_assign_int(struct json_value *value, json_int new_value)
 
     switch (value->_type) {
     case JSON_TYPE_NULL:
-        break;
     case JSON_TYPE_BOOL:
     case JSON_TYPE_INT:
     case JSON_TYPE_FLOAT:
@@ -406,7 +477,6 @@ void json_value_assign_float(struct json_value *value, json_float new_value)
 
     switch (value->_type) {
     case JSON_TYPE_NULL:
-        break;
     case JSON_TYPE_BOOL:
     case JSON_TYPE_INT:
     case JSON_TYPE_FLOAT:
@@ -504,20 +574,40 @@ enum json_errc json_value_assign_array_move(
     struct json_value *value, struct json_array *new_value)
 {
     if (json_value_is_array(value)) {
-        json_array_assign_move(value->_data._array, new_value);
+        return json_array_assign_move(value->_data._array, new_value);
     } else {
         struct json_allocator *alloc = json_value_get_allocator(value);
 
         json_value_destruct(value);
-        json_value_construct_array_move(value, new_value, alloc);
+        return json_value_construct_array_move(value, new_value, alloc);
     }
 }
 
 enum json_errc json_value_assign_object_copy(
-    struct json_value *value, const struct json_object *new_value);
+    struct json_value *value, const struct json_object *new_value)
+{
+    if (json_value_is_object(value)) {
+        return json_object_assign_copy(value->_data._object, new_value);
+    } else {
+        struct json_allocator *alloc = json_value_get_allocator(value);
+
+        json_value_destruct(value);
+        return json_value_construct_object_copy(value, new_value, alloc);
+    }
+}
 
 enum json_errc json_value_assign_object_move(
-    struct json_value *value, struct json_object *new_value);
+    struct json_value *value, struct json_object *new_value)
+{
+    if (json_value_is_object(value)) {
+        return json_object_assign_move(value->_data._object, new_value);
+    } else {
+        struct json_allocator *alloc = json_value_get_allocator(value);
+
+        json_value_destruct(value);
+        return json_value_construct_object_move(value, new_value, alloc);
+    }
+}
 
 enum json_errc json_value_assign_copy(
     struct json_value *value, const struct json_value *other)
@@ -551,7 +641,20 @@ enum json_errc json_value_assign_copy(
 }
 
 enum json_errc json_value_assign_move(
-    struct json_value *value, struct json_value *other);
+    struct json_value *value, struct json_value *other)
+{
+    struct json_allocator *alloc = json_value_get_allocator(value);
+
+    if (value == other) {
+        return JSON_ERRC_OK;
+    } else if (!json_allocator_is_equal(
+                   alloc, json_value_get_allocator(other))) {
+        return json_value_assign_copy(value, other);
+    }
+
+    json_value_destruct(value);
+    return json_value_construct_move(value, other, alloc);
+}
 
 json_bool *json_value_as_bool(struct json_value *value)
 {
@@ -0,0 +1,84 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <libjson/array.h>
+#include <libjson/io.h>
+#include <libjson/memory.h>
+#include <libjson/value.h>
+
+#define CHECK(cond)                                                  \
+    do {                                                             \
+        if (!(cond)) {                                               \
+            fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            exit(1);                                                 \
+        }                                                            \
+    } while (0)
+
+// Build `[{"id":0,"name":"item 0"},...]` with `n` elements.
+static char *make_document(json_size n, json_size *size)
+{
+    char *data = malloc(64 * n + 2);
+    char *p = data;
+
+    CHECK(data);
+    *p++ = '[';
+
+    for (json_size i = 0; i < n; i++) {
+        p += sprintf(p, "%s{\"id\":%zu,\"name\":\"item %zu\"}", i ? "," : "",
+                     i, i);
+    }
+
+    *p++ = ']';
+    *size = p - data;
+    return data;
+}
+
+// A document large enough that the reader asks the arena for more than a
+// chunk at once.
+static void test_read_large_document(void)
+{
+    struct json_arena arena;
+    struct json_value value;
+    struct json_read_result result;
+    json_size size;
+    char *data = make_document(20000, &size);
+
+    json_arena_construct(&arena, 0, NULL);
+    json_value_construct(&value, json_arena_allocator(&arena));
+
+    result = json_read_value(data, data + size, &value, NULL);
+    CHECK(!result.ec);
+    CHECK(result.ptr == data + size);
+    CHECK(json_value_is_array(&value));
+    CHECK(json_array_size(json_value_as_array(&value)) == 20000);
+
+    json_value_destruct(&value);
+    json_arena_destruct(&arena);
+    free(data);
+}
+
+// Odd sized requests larger than a chunk.
+static void test_allocate_oversized(void)
+{
+    struct json_arena arena;
+    struct json_allocator *alloc;
+
+    json_arena_construct(&arena, 64, NULL);
+    alloc = json_arena_allocator(&arena);
+
+    for (json_size n = 1; n < 4096; n = 3 * n + 1) {
+        char *p = json_allocator_allocate(alloc, n, 1);
+
+        CHECK(p);
+        memset(p, 'x', n);
+    }
+
+    json_arena_destruct(&arena);
+}
+
+int main(void)
+{
+    test_read_large_document();
+    test_allocate_oversized();
+    return 0;
+}
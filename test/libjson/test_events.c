@@ -0,0 +1,205 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <libjson/errc.h>
+#include <libjson/handler.h>
+#include <libjson/io.h>
+
+#define CHECK(cond)                                                  \
+    do {                                                             \
+        if (!(cond)) {                                               \
+            fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            exit(1);                                                 \
+        }                                                            \
+    } while (0)
+
+// Writes each event to `log` as a short token, and stops after `limit`.
+struct recorder {
+    struct json_handler handler;
+    char log[1024];
+    json_size size;
+    json_size events;
+    json_size limit;
+};
+
+static int record(struct json_handler *self, const char *format, ...)
+{
+    struct recorder *r = (struct recorder *)self;
+    va_list args;
+
+    va_start(args, format);
+    r->size += vsnprintf(
+        r->log + r->size, sizeof(r->log) - r->size, format, args);
+    va_end(args);
+    return ++r->events == r->limit;
+}
+
+static int on_null(struct json_handler *self)
+{
+    return record(self, "n ");
+}
+
+static int on_bool(struct json_handler *self, json_bool value)
+{
+    return record(self, value ? "t " : "f ");
+}
+
+static int on_int(struct json_handler *self, json_int value)
+{
+    return record(self, "i%lld ", value);
+}
+
+static int on_float(struct json_handler *self, json_float value)
+{
+    return record(self, "d%g ", (double)value);
+}
+
+static int on_string(struct json_handler *self, const char *data, json_size n)
+{
+    return record(self, "s%.*s ", (int)n, data);
+}
+
+static int on_key(struct json_handler *self, const char *data, json_size n)
+{
+    return record(self, "k%.*s ", (int)n, data);
+}
+
+static int on_start_array(struct json_handler *self)
+{
+    return record(self, "[ ");
+}
+
+static int on_end_array(struct json_handler *self)
+{
+    return record(self, "] ");
+}
+
+static int on_start_object(struct json_handler *self)
+{
+    return record(self, "{ ");
+}
+
+static int on_end_object(struct json_handler *self)
+{
+    return record(self, "} ");
+}
+
+static void construct_recorder(struct recorder *r)
+{
+    *r = (struct recorder){
+        .handler = {
+            .on_null = on_null,
+            .on_bool = on_bool,
+            .on_int = on_int,
+            .on_float = on_float,
+            .on_string = on_string,
+            .on_key = on_key,
+            .on_start_array = on_start_array,
+            .on_end_array = on_end_array,
+            .on_start_object = on_start_object,
+            .on_end_object = on_end_object,
+        },
+    };
+}
+
+static struct json_read_result read_events(
+    const char *text, struct recorder *r,
+    const struct json_read_options *options)
+{
+    return json_read_events(text, text + strlen(text), &r->handler, options);
+}
+
+static void test_events(void)
+{
+    static const struct {
+        const char *text;
+        const char *log;
+    } docs[] = {
+        { "null", "n " },
+        { " -7 ", "i-7 " },
+        { "2.5", "d2.5 " },
+        { "\"a\\nb\"", "sa\nb " },
+        { "[]", "[ ] " },
+        { "{}", "{ } " },
+        { "[true,false,[null]]", "[ t f [ n ] ] " },
+        { "{\"a\":1,\"b\\u0021\":{\"c\":[\"d\"]},\"a\":2}",
+          "{ ka i1 kb! { kc [ sd ] } ka i2 } " },
+    };
+
+    for (json_size i = 0; i < sizeof(docs) / sizeof(*docs); i++) {
+        struct recorder r;
+        struct json_read_result res;
+
+        construct_recorder(&r);
+        res = read_events(docs[i].text, &r, NULL);
+        CHECK(!res.ec);
+        CHECK(!strcmp(r.log, docs[i].log));
+    }
+}
+
+// A document that fails partway never closes the containers it opened.
+static void test_errors(void)
+{
+    static const char *docs[] = {
+        "[1,]", "{\"a\" 1}", "[1 2]", "[\"\\x\"]", "{\"a\":[}", "[1e400]",
+    };
+
+    for (json_size i = 0; i < sizeof(docs) / sizeof(*docs); i++) {
+        struct recorder r;
+
+        construct_recorder(&r);
+        CHECK(read_events(docs[i], &r, NULL).ec);
+        CHECK(!strstr(r.log, "] ") && !strstr(r.log, "} "));
+    }
+}
+
+// A callback returning nonzero stops the read right after its event.
+static void test_cancel(void)
+{
+    static const char text[] = "{\"a\":[1,2,3],\"b\":null}";
+
+    for (json_size limit = 1; limit <= 9; limit++) {
+        struct recorder r;
+
+        construct_recorder(&r);
+        r.limit = limit;
+        CHECK(read_events(text, &r, NULL).ec == JSON_ERRC_CANCELLED);
+        CHECK(r.events == limit);
+    }
+}
+
+// Tokens without a callback are skipped.
+static void test_null_callbacks(void)
+{
+    struct recorder r;
+
+    construct_recorder(&r);
+    r.handler.on_key = NULL;
+    r.handler.on_int = NULL;
+    r.handler.on_start_object = NULL;
+    CHECK(!read_events("{\"a\":1,\"b\":[2,\"c\"]}", &r, NULL).ec);
+    CHECK(!strcmp(r.log, "[ sc ] } "));
+}
+
+static void test_max_depth(void)
+{
+    struct json_read_options options = { .max_depth = 2 };
+    struct recorder r;
+
+    construct_recorder(&r);
+    CHECK(!read_events("[[1]]", &r, &options).ec);
+
+    construct_recorder(&r);
+    CHECK(read_events("[[[1]]]", &r, &options).ec == JSON_ERRC_MAX_DEPTH);
+}
+
+int main(void)
+{
+    test_events();
+    test_errors();
+    test_cancel();
+    test_null_callbacks();
+    test_max_depth();
+    return 0;
+}
@@ -0,0 +1,123 @@
+// Needed for mkstemp and fork under strict ISO C modes.
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <libjson/array.h>
+#include <libjson/errc.h>
+#include <libjson/io.h>
+#include <libjson/object.h>
+#include <libjson/value.h>
+
+#define CHECK(cond)                                                  \
+    do {                                                             \
+        if (!(cond)) {                                               \
+            fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            exit(1);                                                 \
+        }                                                            \
+    } while (0)
+
+static char path[] = "/tmp/libjson-test-file-XXXXXX";
+
+static void write_file(const char *text)
+{
+    int fd = mkstemp(path);
+    json_size n = strlen(text);
+
+    CHECK(fd >= 0);
+    CHECK(write(fd, text, n) == (ssize_t)n);
+    close(fd);
+}
+
+static enum json_errc read_file(const char *text, struct json_value *value)
+{
+    enum json_errc ec;
+
+    write_file(text);
+    json_value_construct(value, NULL);
+    ec = json_read_file(path, value, NULL);
+    unlink(path);
+    memcpy(path + sizeof(path) - 7, "XXXXXX", 6);
+    return ec;
+}
+
+static void test_mapped(void)
+{
+    struct json_value value;
+
+    CHECK(!read_file(" {\"a\": [1, 2.5, \"x\"]}\n\t", &value));
+    CHECK(json_array_size(json_value_as_array(
+              json_object_at(json_value_as_object(&value), "a", 1))) == 3);
+    json_value_destruct(&value);
+}
+
+// Files that are empty or hold only whitespace have no value, and those with
+// anything after their value are rejected whole.
+static void test_invalid(void)
+{
+    static const char *texts[] = { "", " \n ", "[1] 2", "{}x", "[1" };
+    struct json_value value;
+
+    for (json_size i = 0; i < sizeof(texts) / sizeof(*texts); i++) {
+        CHECK(read_file(texts[i], &value) == JSON_ERRC_UNEXPECTED_TOKEN);
+        json_value_destruct(&value);
+    }
+}
+
+static void test_missing(void)
+{
+    struct json_value value;
+
+    json_value_construct(&value, NULL);
+    CHECK(json_read_file("/nonexistent/libjson.json", &value, NULL) ==
+          JSON_ERRC_IO_ERROR);
+    CHECK(json_read_file("/tmp", &value, NULL) == JSON_ERRC_IO_ERROR);
+    CHECK(json_read_fd(-1, &value, NULL) == JSON_ERRC_IO_ERROR);
+    json_value_destruct(&value);
+}
+
+// Pipes cannot be mapped, so they are read into a buffer that grows past its
+// initial size.
+static void test_pipe(void)
+{
+    static char text[200000];
+    struct json_value value;
+    json_size n = 0;
+    int fds[2];
+    int status;
+
+    text[n++] = '[';
+    while (n < sizeof(text) - 16) {
+        n += sprintf(text + n, "%s%zu", n > 1 ? "," : "", n);
+    }
+    text[n++] = ']';
+
+    CHECK(!pipe(fds));
+
+    if (!fork()) {
+        close(fds[0]);
+        CHECK(write(fds[1], text, n) == (ssize_t)n);
+        _exit(0);
+    }
+
+    close(fds[1]);
+    json_value_construct(&value, NULL);
+    CHECK(!json_read_fd(fds[0], &value, NULL));
+    CHECK(json_array_size(json_value_as_array(&value)) > 20000);
+    json_value_destruct(&value);
+    close(fds[0]);
+
+    CHECK(wait(&status) > 0 && WIFEXITED(status) && !WEXITSTATUS(status));
+}
+
+int main(void)
+{
+    test_mapped();
+    test_invalid();
+    test_missing();
+    test_pipe();
+    return 0;
+}
@@ -0,0 +1,114 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../../src/libjson/util.h"
+
+#define CHECK(cond)                                                  \
+    do {                                                             \
+        if (!(cond)) {                                               \
+            fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            exit(1);                                                 \
+        }                                                            \
+    } while (0)
+
+#define THREADS 8
+
+// Vectors from the SipHash paper: key bytes 0..15, messages of bytes 0..n-1.
+static void test_siphash(void)
+{
+    json_uint64 k0 = 0x0706050403020100ull;
+    json_uint64 k1 = 0x0F0E0D0C0B0A0908ull;
+    unsigned char message[15];
+
+    for (int i = 0; i < 15; i++) {
+        message[i] = i;
+    }
+
+    CHECK(json_siphash(message, 0, k0, k1) == 0x726FDB47DD0E0E31ull);
+    CHECK(json_siphash(message, 1, k0, k1) == 0x74F839C593DC67FDull);
+    CHECK(json_siphash(message, 8, k0, k1) == 0x93F5F5799A932462ull);
+    CHECK(json_siphash(message, 15, k0, k1) == 0xA129CA6149BE45E5ull);
+}
+
+static void test_seed(void)
+{
+    json_uint64 seed = json_hash_seed();
+
+    CHECK(seed & 1);
+    CHECK(json_hash_seed() == seed);
+    CHECK(atomic_load(&json_hash_seed_value) == seed);
+}
+
+static void *seed_thread(void *seed)
+{
+    *(json_uint64 *)seed = json_hash_seed();
+    return NULL;
+}
+
+// Threads that find no seed race to choose one, and all end up with the
+// first one stored.
+static void test_seed_race(void)
+{
+    pthread_t threads[THREADS];
+    json_uint64 seeds[THREADS];
+
+    for (int round = 0; round < 20; round++) {
+        atomic_store(&json_hash_seed_value, 0);
+
+        for (int i = 0; i < THREADS; i++) {
+            CHECK(!pthread_create(threads + i, NULL, seed_thread, seeds + i));
+        }
+        for (int i = 0; i < THREADS; i++) {
+            CHECK(!pthread_join(threads[i], NULL));
+        }
+
+        for (int i = 0; i < THREADS; i++) {
+            CHECK(seeds[i] == seeds[0]);
+        }
+        CHECK(seeds[0] & 1);
+        CHECK(json_hash_seed() == seeds[0]);
+    }
+}
+
+// The hash depends on the seed, and on every byte and the length of the key,
+// including the chunk boundaries of both hash functions.
+static void test_hash(void)
+{
+    char key[80];
+    json_uint64 seed = json_hash_seed();
+
+    for (json_size i = 0; i < sizeof(key); i++) {
+        key[i] = 'a' + i % 26;
+    }
+
+    for (json_size n = 0; n <= sizeof(key); n++) {
+        json_uint64 hash = json_hash(key, n);
+
+        CHECK(json_hash(key, n) == hash);
+
+        if (n < sizeof(key)) {
+            CHECK(json_hash(key, n + 1) != hash);
+        }
+
+        for (json_size i = 0; i < n; i++) {
+            key[i] ^= 1;
+            CHECK(json_hash(key, n) != hash);
+            key[i] ^= 1;
+        }
+
+        atomic_store(&json_hash_seed_value, seed + 2);
+        CHECK(json_hash(key, n) != hash);
+        atomic_store(&json_hash_seed_value, seed);
+    }
+}
+
+int main(void)
+{
+    test_siphash();
+    test_seed();
+    test_seed_race();
+    test_hash();
+    return 0;
+}
@@ -0,0 +1,152 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <libjson/array.h>
+#include <libjson/errc.h>
+#include <libjson/io.h>
+#include <libjson/object.h>
+#include <libjson/string.h>
+#include <libjson/value.h>
+
+#define CHECK(cond)                                                  \
+    do {                                                             \
+        if (!(cond)) {                                               \
+            fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            exit(1);                                                 \
+        }                                                            \
+    } while (0)
+
+static char buf[256];
+
+// The original input, whose copy in `buf` is read and modified.
+static const char *text;
+
+static int in_buf(const char *p)
+{
+    return p >= buf && p < buf + sizeof(buf);
+}
+
+// Where `literal` was in the input.
+static char *find(const char *literal)
+{
+    return buf + (strstr(text, literal) - text);
+}
+
+// Whether `string` holds `expected`, borrowed from the input right where the
+// literal starting with `literal` was.
+static void check_borrowed(
+    struct json_string *string, const char *expected, const char *literal)
+{
+    json_size n = strlen(expected);
+
+    CHECK(json_string_size(string) == n);
+    CHECK(!memcmp(json_string_data(string), expected, n));
+    CHECK(json_string_data(string) == find(literal) + 1);
+    CHECK(json_string_data(string)[n] == 0);
+    CHECK(json_string_capacity(string) == 0);
+}
+
+static void test_borrowed(void)
+{
+    static const char input[] =
+        "{\"plain\": \"abc\", \"esc\\u0061ped\": [\"a\\nb\\\"c\", "
+        "\"\\u00e9\\ud834\\udd1e\", \"\"]}";
+    struct json_value value;
+    struct json_object *object;
+    struct json_array *array;
+    struct json_object_iter iter;
+    struct json_read_result res;
+
+    text = input;
+    memcpy(buf, input, sizeof(input));
+    json_value_construct(&value, NULL);
+    res = json_read_value_insitu(buf, buf + sizeof(input) - 1, &value, NULL);
+    CHECK(!res.ec);
+    CHECK(res.ptr == buf + sizeof(input) - 1);
+
+    object = json_value_as_object(&value);
+    check_borrowed(
+        json_value_as_string(json_object_at(object, "plain", 5)), "abc",
+        "\"abc");
+
+    array = json_value_as_array(json_object_at(object, "escaped", 7));
+    CHECK(array && json_array_size(array) == 3);
+    check_borrowed(
+        json_value_as_string(json_array_at(array, 0)), "a\nb\"c", "\"a\\n");
+    check_borrowed(
+        json_value_as_string(json_array_at(array, 1)),
+        "\xc3\xa9\xf0\x9d\x84\x9e", "\"\\u00e9");
+    CHECK(json_string_empty(json_value_as_string(json_array_at(array, 2))));
+
+    // Keys are unescaped in place too.
+    json_object_begin(object, &iter);
+    CHECK(in_buf(json_string_data(json_object_iter_key(&iter))));
+    json_object_iter_next(&iter);
+    check_borrowed(json_object_iter_key(&iter), "escaped", "\"esc\\u");
+
+    // Changing a borrowed string copies it first, leaving the input alone.
+    CHECK(!json_string_append(
+        json_value_as_string(json_object_at(object, "plain", 5)), "d", 1));
+    CHECK(!in_buf(json_string_data(
+        json_value_as_string(json_object_at(object, "plain", 5)))));
+    CHECK(!memcmp(find("abc"), "abc\0", 4));
+
+    json_value_destruct(&value);
+}
+
+// Invalid bytes to be replaced may not fit in place, so the string is copied.
+static void test_replaced(void)
+{
+    static const char input[] = "[\"a\xffz\", \"ok\"]";
+    struct json_read_options options = {
+        .max_depth = 250,
+        .accept_invalid_code_points = json_true,
+        .replace_invalid_code_points = json_true,
+    };
+    struct json_value value;
+    struct json_array *array;
+    struct json_string *string;
+
+    memcpy(buf, input, sizeof(input));
+    json_value_construct(&value, NULL);
+    CHECK(!json_read_value_insitu(
+               buf, buf + sizeof(input) - 1, &value, &options)
+               .ec);
+
+    array = json_value_as_array(&value);
+    string = json_value_as_string(json_array_at(array, 0));
+    CHECK(!in_buf(json_string_data(string)));
+    CHECK(json_string_size(string) == 5);
+    CHECK(!memcmp(json_string_data(string), "a\xef\xbf\xbdz", 5));
+
+    string = json_value_as_string(json_array_at(array, 1));
+    CHECK(in_buf(json_string_data(string)));
+
+    json_value_destruct(&value);
+}
+
+static void test_errors(void)
+{
+    static const char *texts[] = {
+        "[\"abc", "[\"\\x\"]", "{\"a\":1,\"a\":2}", "[\"\xc0\x80\"]",
+        "[\"\x01\"]",
+    };
+
+    for (json_size i = 0; i < sizeof(texts) / sizeof(*texts); i++) {
+        json_size n = strlen(texts[i]);
+        struct json_value value;
+
+        memcpy(buf, texts[i], n);
+        json_value_construct(&value, NULL);
+        CHECK(json_read_value_insitu(buf, buf + n, &value, NULL).ec);
+        json_value_destruct(&value);
+    }
+}
+
+int main(void)
+{
+    test_borrowed();
+    test_replaced();
+    test_errors();
+    return 0;
+}
@@ -0,0 +1,197 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <libjson/errc.h>
+#include <libjson/handler.h>
+#include <libjson/io.h>
+#include <libjson/value.h>
+
+#define CHECK(cond)                                                  \
+    do {                                                             \
+        if (!(cond)) {                                               \
+            fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            exit(1);                                                 \
+        }                                                            \
+    } while (0)
+
+#define LINES 20000
+#define THREADS 4
+
+// Every seventh line is blank and every thirteenth invalid; the others hold
+// their own number.
+static char input[LINES * 32];
+
+struct recorder {
+    struct json_line_handler handler;
+    pthread_mutex_t mutex;
+    unsigned char seen[LINES];
+    json_size values;
+    json_size errors;
+    json_size delivered;
+    json_size last;
+    json_bool in_order;
+    json_size stop_at;
+    json_bool stopped;
+    json_size after_stop;
+};
+
+static json_bool is_blank(json_size line)
+{
+    return line % 7 == 3;
+}
+
+static json_bool is_invalid(json_size line)
+{
+    return !is_blank(line) && line % 13 == 5;
+}
+
+static json_size make_input(void)
+{
+    json_size n = 0;
+
+    for (json_size line = 0; line < LINES; line++) {
+        if (is_blank(line)) {
+            n += sprintf(input + n, line % 2 ? "\n" : "  \t\r\n");
+        } else if (is_invalid(line)) {
+            n += sprintf(input + n, "{\"line\": %zu,}\n", line);
+        } else {
+            n += sprintf(input + n, " {\"line\": %zu} \r\n", line);
+        }
+    }
+
+    return n;
+}
+
+// Records a delivery of `line`, and asks to stop at `stop_at` or, once
+// stopped, at any later line from another thread.
+static int deliver(struct recorder *r, json_size line, json_bool error)
+{
+    int stop;
+
+    pthread_mutex_lock(&r->mutex);
+    CHECK(line < LINES && !r->seen[line]);
+    r->seen[line] = 1;
+    r->values += !error;
+    r->errors += error;
+    r->after_stop += r->stopped;
+    r->in_order &= !r->delivered++ || line > r->last;
+    r->last = line;
+    stop = r->stopped || line == r->stop_at;
+    r->stopped = stop;
+    pthread_mutex_unlock(&r->mutex);
+    return stop;
+}
+
+static int on_value(
+    struct json_line_handler *self, json_size line, struct json_value *value)
+{
+    CHECK(!is_blank(line) && !is_invalid(line));
+    CHECK(json_value_is_object(value));
+    return deliver((struct recorder *)self, line, json_false);
+}
+
+static int on_error(
+    struct json_line_handler *self, json_size line, enum json_errc ec)
+{
+    CHECK(is_invalid(line));
+    CHECK(ec == JSON_ERRC_UNEXPECTED_TOKEN);
+    return deliver((struct recorder *)self, line, json_true);
+}
+
+static enum json_errc read_lines(
+    struct recorder *r, json_size n, json_bool ordered, json_size stop_at)
+{
+    struct json_read_lines_options options = {
+        .threads = THREADS,
+        .ordered = ordered,
+    };
+
+    memset(r, 0, sizeof(*r));
+    r->handler.on_value = on_value;
+    r->handler.on_error = on_error;
+    r->in_order = json_true;
+    r->stop_at = stop_at;
+    pthread_mutex_init(&r->mutex, NULL);
+    return json_read_lines(input, input + n, &r->handler, &options);
+}
+
+static void test_all_lines(json_size n)
+{
+    json_size values = 0;
+    json_size errors = 0;
+
+    for (json_size line = 0; line < LINES; line++) {
+        values += !is_blank(line) && !is_invalid(line);
+        errors += is_invalid(line);
+    }
+
+    for (int ordered = 0; ordered < 2; ordered++) {
+        static struct recorder r;
+
+        CHECK(!read_lines(&r, n, ordered, LINES));
+        CHECK(r.values == values);
+        CHECK(r.errors == errors);
+        CHECK(!ordered || r.in_order);
+        pthread_mutex_destroy(&r.mutex);
+    }
+}
+
+// A handler that stops the read in the middle gets no more lines in order,
+// and at most the one each other thread was reading out of order.
+static void test_stop(json_size n)
+{
+    for (int ordered = 0; ordered < 2; ordered++) {
+        static struct recorder r;
+        json_size stop_at = LINES / 2;
+
+        CHECK(read_lines(&r, n, ordered, stop_at) == JSON_ERRC_CANCELLED);
+        CHECK(r.stopped);
+        CHECK(r.seen[stop_at]);
+
+        if (ordered) {
+            CHECK(r.in_order);
+            CHECK(r.last == stop_at && !r.after_stop);
+            for (json_size line = 0; line < stop_at; line++) {
+                CHECK(r.seen[line] || is_blank(line));
+            }
+        } else {
+            CHECK(r.after_stop < THREADS);
+        }
+
+        pthread_mutex_destroy(&r.mutex);
+    }
+}
+
+// Without `on_error`, the first invalid line stops the read with its error.
+static void test_first_error(json_size n)
+{
+    static struct recorder r;
+    struct json_read_lines_options options = {
+        .threads = THREADS,
+        .ordered = json_true,
+    };
+
+    memset(&r, 0, sizeof(r));
+    r.handler.on_value = on_value;
+    r.stop_at = LINES;
+    r.in_order = json_true;
+    pthread_mutex_init(&r.mutex, NULL);
+
+    CHECK(json_read_lines(input, input + n, &r.handler, &options) ==
+          JSON_ERRC_UNEXPECTED_TOKEN);
+    CHECK(r.in_order);
+    CHECK(r.last < 5 && r.values == 4);
+
+    pthread_mutex_destroy(&r.mutex);
+}
+
+int main(void)
+{
+    json_size n = make_input();
+
+    test_all_lines(n);
+    test_stop(n);
+    test_first_error(n);
+    return 0;
+}
@@ -0,0 +1,159 @@
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <libjson/errc.h>
+#include <libjson/io.h>
+#include <libjson/value.h>
+
+#define CHECK(cond)                                                  \
+    do {                                                             \
+        if (!(cond)) {                                               \
+            fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            exit(1);                                                 \
+        }                                                            \
+    } while (0)
+
+#define COUNT(a) (sizeof(a) / sizeof(*(a)))
+
+// Read `text` as a value, which must succeed.
+static void read_value(const char *text, struct json_value *value)
+{
+    struct json_read_result res;
+
+    json_value_construct(value, NULL);
+    res = json_read_value(text, text + strlen(text), value, NULL);
+    CHECK(!res.ec);
+    CHECK(res.ptr == text + strlen(text));
+}
+
+static void check_int(const char *text, json_int expected)
+{
+    struct json_value value;
+    json_int n;
+
+    read_value(text, &value);
+    CHECK(json_value_is_int(&value));
+    CHECK(*json_value_as_int(&value) == expected);
+    json_value_destruct(&value);
+
+    CHECK(!json_read_int(text, text + strlen(text), &n, NULL).ec);
+    CHECK(n == expected);
+}
+
+// `text` is read as the float that `strtod` reads it as.
+static void check_float(const char *text)
+{
+    double expected = strtod(text, NULL);
+    struct json_value value;
+    json_float f;
+
+    read_value(text, &value);
+    CHECK(json_value_is_float(&value));
+    CHECK((double)*json_value_as_float(&value) == expected);
+    CHECK(!signbit(*json_value_as_float(&value)) == !signbit(expected));
+    json_value_destruct(&value);
+
+    CHECK(!json_read_float(text, text + strlen(text), &f, NULL).ec);
+    CHECK((double)f == expected);
+}
+
+static void test_ints(void)
+{
+    check_int("0", 0);
+    check_int("-0", 0);
+    check_int("1", 1);
+    check_int("-1", -1);
+    check_int("9223372036854775807", INT64_MAX);
+    check_int("-9223372036854775808", INT64_MIN);
+
+    // 19 digits, the most the mantissa always holds.
+    check_int("1000000000000000000", 1000000000000000000);
+    check_int("1234567890123456789", 1234567890123456789);
+    check_int("-1234567890123456789", -1234567890123456789);
+}
+
+// Integers outside the range of `json_int` are read as floats by
+// `json_read_value` and rejected by `json_read_int`.
+static void test_int_overflow(void)
+{
+    static const char *texts[] = {
+        "9223372036854775808",  "-9223372036854775809",
+        "9999999999999999999",  "-9999999999999999999",
+        "10000000000000000000", "18446744073709551615",
+        "18446744073709551616", "-18446744073709551616",
+        "123456789012345678901234567890",
+    };
+
+    for (json_size i = 0; i < COUNT(texts); i++) {
+        const char *text = texts[i];
+        json_int n;
+
+        check_float(text);
+        CHECK(json_read_int(text, text + strlen(text), &n, NULL).ec ==
+              JSON_ERRC_NUMBER_OUT_OF_RANGE);
+    }
+}
+
+static void test_floats(void)
+{
+    static const char *texts[] = {
+        "-0.0", "0e10", "-0e-10", "0.0000", "1.5", "-1.5e3", "1E2", "0.1",
+        "3.141592653589793", "1e22", "1e23", "1.7976931348623157e308",
+        "2.2250738585072014e-308",
+
+        // Exactly halfway between two doubles, rounding to the even one.
+        "9007199254740993.0", "9007199254740995e0", "90071992547409930e-1",
+        "1.00000000000000011102230246251565404236316680908203125",
+        "1.00000000000000033306690738754696212708950042724609375",
+
+        // Just above or below halfway, past the first 19 digits.
+        "9007199254740993.0000000000000000001",
+        "9007199254740992.9999999999999999999",
+        "1.00000000000000011102230246251565404236316680908203126",
+        "1.00000000000000011102230246251565404236316680908203124",
+
+        // Subnormals, and the halfway points around the smallest one.
+        "2.2250738585072011e-308", "2.2250738585072009e-308",
+        "4.9406564584124654e-324", "5e-324", "1e-320",
+        "2.4703282292062328e-324", "2.4703282292062327e-324",
+        "7.4109846876186982e-324", "1e-400", "-1e-400",
+
+        // Rounds down to the largest double.
+        "1.7976931348623158e308",
+    };
+
+    for (json_size i = 0; i < COUNT(texts); i++) {
+        check_float(texts[i]);
+    }
+}
+
+static void test_float_overflow(void)
+{
+    static const char *texts[] = {
+        "1e309", "-1e309", "1.7976931348623159e308", "1e100000000",
+    };
+
+    for (json_size i = 0; i < COUNT(texts); i++) {
+        const char *text = texts[i];
+        struct json_value value;
+        json_float f;
+
+        json_value_construct(&value, NULL);
+        CHECK(json_read_value(text, text + strlen(text), &value, NULL).ec ==
+              JSON_ERRC_NUMBER_OUT_OF_RANGE);
+        CHECK(json_read_float(text, text + strlen(text), &f, NULL).ec ==
+              JSON_ERRC_NUMBER_OUT_OF_RANGE);
+        json_value_destruct(&value);
+    }
+}
+
+int main(void)
+{
+    test_ints();
+    test_int_overflow();
+    test_floats();
+    test_float_overflow();
+    return 0;
+}
@@ -0,0 +1,495 @@
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <libjson/entry.h>
+#include <libjson/errc.h>
+#include <libjson/memory.h>
+#include <libjson/object.h>
+#include <libjson/string.h>
+#include <libjson/value.h>
+#include "../../src/libjson/table.h"
+
+#define CHECK(cond)                                                  \
+    do {                                                             \
+        if (!(cond)) {                                               \
+            fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            exit(1);                                                 \
+        }                                                            \
+    } while (0)
+
+#define COUNT 5000
+
+// The most entries a single insertion may move: the first segment of a small
+// object, which is also how many entries incremental rehashing moves to the
+// new index per insertion.
+#define MAX_MOVED 8
+
+static json_size make_key(char *key, json_size i)
+{
+    return sprintf(key, "key %zu", i);
+}
+
+// Every key inserted so far is found, including those still covered only by
+// the previous index while it is being replaced.
+static void check_keys(struct json_object *object, json_size n)
+{
+    char key[32];
+
+    for (json_size i = 0; i < n; i++) {
+        struct json_value *value =
+            json_object_at(object, key, make_key(key, i));
+
+        CHECK(value && json_value_is_int(value));
+        CHECK(*json_value_as_int(value) == (json_int)i);
+    }
+}
+
+static void test_emplace(json_bool incremental)
+{
+    struct json_object object;
+    char key[32];
+
+    json_object_construct(&object, NULL);
+    json_object_set_incremental_rehash(&object, incremental);
+
+    for (json_size i = 0; i < COUNT; i++) {
+        json_size n = make_key(key, i);
+
+        CHECK(!json_object_emplace_int(&object, key, n, i, NULL));
+        CHECK(json_object_size(&object) == i + 1);
+
+        // Look up both ends of the object after every growth.
+        if (!(i & (i + 1))) {
+            check_keys(&object, i + 1);
+        } else {
+            CHECK(json_object_contains(&object, "key 0", 5));
+            CHECK(json_object_contains(&object, key, n));
+        }
+    }
+
+    check_keys(&object, COUNT);
+    CHECK(json_object_emplace_null(&object, "key 7", 5, NULL) ==
+          JSON_ERRC_DUPLICATE_KEY);
+    CHECK(json_object_size(&object) == COUNT);
+
+    json_object_set_incremental_rehash(&object, json_false);
+    check_keys(&object, COUNT);
+    json_object_destruct(&object);
+}
+
+static void test_insert(void)
+{
+    struct json_object object;
+    struct json_object copy;
+    struct json_object_iter it;
+    struct json_value value;
+
+    json_object_construct(&object, NULL);
+    json_object_set_incremental_rehash(&object, json_true);
+    json_value_construct_int(&value, 1, NULL);
+
+    CHECK(!json_object_insert_copy(&object, "a", 1, &value, &it));
+    CHECK(*json_value_as_int(json_object_iter_value(&it)) == 1);
+
+    *json_value_as_int(&value) = 2;
+    CHECK(json_object_insert_move(&object, "a", 1, &value, &it) ==
+          JSON_ERRC_DUPLICATE_KEY);
+    CHECK(*json_value_as_int(json_object_iter_value(&it)) == 1);
+    CHECK(json_string_size(json_object_iter_key(&it)) == 1);
+
+    CHECK(!json_object_insert_move(&object, "b", 1, &value, NULL));
+    CHECK(*json_value_as_int(json_object_at(&object, "b", 1)) == 2);
+
+    CHECK(!json_object_construct_copy(&copy, &object, NULL));
+    CHECK(json_object_size(&copy) == 2);
+    CHECK(*json_value_as_int(json_object_at(&copy, "a", 1)) == 1);
+
+    json_object_destruct(&copy);
+    json_object_destruct(&object);
+}
+
+// Copies reuse the hashes cached in the entries they copy, including small
+// objects whose entries have none yet and get them when they grow.
+static void test_copy_hashes(void)
+{
+    static const json_size sizes[] = { 0, 1, 8, 9, 15, 16, COUNT };
+    char key[32];
+
+    for (json_size s = 0; s < sizeof(sizes) / sizeof(*sizes); s++) {
+        struct json_object object;
+        struct json_object copy;
+
+        json_object_construct(&object, NULL);
+
+        for (json_size i = 0; i < sizes[s]; i++) {
+            CHECK(!json_object_emplace_int(
+                &object, key, make_key(key, i), i, NULL));
+        }
+
+        CHECK(!json_object_construct_copy(&copy, &object, NULL));
+        CHECK(json_object_size(&copy) == sizes[s]);
+        check_keys(&copy, sizes[s]);
+
+        // Grow the copy past the linear scan and past its next index.
+        for (json_size i = sizes[s]; i < sizes[s] + 20; i++) {
+            CHECK(!json_object_emplace_int(
+                &copy, key, make_key(key, i), i, NULL));
+        }
+
+        check_keys(&copy, sizes[s] + 20);
+        CHECK(!json_object_assign_copy(&object, &copy));
+        check_keys(&object, sizes[s] + 20);
+
+        json_object_destruct(&copy);
+        json_object_destruct(&object);
+    }
+}
+
+static json_size max_reallocated;
+
+static void *counting_allocate(
+    struct json_allocator *self, json_size bytes, json_size alignment)
+{
+    (void)self;
+    (void)alignment;
+    return malloc(bytes);
+}
+
+static void counting_deallocate(
+    struct json_allocator *self, void *p, json_size bytes, json_size alignment)
+{
+    (void)self;
+    (void)bytes;
+    (void)alignment;
+    free(p);
+}
+
+static json_bool counting_is_equal(
+    const struct json_allocator *self, const struct json_allocator *other)
+{
+    return self == other;
+}
+
+// Record the largest block moved.
+static void *counting_reallocate(
+    struct json_allocator *self, void *p, json_size old_bytes,
+    json_size new_bytes, json_size alignment)
+{
+    void *q = counting_allocate(self, new_bytes, alignment);
+
+    if (q) {
+        memcpy(q, p, old_bytes < new_bytes ? old_bytes : new_bytes);
+        free(p);
+    }
+
+    if (old_bytes > max_reallocated) {
+        max_reallocated = old_bytes;
+    }
+
+    return q;
+}
+
+static struct json_allocator_methods counting_methods = {
+    .allocate = counting_allocate,
+    .deallocate = counting_deallocate,
+    .is_equal = counting_is_equal,
+    .reallocate = counting_reallocate,
+};
+
+// Growing never moves the entries past the first segment, so no insertion
+// moves more than a few entries however large the object is.
+static void test_bounded_growth(void)
+{
+    static struct json_value *values[COUNT];
+    struct json_allocator alloc;
+    struct json_object object;
+    char key[32];
+
+    json_allocator_construct(&alloc, &counting_methods);
+    json_object_construct(&object, &alloc);
+    json_object_set_incremental_rehash(&object, json_true);
+
+    for (json_size i = 0; i < COUNT; i++) {
+        json_size n = make_key(key, i);
+
+        CHECK(!json_object_emplace_int(&object, key, n, i, NULL));
+        values[i] = json_object_at(&object, key, n);
+    }
+
+    CHECK(max_reallocated <= MAX_MOVED * sizeof(struct json_entry));
+
+    for (json_size i = MAX_MOVED; i < COUNT; i++) {
+        CHECK(json_object_at(&object, key, make_key(key, i)) == values[i]);
+    }
+
+    check_keys(&object, COUNT);
+    json_object_destruct(&object);
+}
+
+// Group matching finds exactly the control bytes a scalar scan does.
+static void test_table_match(void)
+{
+    _Alignas(16) unsigned char ctrl[JSON_TABLE_GROUP_WIDTH];
+
+    srand(1);
+
+    for (int round = 0; round < 1000; round++) {
+        unsigned char c = round & 1 ? JSON_TABLE_EMPTY : rand() & 0x7F;
+        unsigned expected = 0;
+
+        for (unsigned i = 0; i < JSON_TABLE_GROUP_WIDTH; i++) {
+            ctrl[i] = rand() % 3 ? rand() & 0x7F : c;
+            expected |= (unsigned)(ctrl[i] == c) << i;
+        }
+
+        CHECK(json_table_match(ctrl, c) == expected);
+    }
+}
+
+// Keys whose hashes all start probing in the same group overflow it into the
+// next groups, and are still found there. Keys that are missing but share
+// seven bits of hash with one that is not are rejected by comparing them.
+static void test_collisions(json_bool incremental)
+{
+    // An index of four groups, of which the keys fill more than two.
+    enum { CAPACITY = 4 * JSON_TABLE_GROUP_WIDTH, COLLIDING = 40 };
+    static char keys[COLLIDING][32];
+    static char missing[COLLIDING][32];
+    json_size found = 0;
+    json_size misses = 0;
+    struct json_object object;
+
+    for (json_size i = 0; found < COLLIDING || misses < COLLIDING; i++) {
+        char key[32];
+        json_size n = make_key(key, i);
+        json_uint64 hash = json_hash(key, n);
+        json_size group =
+            json_table_h1(hash) & (CAPACITY / JSON_TABLE_GROUP_WIDTH - 1);
+
+        if (group) {
+            continue;
+        } else if (found < COLLIDING) {
+            memcpy(keys[found++], key, n + 1);
+        } else {
+            for (json_size k = 0; k < COLLIDING; k++) {
+                json_uint64 other = json_hash(keys[k], strlen(keys[k]));
+
+                if (json_table_h2(other) == json_table_h2(hash)) {
+                    memcpy(missing[misses++], key, n + 1);
+                    break;
+                }
+            }
+        }
+    }
+
+    json_object_construct(&object, NULL);
+    json_object_set_incremental_rehash(&object, incremental);
+    CHECK(!json_object_reserve(&object, COLLIDING));
+    CHECK(object._capacity == CAPACITY);
+
+    for (json_size i = 0; i < COLLIDING; i++) {
+        CHECK(!json_object_emplace_int(
+            &object, keys[i], strlen(keys[i]), i, NULL));
+    }
+
+    CHECK(object._capacity == CAPACITY);
+
+    // Grow the index, which scatters the keys again, and look them up both
+    // before and after.
+    for (int pass = 0; pass < 2; pass++) {
+        for (json_size i = 0; i < COLLIDING; i++) {
+            struct json_value *value =
+                json_object_at(&object, keys[i], strlen(keys[i]));
+
+            CHECK(value && *json_value_as_int(value) == (json_int)i);
+            CHECK(!json_object_contains(
+                &object, missing[i], strlen(missing[i])));
+        }
+
+        for (json_size i = COLLIDING; i < 2 * CAPACITY; i++) {
+            char key[32];
+
+            CHECK(!json_object_emplace_null(
+                &object, key, sprintf(key, "extra %d %zu", pass, i), NULL));
+        }
+    }
+
+    json_object_destruct(&object);
+}
+
+// Objects of up to eight entries scan them without an index, and keys of the
+// same length differing only in their last character are told apart on both
+// sides of the boundary. Iteration keeps insertion order across it.
+static void test_small(void)
+{
+    for (json_size size = 0; size <= JSON_OBJECT_SMALL_CAPACITY + 2; size++) {
+        struct json_object object;
+        struct json_object_iter iter;
+        struct json_object_iter end;
+        char key[32];
+        json_size i = 0;
+
+        json_object_construct(&object, NULL);
+
+        for (json_size j = 0; j < size; j++) {
+            CHECK(!json_object_emplace_int(
+                &object, key, make_key(key, j), j, NULL));
+        }
+
+        CHECK(!object._index == (size <= JSON_OBJECT_SMALL_CAPACITY));
+        check_keys(&object, size);
+
+        for (json_size j = 0; j < size; j++) {
+            json_size n = make_key(key, j);
+
+            key[n - 1] = 'x';
+            CHECK(!json_object_contains(&object, key, n));
+            CHECK(!json_object_contains(&object, key, n - 1));
+        }
+
+        CHECK(json_object_emplace_null(&object, "key 0", 5, NULL) ==
+              (size ? JSON_ERRC_DUPLICATE_KEY : JSON_ERRC_OK));
+
+        json_object_end(&object, &end);
+        for (json_object_begin(&object, &iter);
+             !json_object_iter_is_equal(&iter, &end);
+             json_object_iter_next(&iter), i++) {
+            json_size n = make_key(key, i);
+            struct json_string *k = json_object_iter_key(&iter);
+
+            CHECK(json_string_size(k) == n);
+            CHECK(!memcmp(json_string_data(k), key, n));
+        }
+
+        CHECK(i == (size ? size : 1));
+        json_object_destruct(&object);
+    }
+}
+
+static json_uint key_hash(struct json_key *key)
+{
+    return atomic_load(&key->_hash);
+}
+
+// A key is hashed once, by its construction or by its first lookup in an
+// object large enough to have an index, and keeps that hash from then on.
+// Keys are compared by characters, so one key finds its entry in any object.
+static void test_key(void)
+{
+    static struct json_key literal = JSON_KEY("key 5");
+    struct json_key constructed;
+    struct json_key missing;
+    struct json_object small;
+    struct json_object large;
+    struct json_object_iter iter;
+    struct json_object_iter end;
+    char key[32];
+
+    json_object_construct(&small, NULL);
+    json_object_construct(&large, NULL);
+
+    for (json_size i = 0; i < COUNT; i++) {
+        json_size n = make_key(key, i);
+
+        if (i < JSON_OBJECT_SMALL_CAPACITY) {
+            CHECK(!json_object_emplace_int(&small, key, n, i, NULL));
+        }
+        CHECK(!json_object_emplace_int(&large, key, n, i, NULL));
+    }
+
+    CHECK(!key_hash(&literal));
+    CHECK(*json_value_as_int(json_object_at_key(&small, &literal)) == 5);
+    CHECK(!key_hash(&literal));
+
+    CHECK(*json_value_as_int(json_object_at_key(&large, &literal)) == 5);
+    CHECK(key_hash(&literal) == json_hash("key 5", 5));
+    CHECK(*json_value_as_int(json_object_at_key(&large, &literal)) == 5);
+    CHECK(json_object_at_key(&small, &literal) ==
+          json_object_at(&small, "key 5", 5));
+
+    json_key_construct(&constructed, key, make_key(key, COUNT - 1));
+    CHECK(key_hash(&constructed) == json_hash(key, strlen(key)));
+    json_object_find_key(&large, &constructed, &iter);
+    CHECK(*json_value_as_int(json_object_iter_value(&iter)) == COUNT - 1);
+
+    json_key_construct(&missing, "key", 3);
+    CHECK(!json_object_at_key(&small, &missing));
+    CHECK(!json_object_at_key(&large, &missing));
+    json_object_find_key(&large, &missing, &iter);
+    json_object_end(&large, &end);
+    CHECK(json_object_iter_is_equal(&iter, &end));
+
+    json_object_destruct(&large);
+    json_object_destruct(&small);
+}
+
+// Finding many keys at once, over several batches, agrees with finding them
+// one by one, in small objects, large ones and ones in the middle of an
+// incremental rehash.
+static void test_find_many(void)
+{
+    enum { KEYS = 50 };
+    // An object of 58 entries has just grown past 56, and is still moving
+    // them into its new index.
+    static const json_size sizes[] = { 0, 5, JSON_OBJECT_SMALL_CAPACITY, 58,
+                                       100, COUNT };
+    static char names[KEYS][32];
+    static struct json_value unset;
+    struct json_key keys[KEYS];
+    struct json_value *values[KEYS];
+
+    // Present, missing and repeated keys, interleaved.
+    for (json_size i = 0; i < KEYS; i++) {
+        json_size n = i % 3 == 2 ? sprintf(names[i], "absent %zu", i)
+                                 : make_key(names[i], i % 7 * 13);
+
+        json_key_construct(keys + i, names[i], n);
+    }
+
+    for (json_size s = 0; s < sizeof(sizes) / sizeof(*sizes); s++) {
+        struct json_object object;
+        char key[32];
+        json_size expected = 0;
+
+        json_object_construct(&object, NULL);
+        json_object_set_incremental_rehash(&object, json_true);
+
+        for (json_size i = 0; i < sizes[s]; i++) {
+            CHECK(!json_object_emplace_int(
+                &object, key, make_key(key, i), i, NULL));
+        }
+
+        CHECK(!object._rehash == (sizes[s] != 58));
+
+        for (json_size i = 0; i < KEYS; i++) {
+            values[i] = &unset;
+            expected += json_object_at_key(&object, keys + i) != NULL;
+        }
+
+        CHECK(json_object_find_many(&object, keys, KEYS, values) == expected);
+
+        for (json_size i = 0; i < KEYS; i++) {
+            CHECK(values[i] == json_object_at_key(&object, keys + i));
+        }
+
+        CHECK(!json_object_find_many(&object, keys, 0, values));
+        json_object_destruct(&object);
+    }
+}
+
+int main(void)
+{
+    test_emplace(json_false);
+    test_emplace(json_true);
+    test_insert();
+    test_bounded_growth();
+    test_copy_hashes();
+    test_table_match();
+    test_collisions(json_false);
+    test_collisions(json_true);
+    test_small();
+    test_key();
+    test_find_many();
+    return 0;
+}
@@ -0,0 +1,215 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <libjson/errc.h>
+#include <libjson/ondemand.h>
+
+#define CHECK(cond)                                                  \
+    do {                                                             \
+        if (!(cond)) {                                               \
+            fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            exit(1);                                                 \
+        }                                                            \
+    } while (0)
+
+// Skipped values hold brackets, quotes and escapes inside strings.
+static const char doc_text[] =
+    "{\n"
+    "  \"skip\": {\"a\": [1, {\"]\": \"}\"}, \"[\\\"{\"], \"b\": \"\\\\\"},\n"
+    "  \"list\": [10, [20, [30]], \"x]\", {\"y\": [{}]}, -4.5e1],\n"
+    "  \"na\\u006de\": \"caf\\u00e9\",\n"
+    "  \"plain\": \"no escapes\",\n"
+    "  \"flag\": false,\n"
+    "  \"none\": null,\n"
+    "  \"big\": 123456789012,\n"
+    "  \"name\": \"second\"\n"
+    "}";
+
+static struct json_ondemand doc;
+static struct json_ondemand_value root;
+
+static void find(const char *key, struct json_ondemand_value *out)
+{
+    CHECK(!json_ondemand_find_field(&root, key, strlen(key), out));
+}
+
+static void check_string(
+    const struct json_ondemand_value *value, const char *expected)
+{
+    const char *data;
+    json_size n;
+
+    CHECK(!json_ondemand_get_string(value, &data, &n));
+    CHECK(n == strlen(expected) && !memcmp(data, expected, n));
+}
+
+static void test_fields(void)
+{
+    struct json_ondemand_value value;
+    enum json_type type;
+    json_bool b;
+    json_int i;
+    json_float f;
+    const char *data;
+    json_size n;
+
+    find("flag", &value);
+    CHECK(!json_ondemand_get_type(&value, &type) && type == JSON_TYPE_BOOL);
+    CHECK(!json_ondemand_get_bool(&value, &b) && !b);
+
+    find("none", &value);
+    CHECK(json_ondemand_is_null(&value));
+
+    find("big", &value);
+    CHECK(!json_ondemand_get_type(&value, &type) && type == JSON_TYPE_INT);
+    CHECK(!json_ondemand_get_int(&value, &i) && i == 123456789012);
+    CHECK(!json_ondemand_get_float(&value, &f) && f == 123456789012.0);
+    CHECK(json_ondemand_get_bool(&value, &b) == JSON_ERRC_UNEXPECTED_TOKEN);
+
+    // The first entry with a key wins, matched after unescaping.
+    find("name", &value);
+    check_string(&value, "caf\xc3\xa9");
+
+    // Strings without escapes point into the input.
+    find("plain", &value);
+    CHECK(!json_ondemand_get_string(&value, &data, &n));
+    CHECK(data > doc_text && data < doc_text + sizeof(doc_text));
+    CHECK(n == 10 && !memcmp(data, "no escapes", 10));
+
+    CHECK(json_ondemand_find_field(&root, "missing", 7, &value) ==
+          JSON_ERRC_NOT_FOUND);
+    CHECK(json_ondemand_find_field(&value, "x", 1, &value) ==
+          JSON_ERRC_UNEXPECTED_TOKEN);
+}
+
+// Elements that are not read are skipped whole, whatever they hold.
+static void test_array(void)
+{
+    struct json_ondemand_value list;
+    struct json_ondemand_value element;
+    struct json_ondemand_iter iter;
+    json_bool done;
+    json_int i;
+    json_float f;
+    enum json_type types[8];
+    json_size count = 0;
+
+    find("list", &list);
+    CHECK(!json_ondemand_array_begin(&list, &iter));
+
+    for (;;) {
+        CHECK(!json_ondemand_array_next(&iter, &element, &done));
+        if (done) {
+            break;
+        }
+        CHECK(!json_ondemand_get_type(&element, types + count++));
+    }
+
+    CHECK(count == 5);
+    CHECK(types[0] == JSON_TYPE_INT && types[1] == JSON_TYPE_ARRAY &&
+          types[2] == JSON_TYPE_STRING && types[3] == JSON_TYPE_OBJECT &&
+          types[4] == JSON_TYPE_FLOAT);
+
+    // The element is read after its predecessors were skipped.
+    CHECK(!json_ondemand_get_float(&element, &f));
+    CHECK(json_ondemand_get_int(&element, &i) == JSON_ERRC_UNEXPECTED_TOKEN);
+
+    CHECK(!json_ondemand_array_begin(&list, &iter));
+    CHECK(!json_ondemand_array_next(&iter, &element, &done) && !done);
+    CHECK(!json_ondemand_get_int(&element, &i) && i == 10);
+    CHECK(json_ondemand_object_begin(&list, &iter) ==
+          JSON_ERRC_UNEXPECTED_TOKEN);
+}
+
+static void test_object(void)
+{
+    static const char *keys[] = {
+        "skip", "list", "name", "plain", "flag", "none", "big", "name",
+    };
+    struct json_ondemand_iter iter;
+    struct json_ondemand_value value;
+    const char *key;
+    json_size n;
+    json_bool done;
+    json_size count = 0;
+
+    CHECK(!json_ondemand_object_begin(&root, &iter));
+
+    for (;;) {
+        CHECK(!json_ondemand_object_next(&iter, &key, &n, &value, &done));
+        if (done) {
+            break;
+        }
+        CHECK(count < 8);
+        CHECK(n == strlen(keys[count]) && !memcmp(key, keys[count], n));
+        count++;
+    }
+
+    CHECK(count == 8);
+}
+
+// Malformed values go unnoticed until they are read.
+static void test_unvalidated(void)
+{
+    static const char text[] = "[{\"a\": tru}, 01, 7]";
+    struct json_ondemand lazy;
+    struct json_ondemand_value top;
+    struct json_ondemand_value element;
+    struct json_ondemand_iter iter;
+    json_bool done;
+    json_int i;
+
+    json_ondemand_construct(&lazy, text, text + sizeof(text) - 1, NULL, NULL);
+    CHECK(!json_ondemand_root(&lazy, &top));
+    CHECK(!json_ondemand_array_begin(&top, &iter));
+
+    CHECK(!json_ondemand_array_next(&iter, &element, &done) && !done);
+    CHECK(!json_ondemand_array_next(&iter, &element, &done) && !done);
+    CHECK(!json_ondemand_array_next(&iter, &element, &done) && !done);
+    CHECK(!json_ondemand_get_int(&element, &i) && i == 7);
+    CHECK(!json_ondemand_array_next(&iter, &element, &done) && done);
+
+    json_ondemand_destruct(&lazy);
+}
+
+// An empty document has no root, and a bad one fails once it is read.
+static void test_errors(void)
+{
+    static const char *texts[] = { "", "   ", " ]" };
+
+    for (json_size i = 0; i < sizeof(texts) / sizeof(*texts); i++) {
+        struct json_ondemand bad;
+        struct json_ondemand_value top;
+        enum json_type type;
+
+        json_ondemand_construct(
+            &bad, texts[i], texts[i] + strlen(texts[i]), NULL, NULL);
+
+        if (strchr(texts[i], ']')) {
+            CHECK(!json_ondemand_root(&bad, &top));
+            CHECK(json_ondemand_get_type(&top, &type) ==
+                  JSON_ERRC_UNEXPECTED_TOKEN);
+        } else {
+            CHECK(json_ondemand_root(&bad, &top) ==
+                  JSON_ERRC_UNEXPECTED_TOKEN);
+        }
+
+        json_ondemand_destruct(&bad);
+    }
+}
+
+int main(void)
+{
+    json_ondemand_construct(
+        &doc, doc_text, doc_text + sizeof(doc_text) - 1, NULL, NULL);
+    CHECK(!json_ondemand_root(&doc, &root));
+
+    test_fields();
+    test_array();
+    test_object();
+    test_unvalidated();
+    test_errors();
+
+    json_ondemand_destruct(&doc);
+    return 0;
+}
@@ -0,0 +1,122 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <libjson/array.h>
+#include <libjson/errc.h>
+#include <libjson/io.h>
+#include <libjson/value.h>
+
+#define CHECK(cond)                                                  \
+    do {                                                             \
+        if (!(cond)) {                                               \
+            fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            exit(1);                                                 \
+        }                                                            \
+    } while (0)
+
+// Large enough to be split into several parts of at least a megabyte.
+#define INPUT_SIZE (5 << 20)
+
+static char input[INPUT_SIZE + 256];
+static char expected[INPUT_SIZE + 256];
+static char actual[INPUT_SIZE + 256];
+
+// Elements hold the characters that could mislead a split point: brackets,
+// commas and quotes inside strings, and nested containers.
+static json_size make_input(void)
+{
+    json_size n = 0;
+
+    input[n++] = '[';
+    for (int i = 0; n < INPUT_SIZE; i++) {
+        n += sprintf(
+            input + n,
+            "%s\n {\"id\": %d, \"s\": \"],[{\\\"%d,\", \"f\": %d.5, "
+            "\"a\": [[], {}, [null, true]], \"o\": {\"k\": \"}\"}}",
+            i ? "," : "", i, i, i);
+    }
+    input[n++] = ']';
+    return n;
+}
+
+static json_size write_value(char *buf, const struct json_value *value)
+{
+    struct json_write_result res =
+        json_write_value(buf, buf + sizeof(actual), value, NULL);
+
+    CHECK(!res.ec);
+    return res.ptr - buf;
+}
+
+static void test_same_as_sequential(json_size n)
+{
+    struct json_value value;
+    struct json_read_result res;
+    json_size size;
+
+    json_value_construct(&value, NULL);
+    res = json_read_value(input, input + n, &value, NULL);
+    CHECK(!res.ec);
+    size = write_value(expected, &value);
+    json_value_destruct(&value);
+
+    for (json_size threads = 1; threads <= 8; threads *= 2) {
+        json_value_construct(&value, NULL);
+        res = json_read_value_parallel(
+            input, input + n, &value, NULL, threads);
+        CHECK(!res.ec);
+        CHECK(res.ptr == input + n);
+        CHECK(json_array_size(json_value_as_array(&value)) > 1000);
+        CHECK(write_value(actual, &value) == size);
+        CHECK(!memcmp(actual, expected, size));
+        json_value_destruct(&value);
+    }
+}
+
+// An error anywhere, in any part, fails the whole read.
+static void test_errors(json_size n)
+{
+    static const double positions[] = { 0.1, 0.3, 0.5, 0.7, 0.99 };
+
+    for (json_size i = 0; i < sizeof(positions) / sizeof(*positions); i++) {
+        json_size pos = (json_size)(n * positions[i]);
+        char saved;
+        struct json_value value;
+
+        // Break the next element's opening brace.
+        pos += strcspn(input + pos, "{");
+        saved = input[pos];
+        input[pos] = '}';
+
+        json_value_construct(&value, NULL);
+        CHECK(json_read_value_parallel(input, input + n, &value, NULL, 4).ec ==
+              JSON_ERRC_UNEXPECTED_TOKEN);
+        json_value_destruct(&value);
+
+        input[pos] = saved;
+    }
+}
+
+// Input that is not a large array is read on the calling thread.
+static void test_fallback(void)
+{
+    static const char text[] = " {\"a\": [1, 2]} ";
+    struct json_value value;
+
+    json_value_construct(&value, NULL);
+    CHECK(!json_read_value_parallel(
+               text, text + sizeof(text) - 1, &value, NULL, 4)
+               .ec);
+    CHECK(json_value_is_object(&value));
+    json_value_destruct(&value);
+}
+
+int main(void)
+{
+    json_size n = make_input();
+
+    test_same_as_sequential(n);
+    test_errors(n);
+    test_fallback();
+    return 0;
+}
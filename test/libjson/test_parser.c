@@ -0,0 +1,163 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <libjson/errc.h>
+#include <libjson/io.h>
+#include <libjson/value.h>
+
+#define CHECK(cond)                                                  \
+    do {                                                             \
+        if (!(cond)) {                                               \
+            fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            exit(1);                                                 \
+        }                                                            \
+    } while (0)
+
+#define COUNT(a) (sizeof(a) / sizeof(*(a)))
+
+static const struct json_read_options options = {
+    .max_depth = 250,
+    .accept_comments = json_true,
+    .accept_trailing_commas = json_true,
+};
+
+// Every kind of token, with the ones that may be split mid-token at the ends.
+static const char *valid[] = {
+    "0",
+    "-12345678901234567890",
+    "1.5e-3",
+    "true",
+    "null",
+    "\"\"",
+    "\"a\\\"b\\\\c\\u00e9\\ud834\\udd1e\xe2\x82\xac\"",
+    "[]",
+    "{}",
+    " [ 1 , -2.5 , true , false , null , \"x\" , [ ] , { } ] ",
+    "{\"a\":{\"b\":[1,[2,[3]]],\"c\":\"d\"},\"e\":[{},{\"f\":null}]}",
+    "/* c */ [1, // line\n 2, /* ** */ 3,] // end",
+    "{\"k\\n\": 123456789, \"k2\": -0.0e+10, \"k3\": [\"\\/\",],}",
+};
+
+static const char *invalid[] = {
+    "",         "[",        "{\"a\":",    "[1 2]",      "{\"a\" 1}",
+    "tru",      "nul",      "[truex]",    "\"abc",      "\"\\x\"",
+    "\"\\u12\"", "[01]",    "-",          "1.",         "1e",
+    "{\"a\":1,\"a\":2}",    "\"\xc0\x80\"", "[1]]",     "/* open",
+    "[\"\x01\"]", "1e400",
+};
+
+static char expected[4096];
+static char actual[4096];
+
+static json_size write_value(char *buf, const struct json_value *value)
+{
+    struct json_write_result res =
+        json_write_value(buf, buf + 4096, value, NULL);
+
+    CHECK(!res.ec);
+    return res.ptr - buf;
+}
+
+// Feed `text` in chunks of `chunk` bytes, but split once at `split` first.
+static enum json_errc feed(
+    const char *text, json_size split, json_size chunk,
+    struct json_value *value)
+{
+    json_size n = strlen(text);
+    struct json_parser parser;
+    enum json_errc ec = JSON_ERRC_OK;
+    json_size pos = 0;
+
+    json_parser_construct(&parser, value, &options);
+
+    if (split) {
+        ec = json_parser_feed(&parser, text, split);
+        pos = split;
+    }
+
+    for (; !ec && pos < n; pos += chunk) {
+        ec = json_parser_feed(
+            &parser, text + pos, n - pos < chunk ? n - pos : chunk);
+    }
+
+    if (!ec) {
+        ec = json_parser_finish(&parser);
+    }
+
+    // Errors are sticky.
+    if (ec) {
+        CHECK(json_parser_feed(&parser, " ", 1) == ec);
+        CHECK(json_parser_finish(&parser) == ec);
+    }
+
+    json_parser_destruct(&parser);
+    return ec;
+}
+
+static void test_valid(void)
+{
+    for (json_size i = 0; i < COUNT(valid); i++) {
+        const char *text = valid[i];
+        json_size n = strlen(text);
+        struct json_value value;
+        json_size size;
+
+        json_value_construct(&value, NULL);
+        CHECK(!json_read_value(text, text + n, &value, &options).ec);
+        size = write_value(expected, &value);
+        json_value_destruct(&value);
+
+        // Split in two at every byte, and then byte by byte.
+        for (json_size split = 0; split <= n + 1; split++) {
+            json_value_construct(&value, NULL);
+
+            if (split <= n) {
+                CHECK(!feed(text, split, n + 1, &value));
+            } else {
+                CHECK(!feed(text, 0, 1, &value));
+            }
+
+            CHECK(write_value(actual, &value) == size);
+            CHECK(!memcmp(actual, expected, size));
+            json_value_destruct(&value);
+        }
+    }
+}
+
+static void test_invalid(void)
+{
+    for (json_size i = 0; i < COUNT(invalid); i++) {
+        const char *text = invalid[i];
+        json_size n = strlen(text);
+
+        for (json_size split = 0; split <= n; split++) {
+            struct json_value value;
+
+            json_value_construct(&value, NULL);
+            CHECK(feed(text, split, 1, &value));
+            json_value_destruct(&value);
+        }
+    }
+}
+
+static void test_max_depth(void)
+{
+    struct json_read_options shallow = { .max_depth = 3 };
+    struct json_parser parser;
+    struct json_value value;
+
+    json_value_construct(&value, NULL);
+    json_parser_construct(&parser, &value, &shallow);
+    CHECK(!json_parser_feed(&parser, "[[[", 3));
+    CHECK(json_parser_feed(&parser, "[", 1) == JSON_ERRC_MAX_DEPTH);
+    json_parser_destruct(&parser);
+    json_value_destruct(&value);
+}
+
+int main(void)
+{
+    test_valid();
+    test_invalid();
+    test_max_depth();
+    return 0;
+}
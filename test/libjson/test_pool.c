@@ -0,0 +1,184 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <libjson/io.h>
+#include <libjson/memory.h>
+#include <libjson/value.h>
+
+#define CHECK(cond)                                                  \
+    do {                                                             \
+        if (!(cond)) {                                               \
+            fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            exit(1);                                                 \
+        }                                                            \
+    } while (0)
+
+// Largest request served from a size class.
+#define POOL_MAX_BYTES (16 * JSON_POOL_CLASS_COUNT)
+
+// Counts the blocks a pool takes from upstream and has yet to give back.
+struct counter {
+    struct json_allocator base;
+    json_size allocations;
+    json_size outstanding;
+};
+
+static void *counter_allocate(
+    struct json_allocator *self, json_size bytes, json_size alignment)
+{
+    struct counter *c = (struct counter *)self;
+
+    ++c->allocations;
+    ++c->outstanding;
+    return json_allocator_allocate(json_stdc_allocator(), bytes, alignment);
+}
+
+static void counter_deallocate(
+    struct json_allocator *self, void *p, json_size bytes, json_size alignment)
+{
+    struct counter *c = (struct counter *)self;
+
+    --c->outstanding;
+    json_allocator_deallocate(json_stdc_allocator(), p, bytes, alignment);
+}
+
+static json_bool counter_is_equal(
+    const struct json_allocator *self, const struct json_allocator *other)
+{
+    return self == other;
+}
+
+static struct json_allocator_methods counter_methods = {
+    .allocate = counter_allocate,
+    .deallocate = counter_deallocate,
+    .is_equal = counter_is_equal,
+};
+
+static struct counter counter;
+static struct json_pool pool;
+static struct json_allocator *alloc;
+
+static void setup(void)
+{
+    counter = (struct counter){ .allocations = 0 };
+    json_allocator_construct(&counter.base, &counter_methods);
+    json_pool_construct(&pool, &counter.base);
+    alloc = json_pool_allocator(&pool);
+}
+
+static void teardown(void)
+{
+    json_pool_destruct(&pool);
+    CHECK(!counter.outstanding);
+}
+
+// Sizes rounding up to the same multiple of 16 share a free list, and other
+// sizes never get its blocks.
+static void test_classes(void)
+{
+    setup();
+
+    for (json_size bytes = 1; bytes <= POOL_MAX_BYTES; bytes++) {
+        json_size same = (bytes + 15) / 16 * 16;
+        json_size other = same == 16 ? 32 : same - 16;
+        char *p = json_allocator_allocate(alloc, bytes, 1);
+        char *q;
+
+        CHECK(p && !((uintptr_t)p % 16));
+        memset(p, 'x', bytes);
+        json_allocator_deallocate(alloc, p, bytes, 1);
+
+        q = json_allocator_allocate(alloc, other, 16);
+        CHECK(q != p);
+        CHECK(json_allocator_allocate(alloc, same, 8) == p);
+        json_allocator_deallocate(alloc, p, same, 8);
+        json_allocator_deallocate(alloc, q, other, 16);
+    }
+
+    // One slab per class, however often its blocks were recycled.
+    CHECK(counter.allocations == JSON_POOL_CLASS_COUNT);
+    teardown();
+}
+
+// Blocks of a class are carved apart from each other, and a class only takes
+// another slab once every block of its first is in use.
+static void test_slab(void)
+{
+    static char *blocks[1 << 13];
+    json_size n = 0;
+
+    setup();
+
+    for (; counter.allocations < 2; n++) {
+        CHECK(n < sizeof(blocks) / sizeof(*blocks));
+        blocks[n] = json_allocator_allocate(alloc, 24, 8);
+        memset(blocks[n], (int)n, 24);
+    }
+
+    CHECK(n - 1 == (1 << 16) / 32);
+
+    for (json_size i = 0; i < n; i++) {
+        for (json_size j = 0; j < 24; j++) {
+            CHECK(blocks[i][j] == (char)i);
+        }
+        json_allocator_deallocate(alloc, blocks[i], 24, 8);
+    }
+
+    CHECK(counter.allocations == 2 && counter.outstanding == 2);
+    teardown();
+}
+
+// Large and over-aligned requests go straight upstream and back.
+static void test_pass_through(void)
+{
+    char *p;
+
+    setup();
+
+    p = json_allocator_allocate(alloc, POOL_MAX_BYTES + 1, 1);
+    CHECK(p && counter.outstanding == 1);
+    json_allocator_deallocate(alloc, p, POOL_MAX_BYTES + 1, 1);
+    CHECK(!counter.outstanding);
+
+    p = json_allocator_allocate(alloc, 32, 32);
+    CHECK(p && !((uintptr_t)p % 32) && counter.outstanding == 1);
+    json_allocator_deallocate(alloc, p, 32, 32);
+    CHECK(!counter.outstanding);
+
+    teardown();
+}
+
+// Reading a document over and over reuses the blocks of the last one instead
+// of taking new slabs.
+static void test_document(void)
+{
+    static const char text[] = "{\"a\": [1, {\"b\": \"a string too long\"}]}";
+    struct json_value value;
+    json_size outstanding;
+
+    setup();
+    json_value_construct(&value, alloc);
+    CHECK(!json_read_value(text, text + sizeof(text) - 1, &value, NULL).ec);
+    outstanding = counter.outstanding;
+
+    for (int i = 0; i < 10000; i++) {
+        json_value_destruct(&value);
+        json_value_construct(&value, alloc);
+        CHECK(!json_read_value(text, text + sizeof(text) - 1, &value, NULL)
+                   .ec);
+    }
+
+    CHECK(counter.outstanding == outstanding);
+    json_value_destruct(&value);
+    teardown();
+}
+
+int main(void)
+{
+    test_classes();
+    test_slab();
+    test_pass_through();
+    test_document();
+    return 0;
+}
@@ -0,0 +1,152 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <libjson/errc.h>
+#include <libjson/io.h>
+#include <libjson/string.h>
+
+#define CHECK(cond)                                                  \
+    do {                                                             \
+        if (!(cond)) {                                               \
+            fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            exit(1);                                                 \
+        }                                                            \
+    } while (0)
+
+#define COUNT(a) (sizeof(a) / sizeof(*(a)))
+
+// Past two 32-byte vectors, so every piece is seen at each position in a
+// vector, across vector boundaries, and in the scalar tail.
+#define MAX_OFFSET 80
+
+static char buf[MAX_OFFSET + 128];
+static char expected[MAX_OFFSET + 128];
+
+#define UNESCAPE(text, chars) { text, chars, sizeof(chars) - 1 }
+
+static const struct {
+    const char *text;
+    const char *chars;
+    json_size size;
+} unescapes[] = {
+    UNESCAPE("", ""),
+    UNESCAPE("\\\"", "\""),
+    UNESCAPE("\\\\", "\\"),
+    UNESCAPE("\\/", "/"),
+    UNESCAPE("\\b\\f\\n\\r\\t", "\b\f\n\r\t"),
+    UNESCAPE("\\u0041", "A"),
+    UNESCAPE("\\u00e9\\u00E9", "\xc3\xa9\xc3\xa9"),
+    UNESCAPE("\\u20ac", "\xe2\x82\xac"),
+    UNESCAPE("\\ud834\\udd1e", "\xf0\x9d\x84\x9e"),
+    UNESCAPE("\\uD834\\uDD1E", "\xf0\x9d\x84\x9e"),
+    UNESCAPE("\\u0000", "\0"),
+    UNESCAPE("\xc3\xa9\x7f", "\xc3\xa9\x7f"),
+    UNESCAPE("\\\\\\\"\\\\", "\\\"\\"),
+};
+
+static const struct {
+    const char *text;
+    enum json_errc ec;
+} errors[] = {
+    { "\x01", JSON_ERRC_UNEXPECTED_TOKEN },
+    { "\x1f", JSON_ERRC_UNEXPECTED_TOKEN },
+    { "\n", JSON_ERRC_UNEXPECTED_TOKEN },
+    { "\\x", JSON_ERRC_INVALID_ESCAPE },
+    { "\\'", JSON_ERRC_INVALID_ESCAPE },
+    { "\\u12", JSON_ERRC_INVALID_ESCAPE },
+    { "\\u12g4", JSON_ERRC_INVALID_ESCAPE },
+    { "\\ud834", JSON_ERRC_INVALID_ESCAPE },
+    { "\\udd1e", JSON_ERRC_INVALID_ESCAPE },
+    { "\\ud834\\u0041", JSON_ERRC_INVALID_ESCAPE },
+    { "\\uffff", JSON_ERRC_INVALID_ESCAPE },
+    { "\xc3", JSON_ERRC_INVALID_ENCODING },
+};
+
+// Write a string literal of `offset` clean characters, then `text`, then
+// more clean characters, and return its size.
+static json_size make_literal(const char *text, json_size offset)
+{
+    json_size n = 0;
+
+    buf[n++] = '"';
+    for (json_size i = 0; i < offset; i++) {
+        buf[n++] = 'a' + i % 26;
+    }
+    n += sprintf(buf + n, "%s", text);
+    memcpy(buf + n, "xyz", 3);
+    n += 3;
+    buf[n++] = '"';
+
+    // Input is not null terminated, so nothing past the literal is read.
+    buf[n] = '"';
+    return n;
+}
+
+static void test_unescape(void)
+{
+    for (json_size i = 0; i < COUNT(unescapes); i++) {
+        for (json_size offset = 0; offset <= MAX_OFFSET; offset++) {
+            json_size n = make_literal(unescapes[i].text, offset);
+            json_size size = 0;
+            struct json_string string;
+            struct json_read_result res;
+
+            memcpy(expected, buf + 1, offset);
+            size += offset;
+            memcpy(expected + size, unescapes[i].chars, unescapes[i].size);
+            size += unescapes[i].size;
+            memcpy(expected + size, "xyz", 3);
+            size += 3;
+
+            json_string_construct(&string, NULL);
+            res = json_read_string(buf, buf + n, &string, NULL);
+            CHECK(!res.ec);
+            CHECK(res.ptr == buf + n);
+            CHECK(json_string_size(&string) == size);
+            CHECK(!memcmp(json_string_data(&string), expected, size));
+            CHECK(json_string_data(&string)[size] == 0);
+            json_string_destruct(&string);
+        }
+    }
+}
+
+static void test_errors(void)
+{
+    for (json_size i = 0; i < COUNT(errors); i++) {
+        for (json_size offset = 0; offset <= MAX_OFFSET; offset++) {
+            json_size n = make_literal(errors[i].text, offset);
+            struct json_string string;
+
+            json_string_construct(&string, NULL);
+            CHECK(json_read_string(buf, buf + n, &string, NULL).ec ==
+                  errors[i].ec);
+            json_string_destruct(&string);
+        }
+    }
+}
+
+// A literal without its closing quote ends with the input, wherever that is.
+static void test_unterminated(void)
+{
+    for (json_size offset = 0; offset <= MAX_OFFSET; offset++) {
+        json_size n = make_literal("\\\"", offset);
+        struct json_string string;
+
+        json_string_construct(&string, NULL);
+
+        for (json_size m = 0; m < n; m++) {
+            CHECK(json_read_string(buf, buf + m, &string, NULL).ec ==
+                  JSON_ERRC_UNEXPECTED_TOKEN);
+        }
+
+        json_string_destruct(&string);
+    }
+}
+
+int main(void)
+{
+    test_unescape();
+    test_errors();
+    test_unterminated();
+    return 0;
+}
@@ -0,0 +1,207 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <libjson/errc.h>
+#include <libjson/string.h>
+
+#define CHECK(cond)                                                  \
+    do {                                                             \
+        if (!(cond)) {                                               \
+            fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            exit(1);                                                 \
+        }                                                            \
+    } while (0)
+
+static const char chars[] = "abcdefghijklmnopqrstuvwxyz0123456789";
+
+// Whether the characters of `string` are stored inside it.
+static int is_inline(struct json_string *string)
+{
+    char *data = json_string_data(string);
+
+    return data >= (char *)string &&
+           data < (char *)string + sizeof(*string);
+}
+
+static void check_chars(struct json_string *string, json_size n)
+{
+    CHECK(json_string_size(string) == n);
+    CHECK(!memcmp(json_string_data(string), chars, n));
+    CHECK(json_string_data(string)[n] == 0);
+}
+
+static void test_layout(void)
+{
+    CHECK(sizeof(struct json_string) == 4 * sizeof(void *));
+
+    if (sizeof(void *) == 8) {
+        CHECK(sizeof(struct json_string) == 32);
+        CHECK(JSON_STRING_INLINE_CAPACITY == 22);
+    }
+}
+
+// Strings are inline up to and including the inline capacity, and move to the
+// heap one character past it.
+static void test_inline_boundary(void)
+{
+    static const json_size sizes[] = {
+        0, 1, JSON_STRING_INLINE_CAPACITY - 1, JSON_STRING_INLINE_CAPACITY,
+        JSON_STRING_INLINE_CAPACITY + 1,
+    };
+
+    for (json_size i = 0; i < sizeof(sizes) / sizeof(*sizes); i++) {
+        json_size n = sizes[i];
+        struct json_string string;
+        struct json_string moved;
+
+        json_string_construct(&string, NULL);
+        CHECK(json_string_empty(&string));
+        CHECK(json_string_capacity(&string) == JSON_STRING_INLINE_CAPACITY);
+        check_chars(&string, 0);
+
+        CHECK(!json_string_append(&string, chars, n));
+        check_chars(&string, n);
+        CHECK(is_inline(&string) == (n <= JSON_STRING_INLINE_CAPACITY));
+        CHECK(json_string_capacity(&string) >= n);
+
+        // Moving carries inline characters along with the string.
+        CHECK(!json_string_construct_move(&moved, &string, NULL));
+        check_chars(&moved, n);
+        CHECK(is_inline(&moved) == (n <= JSON_STRING_INLINE_CAPACITY));
+        check_chars(&string, 0);
+
+        json_string_clear(&moved);
+        check_chars(&moved, 0);
+
+        json_string_destruct(&moved);
+        json_string_destruct(&string);
+    }
+}
+
+// Appending one character at a time crosses the boundary in place.
+static void test_append_across(void)
+{
+    struct json_string string;
+
+    json_string_construct(&string, NULL);
+
+    for (json_size n = 1; n <= JSON_STRING_INLINE_CAPACITY + 2; n++) {
+        CHECK(!json_string_append(&string, chars + n - 1, 1));
+        check_chars(&string, n);
+        CHECK(is_inline(&string) == (n <= JSON_STRING_INLINE_CAPACITY));
+    }
+
+    // Shrinking back to the inline capacity brings the characters back in.
+    CHECK(!json_string_resize(&string, JSON_STRING_INLINE_CAPACITY, 0));
+    CHECK(!json_string_shrink_to_fit(&string));
+    check_chars(&string, JSON_STRING_INLINE_CAPACITY);
+    CHECK(is_inline(&string));
+    CHECK(json_string_capacity(&string) == JSON_STRING_INLINE_CAPACITY);
+
+    json_string_destruct(&string);
+}
+
+// A borrowed string is not inline and has no capacity until it is changed,
+// when it is copied into storage of its own.
+static void test_borrow(void)
+{
+    static const json_size sizes[] = {
+        0, JSON_STRING_INLINE_CAPACITY, JSON_STRING_INLINE_CAPACITY + 1,
+    };
+
+    for (json_size i = 0; i < sizeof(sizes) / sizeof(*sizes); i++) {
+        json_size n = sizes[i];
+        char buf[sizeof(chars)];
+        struct json_string string;
+
+        memcpy(buf, chars, n);
+        buf[n] = 0;
+
+        json_string_construct_borrow(&string, buf, n, NULL);
+        CHECK(json_string_data(&string) == buf);
+        CHECK(json_string_capacity(&string) == 0);
+        check_chars(&string, n);
+
+        CHECK(!json_string_append(&string, chars + n, 1));
+        CHECK(json_string_data(&string) != buf);
+        CHECK(is_inline(&string) == (n < JSON_STRING_INLINE_CAPACITY));
+        check_chars(&string, n + 1);
+        CHECK(buf[n] == 0);
+
+        json_string_destruct(&string);
+    }
+}
+
+static void test_reserve(void)
+{
+    struct json_string string;
+    const char *data;
+
+    json_string_construct(&string, NULL);
+
+    CHECK(!json_string_reserve(&string, JSON_STRING_INLINE_CAPACITY));
+    CHECK(is_inline(&string));
+
+    CHECK(!json_string_reserve(&string, 100));
+    CHECK(!is_inline(&string));
+    CHECK(json_string_capacity(&string) == 100);
+    check_chars(&string, 0);
+
+    // Appending within the reserved capacity does not move the characters.
+    data = json_string_data(&string);
+    CHECK(!json_string_append(&string, chars, sizeof(chars) - 1));
+    CHECK(json_string_data(&string) == data);
+    check_chars(&string, sizeof(chars) - 1);
+
+    CHECK(!json_string_shrink_to_fit(&string));
+    CHECK(json_string_capacity(&string) == sizeof(chars) - 1);
+    check_chars(&string, sizeof(chars) - 1);
+
+    json_string_destruct(&string);
+}
+
+// Appending a character at a time grows the capacity by at least half each
+// time, so it only changes a logarithmic number of times. Appending more than
+// that at once grows it just enough.
+static void test_growth(void)
+{
+    struct json_string string;
+    json_size capacity = JSON_STRING_INLINE_CAPACITY;
+    json_size changes = 0;
+
+    json_string_construct(&string, NULL);
+
+    for (json_size i = 0; i < (1 << 20); i++) {
+        CHECK(!json_string_push_back(&string, chars[i % 36]));
+
+        if (json_string_capacity(&string) != capacity) {
+            CHECK(json_string_capacity(&string) >= capacity + capacity / 2);
+            capacity = json_string_capacity(&string);
+            ++changes;
+        }
+    }
+
+    // log(2^20 / 22) / log(1.5) is under 27.
+    CHECK(changes <= 27);
+    CHECK(json_string_size(&string) == 1 << 20);
+
+    for (json_size i = 0; i < (1 << 20); i++) {
+        CHECK(json_string_data(&string)[i] == chars[i % 36]);
+    }
+
+    CHECK(!json_string_append_reserve(&string, 2 * capacity));
+    CHECK(json_string_capacity(&string) == (1 << 20) + 2 * capacity);
+
+    json_string_destruct(&string);
+}
+
+int main(void)
+{
+    test_layout();
+    test_inline_boundary();
+    test_append_across();
+    test_borrow();
+    test_reserve();
+    test_growth();
+    return 0;
+}
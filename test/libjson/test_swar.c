@@ -0,0 +1,106 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <libjson/errc.h>
+#include <libjson/io.h>
+#include "../../src/libjson/number.h"
+
+#define CHECK(cond)                                                  \
+    do {                                                             \
+        if (!(cond)) {                                               \
+            fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            exit(1);                                                 \
+        }                                                            \
+    } while (0)
+
+// A word is eight digits only if each byte is one, whatever the other bytes.
+static void test_is_eight_digits(void)
+{
+    char digits[8] = "01234567";
+
+    CHECK(json_swar_is_eight_digits(json_load_unaligned_le64(digits)));
+
+    for (int i = 0; i < 8; i++) {
+        for (int c = 0; c < 256; c++) {
+            char bytes[8];
+
+            memcpy(bytes, digits, 8);
+            bytes[i] = (char)c;
+            CHECK(json_swar_is_eight_digits(json_load_unaligned_le64(bytes)) ==
+                  (c >= '0' && c <= '9'));
+        }
+    }
+}
+
+static void test_parse_eight_digits(void)
+{
+    json_uint64 value = 0;
+
+    for (int i = 0; i < 100000; i++) {
+        char bytes[9];
+
+        sprintf(bytes, "%08llu", (unsigned long long)value);
+        CHECK(json_swar_parse_eight_digits(json_load_unaligned_le64(bytes)) ==
+              value);
+
+        // A pseudo-random walk over eight digit values.
+        value = (value * 7919 + 104729 + i) % 100000000;
+    }
+
+    CHECK(json_swar_parse_eight_digits(
+              json_load_unaligned_le64("99999999")) == 99999999);
+    CHECK(json_swar_parse_eight_digits(
+              json_load_unaligned_le64("00000000")) == 0);
+}
+
+// Integers of every length read the same whether the input ends right after
+// them or goes on with a delimiter, so that runs of eight are taken both
+// whole and a digit at a time.
+static void test_read_int(void)
+{
+    static const char digits[] = "12345678901234567890";
+
+    for (json_size n = 1; n < sizeof(digits); n++) {
+        char buf[32];
+        json_uint64 expected = 0;
+
+        for (json_size i = 0; i < n && i < 19; i++) {
+            expected = 10 * expected + (digits[i] - '0');
+        }
+
+        for (int negative = 0; negative < 2; negative++) {
+            json_size size = 0;
+            struct json_read_result res;
+            json_int value;
+
+            if (negative) {
+                buf[size++] = '-';
+            }
+
+            memcpy(buf + size, digits, n);
+            size += n;
+            buf[size] = ',';
+
+            for (json_size end = size; end <= size + 1; end++) {
+                res = json_read_int(buf, buf + end, &value, NULL);
+                CHECK(res.ptr == buf + size);
+
+                if (n > 19) {
+                    CHECK(res.ec == JSON_ERRC_NUMBER_OUT_OF_RANGE);
+                } else {
+                    CHECK(!res.ec);
+                    CHECK(value == (negative ? -(json_int)expected
+                                             : (json_int)expected));
+                }
+            }
+        }
+    }
+}
+
+int main(void)
+{
+    test_is_eight_digits();
+    test_parse_eight_digits();
+    test_read_int();
+    return 0;
+}
@@ -0,0 +1,312 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <libjson/errc.h>
+#include <libjson/io.h>
+#include <libjson/tape.h>
+
+#define CHECK(cond)                                                  \
+    do {                                                             \
+        if (!(cond)) {                                               \
+            fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            exit(1);                                                 \
+        }                                                            \
+    } while (0)
+
+// Large enough for json_read_tape to walk the structural index.
+#define PADDED_SIZE 8192
+
+static char buf[1 << 20];
+
+// Comments turn the structural index off, so they select the one-pass read.
+static struct json_read_options one_pass_options = {
+    .max_depth = 250,
+    .accept_comments = json_true,
+};
+
+static struct json_read_options indexed_options = {
+    .max_depth = 250,
+};
+
+static json_size pad(const char *text)
+{
+    json_size n = strlen(text);
+
+    memcpy(buf, text, n);
+    memset(buf + n, ' ', PADDED_SIZE - n);
+    return PADDED_SIZE;
+}
+
+static void check_same(
+    const struct json_tape_cursor *a, const struct json_tape_cursor *b)
+{
+    struct json_tape_iter ia, ib;
+    struct json_tape_cursor ea, eb;
+    const char *ka, *kb;
+    json_size na, nb;
+
+    CHECK(json_tape_get_type(a) == json_tape_get_type(b));
+
+    switch (json_tape_get_type(a)) {
+    case JSON_TYPE_NULL:
+        break;
+    case JSON_TYPE_BOOL:
+        CHECK(json_tape_get_bool(a) == json_tape_get_bool(b));
+        break;
+    case JSON_TYPE_INT:
+        CHECK(json_tape_get_int(a) == json_tape_get_int(b));
+        break;
+    case JSON_TYPE_FLOAT:
+        CHECK(json_tape_get_float(a) == json_tape_get_float(b));
+        break;
+    case JSON_TYPE_STRING:
+        ka = json_tape_get_string(a, &na);
+        kb = json_tape_get_string(b, &nb);
+        CHECK(na == nb && !memcmp(ka, kb, na));
+        break;
+    case JSON_TYPE_ARRAY:
+        CHECK(json_tape_size(a) == json_tape_size(b));
+        json_tape_array_begin(a, &ia);
+        json_tape_array_begin(b, &ib);
+
+        while (json_tape_array_next(&ia, &ea)) {
+            CHECK(json_tape_array_next(&ib, &eb));
+            check_same(&ea, &eb);
+        }
+        break;
+    case JSON_TYPE_OBJECT:
+        CHECK(json_tape_size(a) == json_tape_size(b));
+        json_tape_object_begin(a, &ia);
+        json_tape_object_begin(b, &ib);
+
+        while (json_tape_object_next(&ia, &ka, &na, &ea)) {
+            CHECK(json_tape_object_next(&ib, &kb, &nb, &eb));
+            CHECK(na == nb && !memcmp(ka, kb, na));
+            check_same(&ea, &eb);
+        }
+        break;
+    }
+}
+
+// Read `[buf, buf + n)` both ways and check that the results are the same.
+static enum json_errc read_both(json_size n)
+{
+    struct json_tape indexed;
+    struct json_tape one_pass;
+    struct json_tape_cursor a_root;
+    struct json_tape_cursor b_root;
+    struct json_read_result a;
+    struct json_read_result b;
+
+    json_tape_construct(&indexed, NULL);
+    json_tape_construct(&one_pass, NULL);
+
+    a = json_read_tape(buf, buf + n, &indexed, &indexed_options);
+    b = json_read_tape(buf, buf + n, &one_pass, &one_pass_options);
+
+    CHECK(a.ec == b.ec);
+    CHECK(json_tape_empty(&indexed) == json_tape_empty(&one_pass));
+
+    if (!a.ec) {
+        CHECK(a.ptr == b.ptr);
+        json_tape_root(&indexed, &a_root);
+        json_tape_root(&one_pass, &b_root);
+        check_same(&a_root, &b_root);
+    }
+
+    json_tape_destruct(&one_pass);
+    json_tape_destruct(&indexed);
+    return a.ec;
+}
+
+static void test_valid(void)
+{
+    json_size n = 0;
+
+    n += sprintf(buf + n, " \n[");
+    for (int i = 0; i < 2000; i++) {
+        n += sprintf(
+            buf + n,
+            "%s{\"id\": %d, \"name\" : \"item\\n\\\"%d\\u00e9\", "
+            "\"x\":-%d.25e-3,\"tags\":[true,false,null,[],{}],"
+            "\"nested\":{\"a\":[[%d]],\"b\":\"\"}}",
+            i ? ",\n  " : "", i, i, i, i);
+    }
+    n += sprintf(buf + n, "]\t");
+
+    CHECK(read_both(n) == JSON_ERRC_OK);
+
+    static const char *scalars[] = {
+        "0", "-0", "1.5", "true", "null", "\"a\"", "{}", "[]",
+    };
+
+    for (json_size i = 0; i < sizeof(scalars) / sizeof(*scalars); i++) {
+        CHECK(read_both(pad(scalars[i])) == JSON_ERRC_OK);
+    }
+}
+
+static void test_invalid(void)
+{
+    static const char *docs[] = {
+        "",        "[",          "]",           "[1,]",       "[1 2]",
+        "[,1]",    "{\"a\" 1}",  "{\"a\":1,}",  "{1:2}",      "{\"a\"}",
+        "[12x]",   "[1/]",       "[tru]",       "[nullx]",    "[\"abc",
+        "[\"\\\"]", "[1}",       "{\"a\":1]",   "[01]",       "[-]",
+        "[1:2]",   "{\"a\"::1}", "[\"\x01\"]",  "@",          "[[]]]",
+    };
+
+    for (json_size i = 0; i < sizeof(docs) / sizeof(*docs); i++) {
+        enum json_errc ec = read_both(pad(docs[i]));
+
+        // A value followed by more input is read up to its end.
+        CHECK(ec != JSON_ERRC_OK || !strcmp(docs[i], "[[]]]"));
+    }
+}
+
+static void test_trailing_commas(void)
+{
+    CHECK(read_both(pad("[1,[2,],{\"a\":3,},]")) ==
+          JSON_ERRC_UNEXPECTED_TOKEN);
+
+    indexed_options.accept_trailing_commas = json_true;
+    one_pass_options.accept_trailing_commas = json_true;
+
+    CHECK(read_both(pad("[1,[2,],{\"a\":3,},]")) == JSON_ERRC_OK);
+    CHECK(read_both(pad("[,]")) == JSON_ERRC_UNEXPECTED_TOKEN);
+    CHECK(read_both(pad("[1,,]")) == JSON_ERRC_UNEXPECTED_TOKEN);
+
+    indexed_options.accept_trailing_commas = json_false;
+    one_pass_options.accept_trailing_commas = json_false;
+}
+
+static void test_max_depth(void)
+{
+    json_size n = 0;
+
+    for (int i = 0; i < 250; i++) {
+        buf[n++] = '[';
+    }
+    for (int i = 0; i < 250; i++) {
+        buf[n++] = ']';
+    }
+
+    memset(buf + n, ' ', PADDED_SIZE - n);
+    CHECK(read_both(PADDED_SIZE) == JSON_ERRC_OK);
+
+    memmove(buf + 1, buf, n);
+    buf[0] = '[';
+    buf[n + 1] = ']';
+    CHECK(read_both(PADDED_SIZE) == JSON_ERRC_MAX_DEPTH);
+}
+
+// Each value is a word tagged in its top byte, numbers and strings are
+// followed by their payload, and the start and end words of a container hold
+// the index of each other.
+static void test_layout(void)
+{
+    static const char text[] = "[1,\"ab\",{\"k\":null},true,-2.5]";
+    static const char tags[] = "[l \" {\" n}td";
+    struct json_tape tape;
+    json_size n = sizeof(tags) - 1;
+
+    json_tape_construct(&tape, NULL);
+    CHECK(!json_read_tape(text, text + sizeof(text) - 1, &tape, NULL).ec);
+
+    for (json_size i = 0; i < n; i++) {
+        if (tags[i] != ' ') {
+            CHECK(tape._words[i] >> 56 == (unsigned char)tags[i]);
+        }
+    }
+
+    // The float takes as many words as a `json_float` needs.
+    n += (sizeof(json_float) + 7) / 8;
+    CHECK(tape._size == n + 1);
+    CHECK(tape._words[n] >> 56 == ']');
+
+    CHECK((tape._words[0] & 0xFFFFFFFFFFFFFF) == n);
+    CHECK((tape._words[n] & 0xFFFFFFFFFFFFFF) == 0);
+    CHECK((tape._words[5] & 0xFFFFFFFFFFFFFF) == 9);
+    CHECK((tape._words[9] & 0xFFFFFFFFFFFFFF) == 5);
+
+    // Ints and string sizes are in the word after the tag.
+    CHECK(tape._words[2] == 1);
+    CHECK((tape._words[3] & 0xFFFFFFFFFFFFFF) == 0 && tape._words[4] == 2);
+    CHECK((tape._words[6] & 0xFFFFFFFFFFFFFF) == 3 && tape._words[7] == 1);
+
+    // String characters are kept together, each null terminated.
+    CHECK(tape._strings_size == 5);
+    CHECK(!memcmp(tape._strings, "ab\0k\0", 5));
+
+    json_tape_destruct(&tape);
+}
+
+static void test_cursor(void)
+{
+    static const char text[] =
+        "{\"a\": [1, 2.5, \"x\\u0000y\"], \"b\": {\"c\": false}, "
+        "\"a\": null, \"d\": 7}";
+    struct json_tape tape;
+    struct json_tape_cursor root, value, element;
+    struct json_tape_iter iter;
+    const json_uint *words;
+    const char *strings;
+    const char *data;
+    json_size n;
+
+    json_tape_construct(&tape, NULL);
+    CHECK(json_tape_empty(&tape));
+    CHECK(!json_read_tape(text, text + sizeof(text) - 1, &tape, NULL).ec);
+    CHECK(!json_tape_empty(&tape));
+
+    json_tape_root(&tape, &root);
+    CHECK(json_tape_get_type(&root) == JSON_TYPE_OBJECT);
+    CHECK(json_tape_size(&root) == 4);
+
+    // Of two entries with a key, the first is found.
+    CHECK(json_tape_find_field(&root, "a", 1, &value));
+    CHECK(json_tape_get_type(&value) == JSON_TYPE_ARRAY);
+    CHECK(json_tape_size(&value) == 3);
+
+    json_tape_array_begin(&value, &iter);
+    CHECK(json_tape_array_next(&iter, &element));
+    CHECK(json_tape_get_int(&element) == 1);
+    CHECK(json_tape_get_float(&element) == 1.0);
+    CHECK(json_tape_array_next(&iter, &element));
+    CHECK(json_tape_get_float(&element) == 2.5);
+    CHECK(json_tape_array_next(&iter, &element));
+    data = json_tape_get_string(&element, &n);
+    CHECK(n == 3 && !memcmp(data, "x\0y", 4));
+    CHECK(!json_tape_array_next(&iter, &element));
+
+    // Fields after a skipped subtree are found.
+    CHECK(json_tape_find_field(&root, "d", 1, &value));
+    CHECK(json_tape_get_int(&value) == 7);
+    CHECK(json_tape_find_field(&root, "b", 1, &value));
+    CHECK(json_tape_find_field(&value, "c", 1, &value));
+    CHECK(!json_tape_get_bool(&value));
+    CHECK(!json_tape_find_field(&root, "e", 1, &value));
+
+    // Reading a smaller document again reuses the storage.
+    words = tape._words;
+    strings = tape._strings;
+    CHECK(!json_read_tape(buf, buf + sprintf(buf, "[\"z\"]"), &tape, NULL).ec);
+    CHECK(tape._words == words && tape._strings == strings);
+    CHECK(tape._size == 4);
+
+    json_tape_clear(&tape);
+    CHECK(json_tape_empty(&tape));
+    CHECK(json_read_tape(buf, buf + sprintf(buf, "[1"), &tape, NULL).ec);
+
+    json_tape_destruct(&tape);
+}
+
+int main(void)
+{
+    test_layout();
+    test_cursor();
+    test_valid();
+    test_invalid();
+    test_trailing_commas();
+    test_max_depth();
+    return 0;
+}
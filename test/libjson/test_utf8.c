@@ -0,0 +1,131 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <libjson/errc.h>
+#include <libjson/io.h>
+#include <libjson/string.h>
+
+#define CHECK(cond)                                                  \
+    do {                                                             \
+        if (!(cond)) {                                               \
+            fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            exit(1);                                                 \
+        }                                                            \
+    } while (0)
+
+#define COUNT(a) (sizeof(a) / sizeof(*(a)))
+
+// Longer than one 64-byte block of the vector validator, so every sequence is
+// checked both inside a block and across the boundary with the tail.
+#define MAX_OFFSET 140
+
+static const char *valid[] = {
+    "\xc3\xa9",         "\xdf\xbf",         "\xe0\xa0\x80",
+    "\xe2\x82\xac",     "\xed\x9f\xbf",     "\xee\x80\x80",
+    "\xef\xbf\xbd",     "\xf0\x90\x80\x80", "\xf0\x90\x8d\x88",
+    "\xf4\x8f\xbf\xbd", "\x7f",
+};
+
+static const char *invalid[] = {
+    // Continuation bytes without a lead byte.
+    "\x80", "\xbf", "\xc3\xa9\xa9",
+
+    // Overlong encodings.
+    "\xc0\x80", "\xc1\xbf", "\xe0\x80\x80", "\xe0\x9f\xbf",
+    "\xf0\x80\x80\x80", "\xf0\x8f\xbf\xbf",
+
+    // Surrogates.
+    "\xed\xa0\x80", "\xed\xbf\xbf",
+
+    // Past U+10FFFF, and bytes that never appear.
+    "\xf4\x90\x80\x80", "\xf5\x80\x80\x80", "\xf8\x88\x80\x80\x80", "\xfe",
+    "\xff",
+
+    // Sequences cut short by the next character.
+    "\xc3", "\xe2\x82", "\xf0\x90\x8d", "\xe2x\xac",
+};
+
+static char buf[MAX_OFFSET + 64];
+
+// Read a string of `offset` ASCII characters, then `seq`, then more ASCII.
+static enum json_errc read_at(const char *seq, json_size offset)
+{
+    json_size n = strlen(seq);
+    struct json_string string;
+    struct json_read_result res;
+    json_size size = 0;
+
+    buf[size++] = '"';
+    memset(buf + size, 'a', offset);
+    size += offset;
+    memcpy(buf + size, seq, n);
+    size += n;
+    memset(buf + size, 'b', 7);
+    size += 7;
+    buf[size++] = '"';
+
+    json_string_construct(&string, NULL);
+    res = json_read_string(buf, buf + size, &string, NULL);
+
+    if (!res.ec) {
+        CHECK(res.ptr == buf + size);
+        CHECK(json_string_size(&string) == offset + n + 7);
+        CHECK(!memcmp(json_string_data(&string), buf + 1, offset + n + 7));
+    }
+
+    json_string_destruct(&string);
+    return res.ec;
+}
+
+static void test_valid(void)
+{
+    for (json_size i = 0; i < COUNT(valid); i++) {
+        for (json_size offset = 0; offset <= MAX_OFFSET; offset++) {
+            CHECK(read_at(valid[i], offset) == JSON_ERRC_OK);
+        }
+    }
+}
+
+static void test_invalid(void)
+{
+    for (json_size i = 0; i < COUNT(invalid); i++) {
+        for (json_size offset = 0; offset <= MAX_OFFSET; offset++) {
+            CHECK(read_at(invalid[i], offset) == JSON_ERRC_INVALID_ENCODING);
+        }
+    }
+}
+
+// Invalid sequences are kept or replaced when they are accepted.
+static void test_accept(void)
+{
+    static const char text[] = "\"a\xc0\x80z\"";
+    struct json_read_options options = {
+        .max_depth = 250,
+        .accept_invalid_code_points = json_true,
+    };
+    struct json_string string;
+
+    json_string_construct(&string, NULL);
+    CHECK(!json_read_string(text, text + sizeof(text) - 1, &string, &options)
+               .ec);
+    CHECK(json_string_size(&string) == 4);
+    CHECK(!memcmp(json_string_data(&string), "a\xc0\x80z", 4));
+
+    options.replace_invalid_code_points = json_true;
+    json_string_clear(&string);
+    CHECK(!json_read_string(text, text + sizeof(text) - 1, &string, &options)
+               .ec);
+    CHECK(json_string_data(&string)[0] == 'a');
+    CHECK(!memcmp(json_string_data(&string) + 1, "\xef\xbf\xbd", 3));
+    CHECK(json_string_data(&string)[json_string_size(&string) - 1] == 'z');
+
+    json_string_destruct(&string);
+}
+
+int main(void)
+{
+    test_valid();
+    test_invalid();
+    test_accept();
+    return 0;
+}
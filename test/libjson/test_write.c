@@ -0,0 +1,228 @@
+#include <float.h>
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <libjson/errc.h>
+#include <libjson/io.h>
+#include <libjson/object.h>
+#include <libjson/string.h>
+#include <libjson/value.h>
+
+#define CHECK(cond)                                                  \
+    do {                                                             \
+        if (!(cond)) {                                               \
+            fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            exit(1);                                                 \
+        }                                                            \
+    } while (0)
+
+// More keys than there are 7-bit control bytes, so some of them collide in
+// the index.
+#define COUNT 300
+
+static char buf[1 << 16];
+
+static json_size make_key(char *key, json_size i)
+{
+    return sprintf(key, "k%zu", i);
+}
+
+static json_size write_object(const struct json_object *object)
+{
+    struct json_write_result res =
+        json_write_object(buf, buf + sizeof(buf), object, NULL);
+
+    CHECK(!res.ec);
+    return res.ptr - buf;
+}
+
+// Keys are written in insertion order whatever their hashes, so the same
+// keys inserted in two orders are written in those two orders.
+static void test_object_order(void)
+{
+    static char expected[sizeof(buf)];
+    struct json_object forward;
+    struct json_object backward;
+    char key[32];
+
+    json_object_construct(&forward, NULL);
+    json_object_construct(&backward, NULL);
+
+    for (json_size i = 0; i < COUNT; i++) {
+        json_size j = COUNT - 1 - i;
+
+        CHECK(!json_object_emplace_int(
+            &forward, key, make_key(key, i), i, NULL));
+        CHECK(!json_object_emplace_int(
+            &backward, key, make_key(key, j), j, NULL));
+    }
+
+    CHECK(json_object_emplace_null(&forward, "k7", 2, NULL) ==
+          JSON_ERRC_DUPLICATE_KEY);
+
+    for (int pass = 0; pass < 2; pass++) {
+        const struct json_object *object = pass ? &backward : &forward;
+        json_size n = 0;
+
+        expected[n++] = '{';
+        for (json_size i = 0; i < COUNT; i++) {
+            json_size j = pass ? COUNT - 1 - i : i;
+
+            n += sprintf(expected + n, "%s\"k%zu\":%zu", i ? "," : "", j, j);
+        }
+        expected[n++] = '}';
+
+        CHECK(write_object(object) == n);
+        CHECK(!memcmp(buf, expected, n));
+    }
+
+    json_object_destruct(&backward);
+    json_object_destruct(&forward);
+}
+
+static void test_indent(void)
+{
+    static const char expected[] =
+        "{\n"
+        "  \"b\": null,\n"
+        "  \"a\": [\n"
+        "    true,\n"
+        "    -9223372036854775808\n"
+        "  ],\n"
+        "  \"c\": {\n"
+        "  }\n"
+        "}";
+    static const char array_text[] = "[true,-9223372036854775808]";
+    struct json_write_options options = { .indent_size = 2 };
+    struct json_object object;
+    struct json_object empty;
+    struct json_value array;
+    struct json_write_result res;
+
+    json_object_construct(&object, NULL);
+    json_object_construct(&empty, NULL);
+    json_value_construct(&array, NULL);
+    CHECK(!json_read_value(
+               array_text, array_text + sizeof(array_text) - 1, &array, NULL)
+               .ec);
+
+    CHECK(!json_object_emplace_null(&object, "b", 1, NULL));
+    CHECK(!json_object_emplace_move(&object, "a", 1, &array, NULL));
+    CHECK(!json_object_emplace_object_move(&object, "c", 1, &empty, NULL));
+
+    res = json_write_object(buf, buf + sizeof(buf), &object, &options);
+    CHECK(!res.ec);
+    CHECK(res.ptr - buf == sizeof(expected) - 1);
+    CHECK(!memcmp(buf, expected, sizeof(expected) - 1));
+
+    // Every prefix of the buffer is too short.
+    for (json_size n = 0; n < sizeof(expected) - 1; n++) {
+        res = json_write_object(buf, buf + n, &object, &options);
+        CHECK(res.ec == JSON_ERRC_NOT_ENOUGH_MEMORY);
+    }
+
+    json_object_destruct(&object);
+}
+
+static void test_string(void)
+{
+    static const char chars[] = "a\"b\\c/\b\f\n\r\t\x01\x1f\x7f\xc3\xa9";
+    static const char expected[] =
+        "\"a\\\"b\\\\c/\\b\\f\\n\\r\\t\\u0001\\u001f\x7f\xc3\xa9\"";
+    struct json_string string;
+    struct json_string read;
+    struct json_write_result res;
+
+    json_string_construct(&string, NULL);
+    CHECK(!json_string_append(&string, chars, sizeof(chars) - 1));
+
+    res = json_write_string(buf, buf + sizeof(buf), &string, NULL);
+    CHECK(!res.ec);
+    CHECK(res.ptr - buf == sizeof(expected) - 1);
+    CHECK(!memcmp(buf, expected, sizeof(expected) - 1));
+
+    json_string_construct(&read, NULL);
+    CHECK(!json_read_string(buf, res.ptr, &read, NULL).ec);
+    CHECK(json_string_size(&read) == sizeof(chars) - 1);
+    CHECK(!memcmp(json_string_data(&read), chars, sizeof(chars) - 1));
+
+    json_string_destruct(&read);
+    json_string_destruct(&string);
+}
+
+static void test_int(void)
+{
+    static const json_int values[] = {
+        0, 9, 10, -1, -10, 99, 100, 12345678, LLONG_MAX, LLONG_MIN,
+    };
+
+    for (json_size i = 0; i < sizeof(values) / sizeof(*values); i++) {
+        struct json_write_result res =
+            json_write_int(buf, buf + sizeof(buf), values[i], NULL);
+        char expected[32];
+        json_size n = sprintf(expected, "%lld", values[i]);
+
+        CHECK(!res.ec);
+        CHECK(res.ptr - buf == n);
+        CHECK(!memcmp(buf, expected, n));
+
+        res = json_write_int(buf, buf + n - 1, values[i], NULL);
+        CHECK(res.ec == JSON_ERRC_NOT_ENOUGH_MEMORY);
+    }
+}
+
+// Written floats are read back as the same double, as floats, and with no
+// more digits than needed.
+static void test_float(void)
+{
+    static const struct {
+        double value;
+        const char *text;
+    } values[] = {
+        { 0.0, "0.0" },
+        { -0.0, "-0.0" },
+        { 1.0, "1.0" },
+        { 0.1, "0.1" },
+        { 1e20, "1e+20" },
+        { 1.0 / 3, "0.3333333333333333" },
+        { 5e-324, "4.94065645841247e-324" },
+        { 2.2250738585072014e-308, "2.2250738585072014e-308" },
+        { DBL_MAX, "1.7976931348623157e+308" },
+        { 9007199254740993.0, "9007199254740992.0" },
+    };
+
+    for (json_size i = 0; i < sizeof(values) / sizeof(*values); i++) {
+        struct json_write_result res =
+            json_write_float(buf, buf + sizeof(buf), values[i].value, NULL);
+        struct json_value value;
+
+        CHECK(!res.ec);
+        CHECK(res.ptr - buf == strlen(values[i].text));
+        CHECK(!memcmp(buf, values[i].text, res.ptr - buf));
+
+        json_value_construct(&value, NULL);
+        CHECK(!json_read_value(buf, res.ptr, &value, NULL).ec);
+        CHECK(json_value_is_float(&value));
+        CHECK((double)*json_value_as_float(&value) == values[i].value);
+        CHECK(!signbit(*json_value_as_float(&value)) ==
+              !signbit(values[i].value));
+        json_value_destruct(&value);
+    }
+
+    CHECK(json_write_float(buf, buf + sizeof(buf), INFINITY, NULL).ec ==
+          JSON_ERRC_NUMBER_OUT_OF_RANGE);
+    CHECK(json_write_float(buf, buf + sizeof(buf), NAN, NULL).ec ==
+          JSON_ERRC_NUMBER_OUT_OF_RANGE);
+}
+
+int main(void)
+{
+    test_object_order();
+    test_indent();
+    test_string();
+    test_int();
+    test_float();
+    return 0;
+}